@@ -17,7 +17,8 @@
 #ifndef __AXOLOTL_BITS_ASSEMBLER_H__
 #define __AXOLOTL_BITS_ASSEMBLER_H__
 
-#include "bits/blob.hpp"
+#include "bits/blob_builder.hpp"
+#include "bits/chunked_buffer.hpp"
 #include "bits/opcodes.hpp"
 #include "core/some.hpp"
 #include "lang/forward.hpp"
@@ -79,7 +80,7 @@ namespace bits
     class Assembler
     {
     public:
-        Assembler(Blob& blob, std::size_t chunk_size = 32);
+        Assembler(BlobBuilder& builder, std::size_t chunk_size = 4096);
         ~Assembler();
 
         void setDebugInfo(std::string const& file);
@@ -90,15 +91,14 @@ namespace bits
         std::size_t pos() const;
 
     private:
-        std::size_t M_write(uint32_t word);
+        std::size_t M_write(uint8_t const* bytes, std::size_t len);
+        std::size_t M_writeOperand(int32_t value);
 
     private:
-        Blob& m_blob;
+        BlobBuilder& m_builder;
 
-        uint32_t* m_raw;
-        std::size_t m_raw_chunk_size;
-        std::size_t m_raw_size;
-        std::size_t m_raw_avail_size;
+        ChunkedBuffer m_text;
+        bool m_finalized;
 
         std::map<std::string, std::size_t> m_labels;
         std::list<std::pair<std::size_t, std::string>> m_label_refs;
@@ -39,6 +39,7 @@ namespace bits
         bool inject(std::size_t pos, std::size_t length);
         bool copy(std::size_t pos, uint8_t* data, std::size_t length);
         uint8_t* raw(std::size_t pos, std::size_t len);
+        uint8_t const* view(std::size_t pos, std::size_t len);
         Buffer* sub(std::size_t pos, std::size_t len);
 
     private:
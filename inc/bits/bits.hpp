@@ -17,7 +17,11 @@
 #include "bits/forward.hpp"
 #include "bits/buffer.hpp"
 #include "bits/basic_buffer.hpp"
+#include "bits/mapped_buffer.hpp"
+#include "bits/chunked_buffer.hpp"
+#include "bits/leb128.hpp"
 #include "bits/opcodes.hpp"
 #include "bits/blob.hpp"
+#include "bits/blob_builder.hpp"
 #include "bits/disassembler.hpp"
 #include "bits/assembler.hpp"
@@ -20,7 +20,8 @@
 #include "bits/buffer.hpp"
 
 #include <string>
-#include <functional>
+#include <iostream>
+#include <vector>
 #include <memory>
 #include <cstdint>
 
@@ -29,8 +30,8 @@ namespace bits
     //! This is 'AXOL' in ASCII
     static constexpr uint32_t BLOB_MAGIC = 0x4C4F5841;
 
-    //! Version 0.1.1
-    static constexpr uint32_t BLOB_VERSION = 0x00010001;
+    //! Version 0.1.4
+    static constexpr uint32_t BLOB_VERSION = 0x00010004;
 
     //! Offset type
     typedef uint32_t blob_off;
@@ -51,7 +52,7 @@ namespace bits
         BLOB_ST_NULL = 0x00,
         //! String section (nul-separated)
         BLOB_ST_STRINGS,
-        //! Code section
+        //! Code section (one byte opcodes followed by signed LEB128 operands)
         BLOB_ST_TEXT,
         //! Symbol section
         BLOB_ST_SYMBOLS,
@@ -87,6 +88,26 @@ namespace bits
         BLOB_SYMB_GLOBAL = 0x02
     };
 
+    //! Holds possible values for blob_constant->c_kind
+    enum blob_cstkind
+    {
+        //! Serialized data (for user classes), c_value is a string table
+        //!   entry offset
+        BLOB_CST_SERIALIZED = 0x00,
+        //! Signed 32-bit integer
+        BLOB_CST_INT,
+        //! Unsigned 64-bit integer
+        BLOB_CST_ULONG,
+        //! Single precision float, stored as its IEEE 754 bits
+        BLOB_CST_FLOAT,
+        //! Boolean, 0 or 1
+        BLOB_CST_BOOL,
+        //! Character
+        BLOB_CST_CHAR,
+        //! String, c_value is a string table entry offset
+        BLOB_CST_STRING
+    };
+
     //! Header of the code image
     struct __attribute__((packed)) blob_hdr
     {
@@ -148,27 +169,38 @@ namespace bits
         blob_len si_argc;
     };
 
-    //! Constant entry
+    //! Constant entry, builtin scalars are stored as binary values
+    //!   and only user classes go through serialization
     struct __attribute__((packed)) blob_constant
     {
         //! Class identifier of the constant data
         blob_long c_classid;
-        //! Serialized data as a string table entry offset
-        blob_off c_serialized;
+        //! Encoding of the constant data
+        blob_cstkind c_kind;
+        //! Constant data, see blob_cstkind
+        blob_long c_value;
     };
 
-    //! Debug header
+    //! Debug header, it is followed by the debug table : a sequence of
+    //!   entries sorted by address, each one stored as four LEB128 values
+    //!   (address delta, signed line delta, column, extent)
     struct __attribute__((packed)) blob_debug_header
     {
         //! File name as a string table entry offset
         blob_off d_file;
         //! Number of entries in the debug table
         blob_len d_count;
+        //! Address of the last entry (to delta-encode the next one)
+        blob_off d_last_addr;
+        //! Line of the last entry (to delta-encode the next one)
+        blob_off d_last_line;
     };
 
-    //! Debug entry
-    struct __attribute__((packed)) blob_debug_entry
+    //! Debug entry, as decoded from the debug table
+    struct blob_debug_entry
     {
+        //! Address of the instruction (as an offset in the text section)
+        blob_off de_addr;
         //! Line in the input stream
         blob_off de_line;
         //! Column in the latter line
@@ -177,16 +209,30 @@ namespace bits
         blob_len de_extent;
     };
 
+    //! A string table entry, as a view on the blob data. It is only
+    //!   valid as long as the blob it was read from.
+    struct blob_string
+    {
+        //! First character of the string (which is nul-terminated)
+        char const* str;
+        //! Length of the string, without the terminating nul
+        blob_len len;
+    };
+
     //! The Blob class represents a binary blob and provides
-    //!   read and write primitives to the underlying buffer / file.
+    //!   read primitives to the underlying buffer / file. Blobs
+    //!   are written with a BlobBuilder.
+    //! The buffer must be contiguous: the location of every section is
+    //!   cached when the blob is created, so that reading an entry never
+    //!   walks the section table nor allocates.
     class Blob
     {
     public:
-        //! Create a new buffer for edition.
+        //! Create an empty blob.
         Blob();
         
         //! Copy constructor, as this object is reference-counter
-        //!   the copied instance will modify the same underlying buffer.
+        //!   the copied instance will read the same underlying buffer.
         Blob(Blob const& cpy);
         
         //! Create a blob using a predefined buffer.
@@ -201,9 +247,26 @@ namespace bits
         //!   a different buffer.
         Blob copy() const;
 
-        bool setModuleName(std::string const& module_name);
+        //! Check that the header and the section table of the blob
+        //!   are consistent with the underlying buffer, this is meant
+        //!   for blobs read from a file.
+        //! \return true if the blob can be used, false otherwise
+        bool check() const;
+
+        //! Write the whole blob (header and sections) to `out'
+        //! \param out The output stream
+        //! \return true if successful, false otherwise
+        bool write(std::ostream& out) const;
+
         std::string moduleName() const;
 
+        //! Get the string at offset `soff' in the string table, without
+        //!   copying it.
+        //! \param soff Offset of the string in the string table
+        //! \param str Output parameter for the string entry
+        //! \return true if successful, false otherwise
+        bool string(blob_off soff, blob_string& str) const;
+
         //! Get the string at offset `soff' in the string table.
         //! \param soff Offset of the string in the string table
         //! \param str Output parameter for the result string
@@ -216,154 +279,142 @@ namespace bits
         //! \return The associated string if success, an empty string otherwise
         std::string string(blob_off soff) const;
 
-        //! Add a new string in the string table. If the string exists,
-        //!   it is not added twice to avoid duplicates.
-        //! \param str The string to add into the string table
-        //! \param sidx Output parameter for the added string index
-        //! \return true if successful, false otherwise
-        bool addString(std::string const& str, blob_off& sidx);
-
-        //! Find a string in the string table.
-        //! \param str The string to find in the string table
-        //! \param soff Optional output parameter for the
-        //!             eventually found string offset
-        //! \return true if found, false otherwise
-        bool findString(std::string const& str, blob_off* soff = nullptr);
-
         //! Get the symbol entry associated with index `symidx'
         //! \param symidx The symbol index
         //! \return The symbol if success, 0 otherwise
-        blob_symbol* symbol(blob_idx symidx) const;
+        blob_symbol const* symbol(blob_idx symidx) const;
 
-        //! Add a symbol entry in the symbol table
-        //! \param name The name of the symbol to add
-        //! \param symidx Optional output parameter for the index of the added symbol
-        //! \return The added symbol if success, 0 otherwise
-        blob_symbol* addSymbol(std::string const& name, blob_idx* symidx = nullptr);
+        //! Get the number of symbol entries.
+        //! \return The number of symbol entries.
+        std::size_t symbolCount() const;
 
         //! Get the type specification entry associated with index `tsidx'
         //! \param tsidx The index of the entry to get
         //! \param tsoff Optional output parameter for the offset of the entry within
         //!              the type specifications section (as entries are of variable size)
         //! \return The added type specification entry
-        blob_typespec* typeSpec(blob_idx tsidx, blob_off* tsoff = nullptr) const;
+        blob_typespec const* typeSpec(blob_idx tsidx, blob_off* tsoff = nullptr) const;
 
         //! Get the number of type specification entries.
         //! \return The number of typespecs entries.
         std::size_t typeSpecCount() const;
 
-        //! Add a new type specification to the blob.
-        //! \param name Name of the type specification to add
-        //! \param tsidx Optional output parameter for the index of the added entry
-        //! \return The added entry if success, 0 otherwise
-        blob_typespec* addTypeSpec(std::string const& name, blob_idx* tsidx = nullptr);
-
-        //! Add a new symbol to a type specification entry.
-        //! \param tsidx The index of the type specification to extend with the new symbol
-        //! \param symidx Index of the symbol to add to the type specification
-        //! \return true if success, false otherwise
-        bool addTypeSpecSymbol(blob_idx tsidx, blob_idx symidx);
-
         //! Access the symbol signature associated with index `sigidx'
         //! \param sigidx The index of the signature entry to access
         //! \param sigoff Optional output parameter for the offset of the entry
         //!               within the symbol signatures section (as entries are of variable size)
         //! \return The signature entry if success, 0 otherwise
-        blob_signature* signature(blob_idx sigidx, blob_off* sigoff = nullptr) const;
+        blob_signature const* signature(blob_idx sigidx, blob_off* sigoff = nullptr) const;
 
         //! Get the number of symbol signature entries in the corresponding section
         //! \return The number of signature entries
         std::size_t signatureCount() const;
 
-        //! Add a new signature entry in the symbol signature section
-        //! \param sigidx Output parameter for the enw entry's index
-        //! \return true if success, false otherwise
-        bool addSignature(blob_idx& sigidx);
-
-        //! Add an argument entry to a symbol signature entry
-        //! \param sigidx The index of the symbol signature to modify
-        //! \param classid The id of the type of the new argument to add
-        //! \return true if success, false otherwise
-        bool addSignatureArgument(blob_idx sigidx, blob_long classid);
-
         //! Get a constant entry from the constant data section
         //! \param ctsidx The index of the constant entry to access
         //! \return The constant entry if success, 0 otherwise
-        blob_constant* constant(blob_idx cstidx) const;
+        blob_constant const* constant(blob_idx cstidx) const;
 
-        //! Add a new constant entry in the constant data section
-        //! \param classid Id of the type of the new constant entry
-        //! \param serialized The constant data to insert in serialized form
-        //! \param cstidx Optional output parameter for the index of the added constant entry
-        //! \return The added constant entry if success, 0 otherwise
-        blob_constant* addConstant(blob_long classid, std::string const& serialized, blob_idx* cstidx = nullptr);
-
-        //! Sets the TEXT section contents wich the given buffer
-        //! \param buffer The buffer to fill the TEXT section with
-        //! \return true if success, false otherwise
-        bool setText(Buffer* buffer);
+        //! Get the number of constant entries.
+        //! \return The number of constant entries.
+        std::size_t constantCount() const;
 
         //! Get a buffer to the TEXT section's contents
         //! \return A buffer pointing to the TEXT section's contents if success, 0 otherwise
         std::shared_ptr<Buffer> text() const;
 
-        blob_debug_header* setDebugHeader(std::string const& file);
-        blob_debug_header* debugHeader() const;
+        blob_debug_header const* debugHeader() const;
 
-        blob_debug_entry* addDebugEntry(blob_off line, blob_off col, blob_len extent, blob_idx* deidx = nullptr);
-        blob_debug_entry* debugEntry(blob_idx deidx) const;
+        //! Find the debug entry of the instruction at `addr'. The table is only
+        //!   decoded up to this address, it is meant for error reporting.
+        //! \param addr Address of the instruction (as an offset in the text section)
+        //! \param entry Output parameter for the found entry
+        //! \return true if found, false otherwise
+        bool debugEntry(blob_off addr, blob_debug_entry& entry) const;
 
         //! Loop over every string in the string table and execute `action'
-        //! \param action The action to execute on every string
-        void foreachString(std::function<void(blob_idx, std::string const&)> const& action) const;
+        //! \param action The action to execute on every string, as
+        //!               action(blob_idx, blob_string const&)
+        template <typename TAction>
+        void foreachString(TAction const& action) const;
 
         //! Loop over every symbol entry and execute `action'
-        //! \param action The action to execute on every symbol
-        void foreachSymbol(std::function<void(blob_idx, blob_symbol*)> const& action) const;
+        //! \param action The action to execute on every symbol, as
+        //!               action(blob_idx, blob_symbol const*)
+        template <typename TAction>
+        void foreachSymbol(TAction const& action) const;
 
         //! Loop over every type specification and execute `action'
-        //! \param action The action to execute on every type specification
-        void foreachTypeSpec(std::function<void(blob_idx, blob_typespec*)> const& action) const;
+        //! \param action The action to execute on every type specification, as
+        //!               action(blob_idx, blob_typespec const*)
+        template <typename TAction>
+        void foreachTypeSpec(TAction const& action) const;
 
         //! Loop over every symbol in a given type specification
         //! \param tsidx The index of the type specification to iterate on
         //! \param action The action to execute on every symbol registered within
-        //!               the type specification of index `tsidx'
+        //!               the type specification of index `tsidx', as action(blob_idx)
         //! \return true if success, false otherwise
-        bool foreachTypeSpecSymbol(blob_idx tsidx, std::function<void(blob_idx)> const& action) const;
+        template <typename TAction>
+        bool foreachTypeSpecSymbol(blob_idx tsidx, TAction const& action) const;
 
         //! Loop over every symbol signature in the symbol signatures section
-        //! \param action The action to execute on every symbol signature
-        void foreachSignature(std::function<void(blob_idx, blob_signature*)> const& action) const;
+        //! \param action The action to execute on every symbol signature, as
+        //!               action(blob_idx, blob_signature const*)
+        template <typename TAction>
+        void foreachSignature(TAction const& action) const;
 
         //! Loop over every argument in a given symbol signature
-        //! \param action The action to execute on every argument of the given signature
+        //! \param action The action to execute on every argument of the given
+        //!               signature, as action(blob_long)
         //! \return true if success, false otherwise
-        bool foreachSignatureArgument(blob_idx sigidx, std::function<void(blob_long)> const& action) const;
+        template <typename TAction>
+        bool foreachSignatureArgument(blob_idx sigidx, TAction const& action) const;
 
         //! Loop over each constant entry in the constant data table
-        //! \param action The action to execute on every constant entry
-        void foreachConstant(std::function<void(blob_idx, blob_constant*)> const& action) const;
+        //! \param action The action to execute on every constant entry, as
+        //!               action(blob_idx, blob_constant const*)
+        template <typename TAction>
+        void foreachConstant(TAction const& action) const;
 
-        void foreachDebugEntry(std::function<void(blob_idx, blob_debug_entry*)> const& action) const;
+        //! Loop over each entry of the debug table
+        //! \param action The action to execute on every (decoded) debug entry, as
+        //!               action(blob_idx, blob_debug_entry const&)
+        template <typename TAction>
+        void foreachDebugEntry(TAction const& action) const;
 
      private:
-        blob_hdr* M_header() const;
-        blob_shdr* M_sectionHeader(blob_idx sidx) const;
-        blob_idx M_sectionIndex(blob_shdr* shdr) const;
-        std::shared_ptr<Buffer> M_sectionData(blob_idx sidx) const;
-        std::shared_ptr<Buffer> M_sectionData(blob_shdr* shdr) const;
-        blob_idx M_findSectionIndex(blob_shtype type) const;
-        blob_shdr* M_findSectionHeader(blob_shtype type) const;
-
-        bool M_createHeader();
-        blob_shdr* M_createSectionHeader(blob_idx* sidx = nullptr);
-        std::shared_ptr<Buffer> M_growSection(blob_idx sidx, blob_len amount, long split = -1);
-        std::shared_ptr<Buffer> M_growSection(blob_shdr* shdr, blob_len amount, long split = -1);
+        //! Location of a section in the buffer
+        struct M_Section
+        {
+            uint8_t const* data;
+            blob_len size;
+        };
+
+        void M_load();
+        blob_hdr const* M_header() const;
+        blob_shdr const* M_sectionHeader(blob_idx sidx) const;
+        M_Section const& M_section(blob_shtype type) const;
+        uint8_t const* M_debugTable(blob_len& size) const;
+
+        //! \return false if the entry runs past the end of the table
+        static bool M_decodeDebugEntry(uint8_t const* table, blob_len size, std::size_t& pos, blob_debug_entry& entry);
 
      private:
         Buffer* m_buffer;
+
+        //! Start of the (contiguous) buffer
+        uint8_t const* m_raw;
+
+        //! Sections, indexed by type
+        M_Section m_sections[BLOB_ST_DEBUG + 1];
+
+        //! Offsets of the variable sized entries
+        std::vector<blob_off> m_tspec_offsets;
+        std::vector<blob_off> m_signature_offsets;
     };
 }
 
+#include "bits/blob_impl.hpp"
+
 #endif // __AXOLOTL_BITS_BLOB_H__
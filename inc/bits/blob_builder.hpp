@@ -0,0 +1,160 @@
+/*  This file is part of Axolotl.
+ *
+ * Axolotl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Axolotl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Axolotl.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __AXOLOTL_BITS_BLOB_BUILDER_H__
+#define __AXOLOTL_BITS_BLOB_BUILDER_H__
+
+#include "bits/blob.hpp"
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <utility>
+
+namespace bits
+{
+    //! The BlobBuilder class accumulates the sections of a blob in
+    //!   separate tables, then serializes them into a flat Blob image
+    //!   in one pass. Strings and constants are interned through a hash
+    //!   index so that adding an entry never scans a section.
+    //! Entries returned by the add* methods are only valid until the
+    //!   next entry of the same kind is added.
+    class BlobBuilder
+    {
+    public:
+        BlobBuilder();
+        ~BlobBuilder();
+
+        //! Set the name of the module defined by the blob
+        //! \param module_name The name of the module
+        //! \return true if successful, false otherwise
+        bool setModuleName(std::string const& module_name);
+
+        //! Add a new string in the string table. If the string exists,
+        //!   it is not added twice to avoid duplicates.
+        //! \param str The string to add into the string table
+        //! \param off Output parameter for the added string offset
+        //! \return true if successful, false otherwise
+        bool addString(std::string const& str, blob_off& off);
+
+        //! Find a string in the string table.
+        //! \param str The string to find in the string table
+        //! \param soff Optional output parameter for the
+        //!             eventually found string offset
+        //! \return true if found, false otherwise
+        bool findString(std::string const& str, blob_off* soff = nullptr) const;
+
+        //! Add a symbol entry in the symbol table
+        //! \param name The name of the symbol to add
+        //! \param symidx Optional output parameter for the index of the added symbol
+        //! \return The added symbol if success, 0 otherwise
+        blob_symbol* addSymbol(std::string const& name, blob_idx* symidx = nullptr);
+
+        //! Add a new type specification.
+        //! \param name Name of the type specification to add
+        //! \param tsidx Optional output parameter for the index of the added entry
+        //! \return The added entry if success, 0 otherwise
+        blob_typespec* addTypeSpec(std::string const& name, blob_idx* tsidx = nullptr);
+
+        //! Add a new symbol to a type specification entry.
+        //! \param tsidx The index of the type specification to extend with the new symbol
+        //! \param symidx Index of the symbol to add to the type specification
+        //! \return true if success, false otherwise
+        bool addTypeSpecSymbol(blob_idx tsidx, blob_idx symidx);
+
+        //! Add a new signature entry
+        //! \param sigidx Output parameter for the new entry's index
+        //! \return true if success, false otherwise
+        bool addSignature(blob_idx& sigidx);
+
+        //! Add an argument entry to a symbol signature entry
+        //! \param sigidx The index of the symbol signature to modify
+        //! \param classid The id of the type of the new argument to add
+        //! \return true if success, false otherwise
+        bool addSignatureArgument(blob_idx sigidx, blob_long classid);
+
+        //! Add a new constant entry, unless an identical one exists. A given
+        //!   class must always be stored with the same kind.
+        //! \param classid Id of the type of the new constant entry
+        //! \param kind Encoding of the constant data
+        //! \param value The constant data, see blob_cstkind
+        //! \param cstidx Optional output parameter for the index of the constant entry
+        //! \return The constant entry if success, 0 otherwise
+        blob_constant* addConstant(blob_long classid, blob_cstkind kind, blob_long value, blob_idx* cstidx = nullptr);
+
+        //! Add a new serialized constant entry, unless an identical one exists
+        //! \param classid Id of the type of the new constant entry
+        //! \param serialized The constant data to insert in serialized form
+        //! \param cstidx Optional output parameter for the index of the constant entry
+        //! \return The constant entry if success, 0 otherwise
+        blob_constant* addConstant(blob_long classid, std::string const& serialized, blob_idx* cstidx = nullptr);
+
+        //! Sets the TEXT section contents with the given buffer
+        //! \param buffer The buffer to fill the TEXT section with
+        //! \return true if success, false otherwise
+        bool setText(Buffer* buffer);
+
+        blob_debug_header* setDebugHeader(std::string const& file);
+
+        //! Append an entry to the debug table, entries must be added
+        //!   by increasing address.
+        //! \param addr Address of the instruction (as an offset in the text section)
+        //! \param line Line of the instruction in the source file
+        //! \param col Column in the latter line
+        //! \param extent Extent of the location
+        //! \return true if success, false otherwise
+        bool addDebugEntry(blob_off addr, blob_off line, blob_off col, blob_len extent);
+
+        //! Serialize every section into a new blob, the builder
+        //!   is left untouched and may be built again.
+        //! \return The built blob
+        Blob build() const;
+
+    private:
+        struct M_ConstantHash
+        {
+            std::size_t operator()(std::pair<blob_long, blob_long> const& key) const;
+        };
+
+        struct M_TypeSpec
+        {
+            blob_typespec header;
+            std::vector<blob_idx> symbols;
+        };
+
+    private:
+        blob_off m_module_name;
+
+        std::string m_strings;
+        std::unordered_map<std::string, blob_off> m_string_index;
+
+        std::vector<blob_symbol> m_symbols;
+        std::vector<M_TypeSpec> m_tspecs;
+        std::vector<std::vector<blob_long>> m_signatures;
+
+        std::vector<blob_constant> m_constants;
+        std::unordered_map<std::pair<blob_long, blob_long>, blob_idx, M_ConstantHash> m_constant_index;
+
+        bool m_has_text;
+        std::vector<uint8_t> m_text;
+
+        bool m_has_debug;
+        blob_debug_header m_debug_header;
+        std::vector<uint8_t> m_debug_table;
+    };
+}
+
+#endif // __AXOLOTL_BITS_BLOB_BUILDER_H__
@@ -0,0 +1,141 @@
+/*  This file is part of Axolotl.
+ *
+ * Axolotl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Axolotl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Axolotl.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef __AXOLOTL_BITS_BLOB_IMPL_H__
+#define __AXOLOTL_BITS_BLOB_IMPL_H__
+
+#include <cstring>
+
+namespace bits
+{
+    template <typename TAction>
+    void Blob::foreachString(TAction const& action) const
+    {
+        M_Section const& strings = M_section(BLOB_ST_STRINGS);
+
+        for (std::size_t pos = 0; pos < strings.size;)
+        {
+            blob_string str;
+            if (!string((blob_off) pos, str))
+                break;
+
+            action((blob_idx) pos, str);
+            pos += str.len + 1;
+        }
+    }
+
+    template <typename TAction>
+    void Blob::foreachSymbol(TAction const& action) const
+    {
+        M_Section const& symbols = M_section(BLOB_ST_SYMBOLS);
+
+        blob_symbol const* syms = (blob_symbol const*) symbols.data;
+        std::size_t count = symbols.size / sizeof(blob_symbol);
+        for (std::size_t i = 0; i < count; ++i)
+            action((blob_idx) i, syms + i);
+    }
+
+    template <typename TAction>
+    void Blob::foreachTypeSpec(TAction const& action) const
+    {
+        M_Section const& tspecs = M_section(BLOB_ST_TSPECS);
+
+        for (std::size_t i = 0; i < m_tspec_offsets.size(); ++i)
+            action((blob_idx) i, (blob_typespec const*) (tspecs.data + m_tspec_offsets[i]));
+    }
+
+    template <typename TAction>
+    bool Blob::foreachTypeSpecSymbol(blob_idx tsidx, TAction const& action) const
+    {
+        blob_off tsoff;
+        blob_typespec const* tspec = typeSpec(tsidx, &tsoff);
+        if (!tspec)
+            return false;
+
+        uint8_t const* symbols = (uint8_t const*) (tspec + 1);
+        for (std::size_t i = 0; i < tspec->ts_symbols; ++i)
+        {
+            blob_idx symidx;
+            std::memcpy(&symidx, symbols + i * sizeof(blob_idx), sizeof(blob_idx));
+            action(symidx);
+        }
+
+        return true;
+    }
+
+    template <typename TAction>
+    void Blob::foreachSignature(TAction const& action) const
+    {
+        M_Section const& signatures = M_section(BLOB_ST_SIGNATURES);
+
+        for (std::size_t i = 0; i < m_signature_offsets.size(); ++i)
+            action((blob_idx) i, (blob_signature const*) (signatures.data + m_signature_offsets[i]));
+    }
+
+    template <typename TAction>
+    bool Blob::foreachSignatureArgument(blob_idx sigidx, TAction const& action) const
+    {
+        blob_signature const* sig = signature(sigidx);
+        if (!sig)
+            return false;
+
+        uint8_t const* args = (uint8_t const*) (sig + 1);
+        for (std::size_t i = 0; i < sig->si_argc; ++i)
+        {
+            blob_long classid;
+            std::memcpy(&classid, args + i * sizeof(blob_long), sizeof(blob_long));
+            action(classid);
+        }
+
+        return true;
+    }
+
+    template <typename TAction>
+    void Blob::foreachConstant(TAction const& action) const
+    {
+        M_Section const& constants = M_section(BLOB_ST_CONSTANTS);
+
+        blob_constant const* csts = (blob_constant const*) constants.data;
+        std::size_t count = constants.size / sizeof(blob_constant);
+        for (std::size_t i = 0; i < count; ++i)
+            action((blob_idx) i, csts + i);
+    }
+
+    template <typename TAction>
+    void Blob::foreachDebugEntry(TAction const& action) const
+    {
+        blob_debug_header const* header = debugHeader();
+        if (!header)
+            return;
+
+        blob_len size;
+        uint8_t const* table = M_debugTable(size);
+        if (!table)
+            return;
+
+        blob_debug_entry entry = { 0, 0, 0, 0 };
+        std::size_t pos = 0;
+        for (blob_idx i = 0; i < header->d_count; ++i)
+        {
+            if (!M_decodeDebugEntry(table, size, pos, entry))
+                break;
+            action(i, (blob_debug_entry const&) entry);
+        }
+    }
+}
+
+#endif // __AXOLOTL_BITS_BLOB_IMPL_H__
@@ -27,6 +27,7 @@ namespace bits
     class Buffer
     {
     public:
+        Buffer() : refcount(0) {}
         virtual ~Buffer() {}
 
         //! Create a clone of this buffer
@@ -72,6 +73,13 @@ namespace bits
         //! \param len Length of the buffer to extract
         //! \return The extracted buffer if success, 0 otherwise
         virtual uint8_t* raw(std::size_t pos, std::size_t len) = 0;
+
+        //! Get a read-only contiguous buffer to a portion of this buffer,
+        //!   unlike raw() it is available on read-only buffers too
+        //! \param pos The start position of the raw buffer to get
+        //! \param len Length of the buffer to extract
+        //! \return The extracted buffer if success, 0 otherwise
+        virtual uint8_t const* view(std::size_t pos, std::size_t len) = 0;
         
         //! Get a sub-buffer starting at positon `pos' and of size `len' bytes
         //! The returned buffer will no longer be valid after deletion of this object
@@ -0,0 +1,72 @@
+/*  This file is part of Axolotl.
+ *
+ * Axolotl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Axolotl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Axolotl.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef __AXOLOTL_BITS_CHUNKED_BUFFER_H__
+#define __AXOLOTL_BITS_CHUNKED_BUFFER_H__
+
+#include "bits/buffer.hpp"
+
+#include <vector>
+
+namespace bits
+{
+    //! This class implements the abstract Buffer interface
+    //!   using a list of chunks, injecting a portion only moves
+    //!   the bytes of one chunk. Chunks are joined when a raw
+    //!   pointer is requested over several of them, which is why
+    //!   it is meant for buffers under construction.
+    class ChunkedBuffer : public Buffer
+    {
+    public:
+        //! \param chunk_size Size in bytes up to which a chunk
+        //!                   is grown instead of being split
+        ChunkedBuffer(std::size_t chunk_size = 4096);
+        ~ChunkedBuffer();
+
+        //! The copy is a (contiguous) BasicBuffer
+        Buffer* copy() const;
+        bool readonly() const;
+        std::size_t size() const;
+        uint8_t at(std::size_t i) const;
+        uint8_t& at(std::size_t i);
+        bool inject(std::size_t pos, std::size_t length);
+        bool copy(std::size_t pos, uint8_t* data, std::size_t length);
+        uint8_t* raw(std::size_t pos, std::size_t len);
+        uint8_t const* view(std::size_t pos, std::size_t len);
+        Buffer* sub(std::size_t pos, std::size_t len);
+
+    private:
+        class Slice;
+
+        std::size_t M_find(std::size_t pos) const;
+        void M_join(std::size_t first, std::size_t last);
+        void M_index(std::size_t from);
+
+    private:
+        std::size_t m_chunk_size;
+        std::size_t m_size;
+        std::vector<std::vector<uint8_t>> m_chunks;
+        //! Offset of each chunk in the buffer
+        std::vector<std::size_t> m_offsets;
+        //! Chunk found by the last lookup
+        mutable uint8_t* m_window;
+        mutable std::size_t m_window_start;
+        mutable std::size_t m_window_size;
+    };
+}
+
+#endif // __AXOLOTL_BITS_CHUNKED_BUFFER_H__
@@ -33,12 +33,14 @@ namespace bits
         void dumpSymbols();
         void dumpTypeSpecs();
         void dumpConstants();
+        void dumpDebug();
         void dumpText();
 
         bool functionAt(int pc, std::string& name, int& offset);
 
     private:
         void M_dumpSignature(blob_idx sigidx);
+        std::string M_constantValue(blob_constant const* cst) const;
 
     private:
         Blob const& m_blob;
@@ -21,11 +21,14 @@ namespace bits
 {
     class Buffer;
     class BasicBuffer;
+    class MappedBuffer;
+    class ChunkedBuffer;
     struct blob_hdr;
     struct blob_shdr;
     struct blob_symbol;
     struct blob_typespec;
     class Blob;
+    class BlobBuilder;
     class Disassembler;
     class Assembler;
 }
@@ -0,0 +1,141 @@
+/*  This file is part of Axolotl.
+ *
+ * Axolotl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Axolotl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Axolotl.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __AXOLOTL_BITS_LEB128_H__
+#define __AXOLOTL_BITS_LEB128_H__
+
+#include <cstdint>
+#include <cstddef>
+
+namespace bits
+{
+    //! Maximum size in bytes of a LEB128-encoded 32 bits value
+    static constexpr std::size_t LEB128_MAX = 5;
+
+    //! Encode an unsigned value in LEB128 form.
+    //! \param value The value to encode
+    //! \param out Output buffer, at least LEB128_MAX bytes long
+    //! \return The number of bytes written
+    static inline std::size_t uleb128_encode(uint32_t value, uint8_t* out)
+    {
+        std::size_t len = 0;
+        do
+        {
+            uint8_t byte = value & 0x7F;
+            value >>= 7;
+            if (value)
+                byte |= 0x80;
+            out[len++] = byte;
+        } while (value);
+
+        return len;
+    }
+
+    //! Encode a signed value in LEB128 form.
+    //! \param value The value to encode
+    //! \param out Output buffer, at least LEB128_MAX bytes long
+    //! \return The number of bytes written
+    static inline std::size_t sleb128_encode(int32_t value, uint8_t* out)
+    {
+        std::size_t len = 0;
+        bool more = true;
+        while (more)
+        {
+            uint8_t byte = value & 0x7F;
+            value >>= 7;
+            if ((value == 0 && !(byte & 0x40)) || (value == -1 && (byte & 0x40)))
+                more = false;
+            else
+                byte |= 0x80;
+            out[len++] = byte;
+        }
+
+        return len;
+    }
+
+    //! Encode a signed value in LEB128 form, padded to exactly LEB128_MAX bytes
+    //!   so that it can be patched later on (e.g. for label references).
+    //! \param value The value to encode
+    //! \param out Output buffer, at least LEB128_MAX bytes long
+    //! \return The number of bytes written (always LEB128_MAX)
+    static inline std::size_t sleb128_encode_padded(int32_t value, uint8_t* out)
+    {
+        uint32_t bits = (uint32_t) value;
+        for (std::size_t i = 0; i < LEB128_MAX - 1; ++i)
+        {
+            out[i] = (bits & 0x7F) | 0x80;
+            bits = (uint32_t) (value >> (7 * (i + 1)));
+        }
+        out[LEB128_MAX - 1] = bits & 0x7F;
+
+        return LEB128_MAX;
+    }
+
+    //! Decode an unsigned LEB128 value.
+    //! \param in Input buffer
+    //! \param pos Position of the value in `in', advanced past it
+    //! \param end End of the input buffer
+    //! \param value The decoded value
+    //! \return false if the value runs past `end' or is longer than LEB128_MAX bytes
+    static inline bool uleb128_decode(uint8_t const* in, std::size_t& pos, uint8_t const* end, uint32_t& value)
+    {
+        value = 0;
+        for (std::size_t i = 0; i < LEB128_MAX; ++i)
+        {
+            if (in + pos >= end)
+                return false;
+
+            uint8_t byte = in[pos++];
+            value |= (uint32_t) (byte & 0x7F) << (7 * i);
+            if (!(byte & 0x80))
+                return true;
+        }
+
+        return false;
+    }
+
+    //! Decode a signed LEB128 value.
+    //! \param in Input buffer
+    //! \param pos Position of the value in `in', advanced past it
+    //! \param end End of the input buffer
+    //! \param value The decoded value
+    //! \return false if the value runs past `end' or is longer than LEB128_MAX bytes
+    static inline bool sleb128_decode(uint8_t const* in, std::size_t& pos, uint8_t const* end, int32_t& value)
+    {
+        uint32_t bits = 0;
+        for (std::size_t i = 0; i < LEB128_MAX; ++i)
+        {
+            if (in + pos >= end)
+                return false;
+
+            uint8_t byte = in[pos++];
+            bits |= (uint32_t) (byte & 0x7F) << (7 * i);
+            if (!(byte & 0x80))
+            {
+                std::size_t shift = 7 * (i + 1);
+                if (shift < 32 && (byte & 0x40))
+                    bits |= ~((uint32_t) 0) << shift;
+
+                value = (int32_t) bits;
+                return true;
+            }
+        }
+
+        return false;
+    }
+}
+
+#endif // __AXOLOTL_BITS_LEB128_H__
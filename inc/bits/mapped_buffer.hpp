@@ -0,0 +1,84 @@
+/*  This file is part of Axolotl.
+ *
+ * Axolotl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Axolotl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Axolotl.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef __AXOLOTL_BITS_MAPPED_BUFFER_H__
+#define __AXOLOTL_BITS_MAPPED_BUFFER_H__
+
+#include "bits/buffer.hpp"
+
+#include <string>
+#include <memory>
+
+namespace bits
+{
+    //! This class implements the abstract Buffer interface
+    //!   over a read-only mapping of a file, pages are loaded
+    //!   on demand and shared between processes
+    class MappedBuffer : public Buffer
+    {
+    public:
+        MappedBuffer();
+        ~MappedBuffer();
+
+        //! Map `length' bytes of a file starting at `offset'
+        //! \param file The path of the file to map
+        //! \param offset Start of the buffer in the file
+        //! \param length Length in bytes of the buffer
+        //! \return true if success, false otherwise (the buffer is then empty)
+        bool open(std::string const& file, std::size_t offset, std::size_t length);
+
+        //! Map a whole file
+        //! \param file The path of the file to map
+        //! \return true if success, false otherwise (the buffer is then empty)
+        bool open(std::string const& file);
+
+        //! The copy is a BasicBuffer, which can be modified
+        Buffer* copy() const;
+        bool readonly() const;
+        std::size_t size() const;
+        uint8_t at(std::size_t i) const;
+        //! Throws, the mapping can't be modified
+        uint8_t& at(std::size_t i);
+        bool inject(std::size_t pos, std::size_t length);
+        bool copy(std::size_t pos, uint8_t* data, std::size_t length);
+        //! Always fails, use view() instead
+        uint8_t* raw(std::size_t pos, std::size_t len);
+        uint8_t const* view(std::size_t pos, std::size_t len);
+        //! Sub-buffers share the mapping, they stay valid after
+        //!   the deletion of this object
+        Buffer* sub(std::size_t pos, std::size_t len);
+
+    private:
+        struct Mapping
+        {
+            void* addr;
+            std::size_t length;
+
+            ~Mapping();
+        };
+
+    private:
+        bool M_map(int fd, std::size_t offset, std::size_t length);
+
+    private:
+        std::shared_ptr<Mapping> m_mapping;
+        uint8_t* m_raw;
+        std::size_t m_size;
+    };
+}
+
+#endif // __AXOLOTL_BITS_MAPPED_BUFFER_H__
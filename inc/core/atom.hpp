@@ -0,0 +1,69 @@
+#ifndef __AXOLOTL_CORE_ATOM_H__
+#define __AXOLOTL_CORE_ATOM_H__
+
+#include <string>
+#include <cstdint>
+#include <functional>
+
+namespace core
+{
+    //! Interned name, used as the key of members and globals
+    //! Every distinct string is given a single id for the whole process,
+    //!   the table is shared by every runtime rather than owned by one.
+    //!   Comparing and hashing atoms only involves that integer. Building
+    //!   an atom from a new string locks the atom table, hot paths keep
+    //!   their atoms around anyway (see vm::Module::atom).
+    class Atom
+    {
+    public:
+        typedef uint32_t Id;
+
+    public:
+        constexpr Atom() : m_id(0) {}
+        Atom(std::string const& name);
+        Atom(char const* name);
+
+        Id id() const;
+        std::string const& name() const;
+
+        bool operator==(Atom const& other) const;
+        bool operator!=(Atom const& other) const;
+        bool operator<(Atom const& other) const;
+
+        //! Atom of a name interned when the table was created
+        //!   (see lang::std_atom_names)
+        static constexpr Atom builtin(Id id) { return Atom(id, true); }
+        //! Number of names interned so far
+        static std::size_t count();
+
+    private:
+        constexpr Atom(Id id, bool) : m_id(id) {}
+
+    private:
+        Id m_id;
+    };
+
+    inline Atom::Id Atom::id() const
+    { return m_id; }
+
+    inline bool Atom::operator==(Atom const& other) const
+    { return m_id == other.m_id; }
+
+    inline bool Atom::operator!=(Atom const& other) const
+    { return m_id != other.m_id; }
+
+    inline bool Atom::operator<(Atom const& other) const
+    { return m_id < other.m_id; }
+}
+
+namespace std
+{
+    template <>
+    struct hash<core::Atom>
+    {
+        std::size_t operator()(core::Atom const& atom) const
+        { return atom.id(); }
+    };
+}
+
+#endif // __AXOLOTL_CORE_ATOM_H__
@@ -53,6 +53,9 @@ namespace core
         //! Build a scripted callable object
         Callable(ScriptedMetaType const& scripted);
 
+        //! Build a native callable object from a callback
+        Callable(NativeMetaType const& native);
+
         //! Build a native callable object from a std::function
         template <typename TRet, typename... TArgs>
         Callable(std::function<TRet(TArgs...)> const& fun, bool variadic = false)
@@ -28,14 +28,18 @@ namespace core
     Object CallbackImpl<TRet, TArgs...>::invoke(std::vector<Object> args)
     {   
         if (this->m_variadic)
+        {
+            thaw_all(args);
             args = { args };
+        }
         else if (sizeof...(TArgs) != args.size())
         {
             throw InternalError("CallbackImpl::invoke: wrong number of arguments");
             // throw std::runtime_error("wrong number of arguments");
         }
 
-        std::tuple<typename std::remove_reference<TArgs>::type&...> tp = vec2tuple(args.begin(), (typename std::remove_reference<TArgs>::type*)nullptr...);
+        ThawArgs<TArgs...>::thaw(args.begin());
+        std::tuple<access_type<TArgs>&...> tp = vec2tuple(args.begin(), (access_type<TArgs>*) nullptr...);
         return construct(applyTuple(this->m_fun, tp));
     }
 
@@ -52,14 +56,18 @@ namespace core
     Object CallbackImpl<void, TArgs...>::invoke(std::vector<Object> args)
     {
         if (this->m_variadic)
+        {
+            thaw_all(args);
             args = { args };
+        }
         else  if (sizeof...(TArgs) != args.size())
         {
             throw InternalError("CallbackImpl::invoke: wrong number of arguments");
             // throw std::runtime_error("wrong number of arguments");
         }
 
-        std::tuple<typename std::remove_reference<TArgs>::type&...> tp = vec2tuple(args.begin(), (typename std::remove_reference<TArgs>::type*) nullptr...);
+        ThawArgs<TArgs...>::thaw(args.begin());
+        std::tuple<access_type<TArgs>&...> tp = vec2tuple(args.begin(), (access_type<TArgs>*) nullptr...);
         applyTuple(this->m_fun, tp);
 
         return Object::nil();
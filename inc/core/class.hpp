@@ -19,6 +19,7 @@
 
 #include "core/forward.hpp"
 #include "core/some.hpp"
+#include "core/atom.hpp"
 
 #include <string>
 #include <list>
@@ -31,7 +32,7 @@ namespace core
     {
     public:
         typedef std::size_t Id;
-        typedef std::pair<std::string, Object> Member;
+        typedef std::pair<Atom, Object> Member;
 
         static Id AnyId;
         static Class AnyClass;
@@ -45,7 +46,7 @@ namespace core
 
         Id classid() const;
         std::string const& classname() const;
-        void addMember(std::string const& name, Object value);
+        void addMember(Atom const& name, Object value);
 
         Object construct(Some&& value = Some()) const;
         Object unserialize(std::string const& serialized) const;
@@ -63,6 +64,8 @@ namespace core
         {
             Id classid;
             std::string classname;
+            //! Name of the constructors
+            Atom classname_atom;
             std::list<Member> members;
             bool in_script;
             int refcount;
@@ -15,6 +15,7 @@
  */
 
 #include "core/forward.hpp"
+#include "core/atom.hpp"
 #include "core/some.hpp"
 #include "core/callable.hpp"
 #include "core/signature.hpp"
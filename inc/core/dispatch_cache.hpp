@@ -0,0 +1,82 @@
+#ifndef __AXOLOTL_CORE_DISPATCH_CACHE_H__
+#define __AXOLOTL_CORE_DISPATCH_CACHE_H__
+
+#include "core/atom.hpp"
+#include "core/class.hpp"
+#include "core/object.hpp"
+
+#include <vector>
+#include <cstdint>
+
+namespace core
+{
+    namespace detail
+    {
+        //! Runtime-wide cache of the polymorphic lookups, shared by every
+        //!   caller of Object::findPolymorphic and by the constructors
+        //!   of the native classes
+        //! Entries are keyed by the receiver's class id, the member name
+        //!   and the class ids of the arguments. The table is direct-mapped,
+        //!   a colliding lookup simply replaces the previous entry.
+        //! Changing the members of a class (Class::addMember) invalidates
+        //!   the whole table, the members of an instance may differ from
+        //!   the ones of its class though, so the callers check the hits
+        //!   against the receiver (see Entry::stamp).
+        class DispatchCache
+        {
+        public:
+            //! Lookups with more arguments are not cached
+            static constexpr std::size_t MAX_ARGS = 4;
+            static constexpr std::size_t SIZE = 1024;
+
+            enum Kind
+            {
+                MEMBER,
+                CONSTRUCTOR
+            };
+
+            struct Key
+            {
+                Class::Id classid;
+                Atom::Id name;
+                uint16_t kind;
+                uint16_t argc;
+                Class::Id args[MAX_ARGS];
+
+                bool operator==(Key const& other) const;
+            };
+
+            struct Entry
+            {
+                Key key;
+                std::size_t generation;
+                //! Caller defined data used to check a hit, e.g. the
+                //!   number of candidates and the position of the match
+                uint64_t stamp;
+                Object fun;
+            };
+
+        public:
+            //! Build the key of a lookup
+            //! \return False if the lookup can't be cached
+            static bool key(Kind kind, Class::Id classid, Atom const& name,
+                            std::vector<Object> const& args, Key& key);
+
+            //! \return The entry of a key, or nullptr if it is not cached
+            static Entry const* find(Key const& key);
+            static void store(Key const& key, uint64_t stamp, Object const& fun);
+
+            //! Drop every entry, called when the members of a class change
+            static void invalidate();
+
+        private:
+            static std::size_t M_hash(Key const& key);
+            static Entry* M_table();
+
+        private:
+            static std::size_t m_generation;
+        };
+    }
+}
+
+#endif // __AXOLOTL_CORE_DISPATCH_CACHE_H__
@@ -19,6 +19,7 @@
 
 namespace core
 {
+    class Atom;
     class Some;
     class Callable;
     class Signature;
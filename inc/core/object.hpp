@@ -19,15 +19,25 @@
 
 #include "core/some.hpp"
 #include "core/class.hpp"
+#include "core/atom.hpp"
 
 #include <vector>
 #include <string>
 #include <map>
 
+namespace vm
+{
+    class Jit;
+}
+
 namespace core
 {
     class Object
     {
+        friend class Class;
+        //! Native code handles objects and their instances directly
+        friend class vm::Jit;
+
     public:
         Object();
         Object(Object const& cpy, bool weaken = false);
@@ -45,6 +55,13 @@ namespace core
         Object weakref() const;
         Object copy() const;
 
+        //! Frozen objects are shared between all their uses (e.g. constants)
+        //!   and must not be mutated in place, thawed() gives back a private
+        //!   copy of them (or the object itself if it is not frozen).
+        bool frozen() const;
+        void freeze();
+        Object thawed() const;
+
         Some const& meta() const;
 
         bool pending() const;
@@ -56,17 +73,21 @@ namespace core
         std::string classname() const;
         Class::Id classid() const;
 
-        bool has(std::string const& id) const;
-        bool isPolymorphic(std::string const& id) const;
-        Object& newPolymorphic(std::string const& id);
-        Object findPolymorphic(std::string const& id, std::vector<Object> const& args) const;
-
-        Object& member(std::string const& id);
-        Object const& member(std::string const& id) const;
-        Object invokeMember(std::string const& name, std::vector<Object> const& args) const;
-        Object invokePolymorphic(std::string const& name, std::vector<Object> const& args) const;
+        bool has(Atom const& id) const;
+        bool isPolymorphic(Atom const& id) const;
+        Object& newPolymorphic(Atom const& id);
+        Object findPolymorphic(Atom const& id, std::vector<Object> const& args) const;
+        //! Whether a method of this object may differ from the one of its
+        //!   class, i.e. an overload was added or a method was assigned
+        //!   since it was constructed (see CALL_SYMBOL)
+        bool overridden() const;
+
+        Object& member(Atom const& id);
+        Object const& member(Atom const& id) const;
+        Object invokeMember(Atom const& name, std::vector<Object> const& args) const;
+        Object invokePolymorphic(Atom const& name, std::vector<Object> const& args) const;
         Object invoke(std::vector<Object> const& args) const;
-        Object method(std::string const& name, std::vector<Object> const& args) const;
+        Object method(Atom const& name, std::vector<Object> const& args) const;
 
         template <typename T>
         T& unwrap();
@@ -96,11 +117,17 @@ namespace core
 
         static Object nil();
 
+        //! Bind all the objects created before their type was associated.
+        //! This is the second phase of the builtins registration (see lib::recordAll),
+        //!   after it no pending object can be created anymore and all nil objects
+        //!   share the same instance.
+        static void bindPending();
+
     private:
         void M_incref();
         void M_decref();
         void M_destroy();
-        void M_fixPending() const;
+        void M_bind();
 
     private:
         bool m_weak;
@@ -108,16 +135,18 @@ namespace core
         {
             Some meta;
             Class the_class;
-            std::multimap<std::string, Object> members;
+            std::multimap<Atom, Object> members;
             int refcount;
+            bool frozen;
+            bool overridden;
 
             bool pending;
             std::size_t pending_type_id;
         }* m_impl;
 
     private:
-        static Object m_nil;
-        static bool m_nil_inited;
+        static Impl* m_nil_impl;
+        static std::vector<Object>* m_pending;
     };
 }
 
@@ -59,24 +59,80 @@ namespace core
     inline Object& unwrap_object(Object& object, Object const*)
     { return object; }
 
+    // Shared read access, the payload is not detached
+    template <typename T>
+    inline T const& unwrap_object(Object& object, T const*,
+                                  typename std::enable_if<
+                                      not std::is_same<T, Object>::value
+                                  >::type* dummy = nullptr)
+    { return static_cast<Object const&>(object).unwrap<T>(); }
+
+    // Exclusive write access, the payload is detached if it is shared
     template <typename T>
     inline T& unwrap_object(Object& object, T*,
                             typename std::enable_if<
-                                not std::is_same<
-                                    typename std::remove_const<T>::type,
-                                    Object
-                                >::value
+                                not std::is_same<T, Object>::value and
+                                not std::is_const<T>::value
                             >::type* dummy = nullptr)
     { return object.unwrap<T>(); }
 
+    //! Natives only get write access to the arguments they take by non-const
+    //!   reference, others (by value or by const reference) are only read.
+    template <typename A>
+    using access_type = typename std::conditional<
+        std::is_lvalue_reference<A>::value and not std::is_const<typename std::remove_reference<A>::type>::value,
+        typename std::remove_reference<A>::type,
+        typename std::remove_reference<A>::type const
+    >::type;
+
     template <typename A, typename... Args>
     static std::tuple<A&, Args&...> vec2tuple(std::vector<Object>::iterator it, A*, Args*... args)
     {
-        std::tuple<A&> first = std::tie(unwrap_object(*it, (A*) nullptr));
+        std::tuple<A&> first(unwrap_object(*it, (A*) nullptr));
         std::tuple<Args&...> second = vec2tuple(++it, args...);
         return std::tuple_cat(first, second);
     }
 
+    // Natives that can mutate (through a non-const reference) or keep
+    //   (as an Object) one of their arguments must get a private copy of it
+    //   if it is frozen
+    template <typename A>
+    struct needs_thawing
+    : std::integral_constant<bool,
+        std::is_same<typename std::remove_const<typename std::remove_reference<A>::type>::type, Object>::value ||
+        (std::is_lvalue_reference<A>::value && not std::is_const<typename std::remove_reference<A>::type>::value)
+    > {};
+
+    template <typename... Args>
+    struct ThawArgs;
+
+    template <>
+    struct ThawArgs<>
+    {
+        static inline void thaw(std::vector<Object>::iterator)
+        {}
+    };
+
+    template <typename A, typename... Args>
+    struct ThawArgs<A, Args...>
+    {
+        static inline void thaw(std::vector<Object>::iterator it)
+        {
+            if (needs_thawing<A>::value && it->frozen())
+                *it = it->copy();
+            ThawArgs<Args...>::thaw(++it);
+        }
+    };
+
+    static inline void thaw_all(std::vector<Object>& args)
+    {
+        for (auto& arg : args)
+        {
+            if (arg.frozen())
+                arg = arg.copy();
+        }
+    }
+
     static std::vector<Object> pack2vec()
     { return std::vector<Object>(); }
 
@@ -20,10 +20,22 @@
 #include <type_traits>
 #include <tuple>
 
+namespace vm
+{
+    class Jit;
+}
+
 namespace core
 {
+    //! Type-erased value holder.
+    //! The held value is reference counted and copied on write : copying a Some
+    //!   is O(1), and the value is duplicated by the first mutable access
+    //!   through as<T>() while it is shared.
     class Some
     {
+        //! Native code checks the type of values by their vtable
+        friend class vm::Jit;
+
     public:
         Some()
             : m_data{nullptr}
@@ -35,7 +47,11 @@ namespace core
         {}
 
         Some(Some const& cpy)
-        { m_data = cpy.m_data ? cpy.m_data->copy() : nullptr; }
+        {
+            m_data = cpy.m_data;
+            if (m_data)
+                ++m_data->refcount;
+        }
 
         Some(Some&& tmp)
         {
@@ -48,9 +64,11 @@ namespace core
 
         Some& operator=(Some const& cpy)
         {
+            if (cpy.m_data)
+                ++cpy.m_data->refcount;
             clear();
 
-            m_data = cpy.m_data ? cpy.m_data->copy() : nullptr;
+            m_data = cpy.m_data;
             return *this;
         }
 
@@ -64,17 +82,25 @@ namespace core
         }
 
         Some copy() const
-        { return Some{m_data ? m_data->copy() : nullptr}; }
+        {
+            Some cpy;
+            cpy.m_data = m_data ? m_data->copy() : nullptr;
+            return cpy;
+        }
 
         void clear()
         {
             if(!m_data)
                 return;
 
-            delete m_data;
+            if (!--m_data->refcount)
+                delete m_data;
             m_data = nullptr;
         }
 
+        bool shared() const
+        { return m_data && m_data->refcount > 1; }
+
         bool empty() const
         { return !m_data; }
 
@@ -97,12 +123,26 @@ namespace core
 
         template <typename T>
         T& as()
-        { return dynamic_cast<Data<typename std::remove_const<T>::type>&>(*m_data).get(); }
+        {
+            M_detach();
+            return dynamic_cast<Data<typename std::remove_const<T>::type>&>(*m_data).get();
+        }
 
         template <typename T>
         T const& as() const
         { return dynamic_cast<Data<typename std::remove_const<T>::type>&>(*m_data).get(); }
 
+    private:
+        void M_detach()
+        {
+            if (!shared())
+                return;
+
+            Base* data = m_data->copy();
+            --m_data->refcount;
+            m_data = data;
+        }
+
     private:
         template <typename T>
         class Type
@@ -119,12 +159,14 @@ namespace core
         class Base
         {
         public:
-            Base() {}
+            Base() : refcount(1) {}
             virtual ~Base() {}
 
             virtual bool is(size_t) const = 0;
             virtual size_t id() const = 0;
             virtual Base* copy() const = 0;
+
+            int refcount;
         };
 
         template <typename T>
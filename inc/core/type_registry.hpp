@@ -6,7 +6,7 @@
 #include "core/class.hpp"
 #include "core/exception.hpp"
 
-#include <map>
+#include <unordered_map>
 #include <string>
 #include <stdexcept>
 
@@ -25,7 +25,17 @@ namespace core
         static inline std::size_t uniqueTypeId()
         { return reinterpret_cast<std::size_t>(&UniqueTypeIdHelper<unqualified<T>>::helper); }
 
-        extern std::map<std::size_t, Class>* type_registry;
+        //! Classes associated with C++ types, by type id
+        typedef std::unordered_map<std::size_t, Class> TypeRegistry;
+        extern TypeRegistry* type_registry;
+
+        //! Reverse index of the type registry, by class id (entries of
+        //!   an unordered_map are never moved so they can be pointed to)
+        typedef std::unordered_map<Class::Id, TypeRegistry::value_type const*> ClassRegistry;
+        extern ClassRegistry* class_registry;
+
+        //! Set once all builtin types are associated (see Object::bindPending)
+        extern bool type_registry_sealed;
     }
 
     static inline Class const& associate(std::size_t typeId, Class const& c)
@@ -37,7 +47,10 @@ namespace core
             // throw std::runtime_error("core::associate: type is already associated with class `" + it->second.classname() + "'");
         }
 
-        detail::type_registry->insert(std::make_pair(typeId, c));
+        auto inserted = detail::type_registry->insert(std::make_pair(typeId, c));
+
+        // The first type associated with a class id is the one it maps to
+        detail::class_registry->insert(std::make_pair(c.classid(), &*inserted.first));
         return c;
     }
 
@@ -59,15 +72,19 @@ namespace core
 
     template <typename T>
     static inline Class const& type_class()
-    { return type_class(detail::uniqueTypeId<T>()); }
+    {
+        // A type is never associated twice and registry entries never
+        //   move, so the lookup is only done once per type (if it throws,
+        //   the slot is initialized on the next call)
+        static Class const& slot = type_class(detail::uniqueTypeId<T>());
+        return slot;
+    }
 
     static inline std::size_t class_type(Class::Id classid)
     {
-        for (auto it : *detail::type_registry)
-        {
-            if (it.second.classid() == classid)
-                return it.first;
-        }
+        auto it = detail::class_registry->find(classid);
+        if (it != detail::class_registry->end())
+            return it->second->first;
 
         throw InternalError("core::classType: class is not associated with a type");
         // throw std::runtime_error("core::classType: class is not associated with a type");
@@ -78,11 +95,9 @@ namespace core
 
     static inline Class const& class_from_classid(Class::Id const& classid)
     {
-        for (auto const& it : *detail::type_registry)
-        {
-            if (it.second.classid() == classid)
-                return it.second;
-        }
+        auto it = detail::class_registry->find(classid);
+        if (it != detail::class_registry->end())
+            return it->second->second;
 
         throw InternalError("core::class_from_classid: ??");
         // throw std::runtime_error("core::class_from_classid: ??");
@@ -106,8 +121,15 @@ namespace core
             }
         }
 
+        if (detail::type_registry_sealed)
+        {
+            throw InternalError("core::construct_scalar: type is not associated");
+            // throw std::runtime_error("core::construct_scalar: type is not associated");
+        }
+
         // Construct a pending object since the class has not been
-        //   associated with the type (yet, hopefully)
+        //   associated with the type yet, it will be bound at the end
+        //   of the builtins registration
         return Object(value, typeId);
     }
 
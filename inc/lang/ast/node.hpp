@@ -110,6 +110,9 @@ namespace lang
             //! Exchange this node with another one, keeping
             //!   the same children, keep in chain
             void exchangeWith(Node* node);
+            //! Substitute this node with another one, which keeps
+            //!   its own children, keep in chain
+            void substituteInChain(Node* node);
             //! Replace this node with another one, discarding
             //!   any children, keep in chain
             void replaceBy(Node* node);
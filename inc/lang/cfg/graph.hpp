@@ -0,0 +1,97 @@
+/*  This file is part of Axolotl.
+ *
+ * Axolotl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Axolotl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Axolotl.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef __AXOLOTL_LANG_CFG_GRAPH_H__
+#define __AXOLOTL_LANG_CFG_GRAPH_H__
+
+#include "lang/forward.hpp"
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace lang
+{
+    namespace cfg
+    {
+        //! Straight-line run of IR nodes, only its first node may be a
+        //!   label and only its last one a jump
+        struct Block
+        {
+            std::vector<ast::Node*> nodes;
+            std::vector<std::size_t> succs;
+            std::vector<std::size_t> preds;
+            //! Unreachable blocks are emptied and keep no edges
+            bool dead = false;
+        };
+
+        //! Control flow graph of a function of the IR
+        //! The body of the function is split into blocks at labels and
+        //!   after jumps, the blocks keep the order of the body so that
+        //!   falling through goes to the next block. The nodes are
+        //!   unlinked from their chain while the graph is worked on,
+        //!   lower() chains the nodes of the blocks back into the body.
+        class Graph
+        {
+        public:
+            explicit Graph(ast::IR_FunDeclNode* fun);
+            ~Graph();
+
+            ast::IR_FunDeclNode* function() const;
+            std::vector<Block>& blocks();
+            std::vector<Block> const& blocks() const;
+
+            //! The node has been taken out of its block, it is deleted
+            //!   when the graph is lowered
+            void erase(ast::Node* node);
+            //! Replace a node of a block, the former one is erased
+            void replace(std::size_t block, std::size_t index, ast::Node* node);
+
+            //! Compute the edges again, after jumps or blocks were removed
+            void link();
+            //! Empty the blocks which can't be reached from the entry
+            //! \return Whether any block was removed
+            bool removeUnreachable();
+
+            //! Reachable blocks, each one before its successors unless
+            //!   the edge closes a loop
+            std::vector<std::size_t> reversePostOrder() const;
+            //! dominators()[b][d] tells whether `d' dominates `b'
+            std::vector<std::vector<bool>> dominators() const;
+
+            //! Chain the nodes back into the body of the function
+            void lower();
+
+            //! Values popped and pushed by a node
+            //! \return False if the effect of the node is unknown
+            static bool stackEffect(ast::Node* node, int& pops, int& pushes);
+            //! Label jumped to by a node, nullptr if it is no jump
+            static std::string const* jumpTarget(ast::Node* node);
+            //! Whether execution never goes on with the next node
+            static bool endsFlow(ast::Node* node);
+
+        private:
+            ast::IR_FunDeclNode* m_fun;
+            std::vector<Block> m_blocks;
+            std::map<std::string, std::size_t> m_labels;
+            std::vector<ast::Node*> m_erased;
+            bool m_lowered;
+        };
+    }
+}
+
+#endif // __AXOLOTL_LANG_CFG_GRAPH_H__
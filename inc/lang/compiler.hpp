@@ -22,18 +22,25 @@
 #include "vm/module.hpp"
 
 #include <iostream>
+#include <cstdint>
 
 namespace lang
 {
+    //! Version of the generated code, it is part of the key of cached
+    //!   bytecode so it must be bumped whenever a pass changes its output
+    static constexpr uint32_t COMPILER_VERSION = 9;
+
     class Compiler
     {
     public:
         enum Flags
         {
-            PP_EARLY_AST = 0x01, //! Pretty-print the early AST generated by the parser
-            PP_AST       = 0x02, //! Pretty-print the AST after transformation
-            PP_IR        = 0x04, //! Pretty-print the generated IR
-            DIS_BYTECODE = 0x08  //! Disassemble the compiled blob
+            PP_EARLY_AST   = 0x01, //! Pretty-print the early AST generated by the parser
+            PP_AST         = 0x02, //! Pretty-print the AST after transformation
+            PP_IR          = 0x04, //! Pretty-print the generated IR
+            DIS_BYTECODE   = 0x08, //! Disassemble the compiled blob
+            EMIT_CPP       = 0x10, //! Emit a C++ translation unit of the module (ahead-of-time compilation)
+            PEEPHOLE_STATS = 0x20  //! Print how many times each peephole rule applied
         };
 
     public:
@@ -47,7 +54,9 @@ namespace lang
         void M_parse();
         void M_transformAST();
         void M_generateIR();
+        void M_optimizeIR();
         bits::Blob M_byteCodeBackend();
+        void M_cppBackend();
         void M_prettyPrint();
 
     private:
@@ -19,6 +19,7 @@
 
 #include "lang/nfa/forward.hpp"
 #include "lang/ast/forward.hpp"
+#include "lang/cfg/forward.hpp"
 #include "lang/pass/forward.hpp"
 
 namespace lang
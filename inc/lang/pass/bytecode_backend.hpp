@@ -20,8 +20,11 @@
 #include "lang/forward.hpp"
 #include "lang/ast/node_visitor.hpp"
 #include "bits/bits.hpp"
+#include "vm/forward.hpp"
+#include "core/forward.hpp"
 
 #include <stack>
+#include <map>
 
 namespace lang
 {
@@ -30,7 +33,7 @@ namespace lang
         class ByteCodeBackend : public ast::NodeVisitor
         {
         public:
-            ByteCodeBackend(ParserBase* parser);
+            ByteCodeBackend(ParserBase* parser, vm::Module const& module);
             virtual ~ByteCodeBackend();
 
             void finalize();
@@ -52,6 +55,9 @@ namespace lang
             void visit(ast::IR_GotoIfFalseNode* node);
             void visit(ast::IR_InvokeNode* node);
             void visit(ast::IR_MethodNode* node);
+            void visit(ast::IR_MethodIntNode* node);
+            void visit(ast::IR_CallSymbolNode* node);
+            void visit(ast::IR_GuardSymbolNode* node);
             void visit(ast::IR_ReturnNode* node);
             void visit(ast::IR_LeaveNode* node);
             void visit(ast::IR_PopNode* node);
@@ -61,6 +67,9 @@ namespace lang
             void visitDefault(ast::Node* node);
 
         private:
+            bool M_addConstant(core::Object const& value);
+            void M_numberSymbols(ast::Node* node);
+
             bool M_inClassDecl() const;
             bits::blob_idx M_currentClassDeclIndex() const;
             void M_pushClassDeclIndex(bits::blob_idx idx);
@@ -68,9 +77,13 @@ namespace lang
 
         private:
             bits::Assembler* m_assembler;
+            bits::BlobBuilder m_builder;
             bits::Blob m_blob;
 
             std::stack<bits::blob_idx> m_class_decls;
+            //! Index of the symbol of each function, known before the
+            //!   functions calling it are generated (see CALL_SYMBOL)
+            std::map<ast::IR_FunDeclNode*, bits::blob_idx> m_symbols;
         };
     }
 }
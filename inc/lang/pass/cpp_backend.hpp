@@ -0,0 +1,163 @@
+/*  This file is part of Axolotl.
+ *
+ * Axolotl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Axolotl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Axolotl.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __AXOLOTL_LANG_PASS_CPP_BACKEND_H__
+#define __AXOLOTL_LANG_PASS_CPP_BACKEND_H__
+
+#include "lang/forward.hpp"
+#include "lang/ast/node_visitor.hpp"
+#include "core/class.hpp"
+#include "core/signature.hpp"
+#include "vm/module.hpp"
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+
+namespace lang
+{
+    namespace pass
+    {
+        //! Ahead-of-time backend, translates the IR of a module to a C++
+        //!   translation unit that records the module as a builtin one
+        //!   (see vm/aot.hpp).
+        //! The operand stack is mapped to local variables, functions of
+        //!   the module that are never assigned are called directly and
+        //!   integer operations are unboxed where `x : int' annotations
+        //!   and integer constants make operand classes known.
+        class CppBackend : public ast::NodeVisitor
+        {
+        public:
+            CppBackend(ParserBase* parser, vm::Module const& module, std::ostream& out);
+            virtual ~CppBackend();
+
+            void visit(ast::IR_ProgNode* node);
+            void visit(ast::IR_FunDeclNode* node);
+            void visit(ast::IR_ClassDeclNode* node);
+            void visit(ast::IR_LoadConstNode* node);
+            void visit(ast::IR_LoadGlobalNode* node);
+            void visit(ast::IR_StorGlobalNode* node);
+            void visit(ast::IR_LoadLocalNode* node);
+            void visit(ast::IR_StorLocalNode* node);
+            void visit(ast::IR_LoadMemberNode* node);
+            void visit(ast::IR_StorMemberNode* node);
+            void visit(ast::IR_LabelNode* node);
+            void visit(ast::IR_GotoNode* node);
+            void visit(ast::IR_GotoIfTrueNode* node);
+            void visit(ast::IR_GotoIfFalseNode* node);
+            void visit(ast::IR_InvokeNode* node);
+            void visit(ast::IR_MethodNode* node);
+            void visit(ast::IR_MethodIntNode* node);
+            void visit(ast::IR_CallSymbolNode* node);
+            void visit(ast::IR_ReturnNode* node);
+            void visit(ast::IR_LeaveNode* node);
+            void visit(ast::IR_PopNode* node);
+            void visit(ast::IR_ImportNode* node);
+            void visit(ast::IR_ImportMaskNode* node);
+
+            void visitDefault(ast::Node* node);
+
+        private:
+            //! Static class of an operand stack entry
+            enum Type
+            {
+                T_OBJECT,
+                T_INT,
+                T_BOOL,
+                //! A module function loaded from a global, not yet boxed
+                T_FUNCTION
+            };
+
+            struct Slot
+            {
+                Type type;
+                //! Index of the function and of its global when
+                //!   type is T_FUNCTION
+                int function;
+                int global;
+            };
+
+            struct Function
+            {
+                std::string name;
+                //! Enclosing class, empty for global functions
+                std::string classname;
+                core::Signature::TypeList arguments;
+                std::size_t locals;
+            };
+
+        private:
+            bool M_collecting(ast::Node* node);
+            void M_push(ast::Node* node, Type type, int function = -1, int global = -1);
+            Slot M_pop(ast::Node* node);
+            int M_top() const;
+            std::string M_box(int index) const;
+            std::string M_stored(int index) const;
+            std::string M_slot(Type type, int index);
+            void M_spill(int count);
+            void M_line(std::string const& line);
+            std::string M_labelName(std::string const& label);
+            void M_checkDepth(ast::Node* node, std::string const& label);
+            void M_jump(ast::Node* node, std::string const& label, int cond);
+            void M_method(ast::Node* node, std::string const& name, int argc);
+
+            int M_name(std::string const& name);
+            int M_global(std::string const& name);
+            int M_direct(std::string const& name) const;
+            //! Whether a global is defined by the module rather than imported
+            bool M_defines(std::string const& name) const;
+            bool M_isInt(core::Class::Id classid) const;
+            std::string M_class(core::Class::Id classid) const;
+            std::string M_prototype(int index) const;
+
+            static std::string M_quote(std::string const& str);
+
+        private:
+            vm::Module m_module;
+            std::ostream& m_out;
+
+            //! First walk over the IR collects the functions and the
+            //!   assigned globals, the second one emits the code
+            bool m_collect;
+
+            std::vector<core::Object> m_constants;
+            std::vector<Function> m_functions;
+            std::map<ast::Node*, int> m_function_index;
+            std::vector<std::string> m_classes;
+            std::set<std::string> m_stored_globals;
+            std::set<std::string> m_used_labels;
+            std::map<std::string, int> m_names;
+            std::map<std::string, int> m_globals;
+
+            std::string m_classname;
+            std::ostringstream m_code;
+
+            // State of the function being emitted
+            int m_function;
+            std::ostringstream m_body;
+            std::vector<Slot> m_stack;
+            std::set<int> m_slots[3];
+            std::map<std::string, int> m_label_depths;
+            std::map<std::string, int> m_label_ids;
+            bool m_reachable;
+        };
+    }
+}
+
+#endif // __AXOLOTL_LANG_PASS_CPP_BACKEND_H__
@@ -0,0 +1,74 @@
+/*  This file is part of Axolotl.
+ *
+ * Axolotl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Axolotl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Axolotl.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __AXOLOTL_LANG_PASS_DEVIRTUALIZE_METHODS_H__
+#define __AXOLOTL_LANG_PASS_DEVIRTUALIZE_METHODS_H__
+
+#include "lang/forward.hpp"
+#include "lang/ast/node_visitor.hpp"
+#include "core/class.hpp"
+
+#include <set>
+#include <string>
+#include <vector>
+
+namespace lang
+{
+    namespace pass
+    {
+        //! Stage   : IR -> IR
+        //! Modifies: replaces `IR_Method' nodes with `IR_CallSymbol' nodes
+        //! This pass resolves the methods called on `self' within a class
+        //!   to one of the class' overloads, using the arity and, when they
+        //!   are known, the classes of the arguments (constants, annotated
+        //!   arguments and integer arithmetics).
+        //! A call is only resolved when the arguments are known to match
+        //!   the chosen overload, or when no other overload could match,
+        //!   so the choice is the one dynamic dispatch would make. The engine
+        //!   still checks the class of self and the signature, and falls
+        //!   back to dynamic dispatch otherwise (see CALL_SYMBOL). Methods
+        //!   whose name is ever assigned as a member in the module are left
+        //!   alone, as instances likely override them.
+        class DevirtualizeMethods : public ast::NodeVisitor
+        {
+        public:
+            using NodeVisitor::NodeVisitor;
+            virtual ~DevirtualizeMethods();
+
+            void visit(ast::IR_ProgNode* node);
+            void visit(ast::IR_ClassDeclNode* node);
+
+        private:
+            //! Classes of the values on the operand stack, AnyId
+            //!   standing for unknown ones
+            typedef std::vector<core::Class::Id> TypeStack;
+
+            void M_collectStoredMembers(ast::Node* node);
+            void M_devirtualize(ast::IR_FunDeclNode* fun, std::vector<ast::IR_FunDeclNode*> const& methods);
+            ast::IR_FunDeclNode* M_resolve(std::string const& name, TypeStack const& args,
+                                           std::vector<ast::IR_FunDeclNode*> const& methods) const;
+
+            static TypeStack M_signature(ast::IR_FunDeclNode* fun);
+            static core::Class::Id M_resultClass(std::string const& name, core::Class::Id self, core::Class::Id arg);
+
+        private:
+            std::vector<core::Class::Id> m_constants;
+            std::set<std::string> m_stored_members;
+        };
+    }
+}
+
+#endif // __AXOLOTL_LANG_PASS_DEVIRTUALIZE_METHODS_H__
@@ -0,0 +1,63 @@
+/*  This file is part of Axolotl.
+ *
+ * Axolotl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Axolotl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Axolotl.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef __AXOLOTL_LANG_PASS_FOLD_CONSTANTS_H__
+#define __AXOLOTL_LANG_PASS_FOLD_CONSTANTS_H__
+
+#include "lang/forward.hpp"
+#include "lang/ast/node_visitor.hpp"
+#include "core/class.hpp"
+#include "core/object.hpp"
+
+namespace lang
+{
+    namespace pass
+    {
+        //! Stage   : AST -> AST
+        //! Modifies: `Method' nodes of the builtin operators
+        //! This pass evaluates the operators whose operands are int, float,
+        //!   bool or string constants, by calling the very methods of the
+        //!   `core' classes, and turns them into `Const' nodes. Operations
+        //!   that would raise or trap (e.g. an integer division by zero),
+        //!   and floats that would not survive the constants table, are
+        //!   left to the runtime.
+        //! Where the classes of the operands are known (constants, annotated
+        //!   arguments and operators thereof), it also drops the identities
+        //!   `x * 1', `x / 1', `x + 0', `x - 0' and `!!b'.
+        class FoldConstants : public ast::NodeVisitor
+        {
+        public:
+            using NodeVisitor::NodeVisitor;
+            virtual ~FoldConstants();
+
+            void visit(ast::MethodNode* node);
+
+        private:
+            //! \return The node replacing an operator, or nullptr
+            ast::Node* M_fold(ast::MethodNode* node) const;
+            ast::Node* M_simplify(ast::MethodNode* node) const;
+            //! \return The class of an expression, AnyId if unknown
+            core::Class::Id M_classOf(ast::Node* node) const;
+
+            static bool M_isPure(std::string const& name);
+            static bool M_isFoldable(core::Object const& value);
+            static bool M_isConst(ast::Node* node, int value);
+        };
+    }
+}
+
+#endif // __AXOLOTL_LANG_PASS_FOLD_CONSTANTS_H__
@@ -29,6 +29,7 @@ namespace lang
         class ExprResultCheck;
         class BindNames;
         class ResolveNames;
+        class FoldConstants;
         class ResolveConsts;
         class GenerateRValue;
         class GenerateLValue;
@@ -38,7 +39,13 @@ namespace lang
         class GenerateIR;
         class RenameLabel;
         class CleanLabels;
+        class DevirtualizeMethods;
+        class InferTypes;
+        class InlineMethods;
+        class OptimizeFunctions;
+        class OptimizePeepholes;
         class ByteCodeBackend;
+        class CppBackend;
     }
 }
 
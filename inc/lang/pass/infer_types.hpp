@@ -0,0 +1,84 @@
+/*  This file is part of Axolotl.
+ *
+ * Axolotl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Axolotl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Axolotl.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef __AXOLOTL_LANG_PASS_INFER_TYPES_H__
+#define __AXOLOTL_LANG_PASS_INFER_TYPES_H__
+
+#include "lang/forward.hpp"
+#include "lang/ast/node_visitor.hpp"
+#include "core/class.hpp"
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace lang
+{
+    namespace pass
+    {
+        //! Stage   : IR -> IR
+        //! Modifies: replaces `IR_Method' nodes with `IR_MethodInt' nodes,
+        //!           sets `typed' on `IR_CallSymbol' nodes
+        //! This pass infers the classes of the values on the operand stack
+        //!   and in the locals of each function, starting from the constants
+        //!   and the annotated arguments, and following the integer
+        //!   arithmetics and comparisons. Classes are merged at labels until
+        //!   they no longer change, a local holding different classes on
+        //!   two paths is unknown.
+        //! Operators on two proven ints are emitted as the specialized
+        //!   instructions the engine would quicken them to (see ADD_INT),
+        //!   statically resolved calls whose arguments are proven to match
+        //!   the signature of their target skip that check at runtime (see
+        //!   CALL_SYMBOL_TYPED).
+        class InferTypes : public ast::NodeVisitor
+        {
+        public:
+            using NodeVisitor::NodeVisitor;
+            virtual ~InferTypes();
+
+            void visit(ast::IR_ProgNode* node);
+            void visit(ast::IR_ClassDeclNode* node);
+            void visit(ast::IR_FunDeclNode* node);
+
+        private:
+            //! Classes of the values on the operand stack and of the
+            //!   locals, AnyId standing for unknown ones
+            struct State
+            {
+                bool reachable;
+                std::vector<core::Class::Id> stack;
+                std::vector<core::Class::Id> locals;
+            };
+
+            //! Run the function once from its entry state
+            //! \return False if a node has an unknown effect
+            bool M_simulate(ast::IR_FunDeclNode* fun, bool rewrite);
+            //! \return False if the states can't be merged
+            bool M_merge(std::string const& label, State const& state);
+
+            static std::vector<core::Class::Id> M_signature(ast::IR_FunDeclNode* fun);
+            static core::Class::Id M_resultClass(std::string const& name, int argc, core::Class::Id self, core::Class::Id arg);
+
+        private:
+            std::vector<core::Class::Id> m_constants;
+            std::map<std::string, State> m_labels;
+            bool m_changed;
+        };
+    }
+}
+
+#endif // __AXOLOTL_LANG_PASS_INFER_TYPES_H__
@@ -0,0 +1,68 @@
+/*  This file is part of Axolotl.
+ *
+ * Axolotl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Axolotl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Axolotl.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __AXOLOTL_LANG_PASS_INLINE_METHODS_H__
+#define __AXOLOTL_LANG_PASS_INLINE_METHODS_H__
+
+#include "lang/forward.hpp"
+#include "lang/ast/node_visitor.hpp"
+
+#include <set>
+#include <string>
+
+namespace lang
+{
+    namespace pass
+    {
+        //! Stage   : IR -> IR
+        //! Modifies: replaces `IR_CallSymbol' nodes with the body of their
+        //!           target, adds locals to the calling methods
+        //! The methods which are inlined are small straight-line leaves:
+        //!   no labels, no statically resolved calls (hence no recursion)
+        //!   and a single `IR_Return' at the end. The arguments and the
+        //!   locals of the callee become locals of the caller.
+        //! Inlined code is guarded the same way as CALL_SYMBOL, the call
+        //!   is dispatched dynamically when the guard fails. The nodes of
+        //!   the callee keep their tokens, so that debug entries still
+        //!   point at its source.
+        //! A module opts out by assigning the `__noinline__' global.
+        class InlineMethods : public ast::NodeVisitor
+        {
+        public:
+            //! Largest body inlined, in nodes, its `IR_Return' excluded
+            static constexpr std::size_t MAX_NODES = 12;
+
+        public:
+            using NodeVisitor::NodeVisitor;
+            virtual ~InlineMethods();
+
+            void visit(ast::IR_ProgNode* node);
+            void visit(ast::IR_ClassDeclNode* node);
+
+        private:
+            bool M_optedOut(ast::Node* node) const;
+            bool M_inlinable(ast::IR_FunDeclNode* fun) const;
+            void M_inline(ast::IR_FunDeclNode* caller, ast::IR_CallSymbolNode* call);
+            ast::Node* M_copy(ast::Node* node, int args_base, int locals_base);
+
+        private:
+            std::set<ast::IR_FunDeclNode*> m_inlinable;
+            int m_count = 0;
+        };
+    }
+}
+
+#endif // __AXOLOTL_LANG_PASS_INLINE_METHODS_H__
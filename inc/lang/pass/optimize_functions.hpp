@@ -0,0 +1,99 @@
+/*  This file is part of Axolotl.
+ *
+ * Axolotl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Axolotl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Axolotl.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef __AXOLOTL_LANG_PASS_OPTIMIZE_FUNCTIONS_H__
+#define __AXOLOTL_LANG_PASS_OPTIMIZE_FUNCTIONS_H__
+
+#include "lang/forward.hpp"
+#include "lang/ast/node_visitor.hpp"
+#include "core/class.hpp"
+
+#include <vector>
+
+namespace lang
+{
+    namespace pass
+    {
+        //! Stage   : IR -> IR
+        //! Modifies: the body of each function, its locals
+        //! This pass works on the control flow graph of each function
+        //!   (see cfg::Graph) and applies, in order:
+        //!   - the removal of unreachable blocks,
+        //!   - loop-invariant code motion: integer operations on constants
+        //!     and on locals not stored in a loop are computed once before
+        //!     it, into a new local (divisions are left in place as they
+        //!     may trap),
+        //!   - value numbering over extended blocks: a pure integer
+        //!     expression whose value is already held by a local is loaded
+        //!     from it instead,
+        //!   - copy propagation: loads of a local copied from another one,
+        //!     from an argument or from an immutable constant load the
+        //!     source instead,
+        //!   - the removal of stores to locals which are never read,
+        //!   - the allocation of the local slots: the stores and loads of
+        //!     the locals are split into webs (the definitions reaching
+        //!     common uses, much like the variables of the SSA form) and
+        //!     the webs which are never live at the same time share a slot.
+        //! Only the operand stack of the IR is left as is, values are not
+        //!   renamed across it.
+        class OptimizeFunctions : public ast::NodeVisitor
+        {
+        public:
+            using NodeVisitor::NodeVisitor;
+            virtual ~OptimizeFunctions();
+
+            void visit(ast::IR_ProgNode* node);
+            void visit(ast::IR_ClassDeclNode* node);
+            void visit(ast::IR_FunDeclNode* node);
+
+        private:
+            //! Locals are indexed from 0, a set of locals is a vector of flags
+            typedef std::vector<bool> LocalSet;
+
+            //! Half-open range of nodes within a block
+            struct Range
+            {
+                std::size_t start;
+                std::size_t end;
+                int local;
+            };
+
+            void M_hoistInvariants(cfg::Graph& graph);
+            void M_numberValues(cfg::Graph& graph);
+            void M_propagateCopies(cfg::Graph& graph);
+            bool M_removeDeadStores(cfg::Graph& graph);
+            void M_allocateLocals(cfg::Graph& graph);
+
+            //! Keep the outermost of nested ranges, given by increasing end
+            std::vector<Range> M_outermost(std::vector<Range> const& ranges) const;
+            //! Replace the ranges of a block by loads of their local
+            void M_replaceRanges(cfg::Graph& graph, std::size_t block, std::vector<Range> const& ranges);
+
+            std::vector<LocalSet> M_liveOut(cfg::Graph const& graph, std::size_t nlocals) const;
+            int M_newLocal(ast::IR_FunDeclNode* fun);
+            bool M_isImmutable(int const_index) const;
+
+            static ast::Node* M_copy(ast::Node* node);
+
+        private:
+            std::vector<core::Class::Id> m_constants;
+            int m_count = 0;
+        };
+    }
+}
+
+#endif // __AXOLOTL_LANG_PASS_OPTIMIZE_FUNCTIONS_H__
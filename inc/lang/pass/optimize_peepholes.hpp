@@ -0,0 +1,91 @@
+/*  This file is part of Axolotl.
+ *
+ * Axolotl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Axolotl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Axolotl.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef __AXOLOTL_LANG_PASS_OPTIMIZE_PEEPHOLES_H__
+#define __AXOLOTL_LANG_PASS_OPTIMIZE_PEEPHOLES_H__
+
+#include "lang/forward.hpp"
+#include "lang/ast/node_visitor.hpp"
+
+#include <map>
+#include <string>
+
+namespace lang
+{
+    namespace pass
+    {
+        //! Stage   : IR -> IR
+        //! Modifies: the body of each function
+        //! Last rewrites of the IR before the backend, over short sequences
+        //!   of nodes and over the jumps:
+        //!   - a jump to a `IR_Goto' jumps to its target instead (nested
+        //!     `if' statements leave chains of them),
+        //!   - a `IR_Goto' to a `IR_Return' or a `IR_Leave' is replaced
+        //!     by a copy of it,
+        //!   - a jump to the node right after it is removed (the condition
+        //!     of a conditional one is popped),
+        //!   - the code which can't be reached is removed (e.g. a
+        //!     `IR_Leave' after a `IR_Return'),
+        //!   - a `IR_Pop' after a load of a constant, an argument or a
+        //!     local is removed along with the load,
+        //!   - `IR_StorLocal n' then `IR_LoadLocal n' are removed when no
+        //!     other node loads the local.
+        //! Each rule counts the times it applied, see hits().
+        class OptimizePeepholes : public ast::NodeVisitor
+        {
+        public:
+            enum Rule
+            {
+                THREAD_JUMP,
+                JUMP_TO_EXIT,
+                JUMP_TO_NEXT,
+                UNREACHABLE,
+                POP_LOAD,
+                STORE_LOAD,
+                RULES_COUNT
+            };
+
+        public:
+            using NodeVisitor::NodeVisitor;
+            virtual ~OptimizePeepholes();
+
+            void visit(ast::IR_FunDeclNode* node);
+
+            //! Number of nodes a rule removed or rewrote
+            std::size_t hits(Rule rule) const;
+            static char const* ruleName(Rule rule);
+
+        private:
+            //! Rewrite the jumps ending the blocks
+            //! \return Whether any jump was changed
+            bool M_threadJumps(cfg::Graph& graph);
+            void M_rewriteBlock(cfg::Graph& graph, std::size_t block, std::map<int, std::size_t> const& loads);
+
+            //! First node executed after a label, nullptr at the end of
+            //!   the function
+            ast::Node* M_destination(cfg::Graph const& graph, std::string const& label) const;
+            //! Whether the label is reached by falling through the block
+            bool M_fallsInto(cfg::Graph const& graph, std::size_t block, std::string const& label) const;
+
+        private:
+            std::map<std::string, std::size_t> m_labels;
+            std::size_t m_hits[RULES_COUNT] = {};
+        };
+    }
+}
+
+#endif // __AXOLOTL_LANG_PASS_OPTIMIZE_PEEPHOLES_H__
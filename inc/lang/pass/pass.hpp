@@ -23,6 +23,7 @@
 #include "lang/pass/expr_result_check.hpp"
 #include "lang/pass/bind_names.hpp"
 #include "lang/pass/resolve_names.hpp"
+#include "lang/pass/fold_constants.hpp"
 #include "lang/pass/resolve_consts.hpp"
 #include "lang/pass/generate_rvalue.hpp"
 #include "lang/pass/generate_lvalue.hpp"
@@ -32,4 +33,10 @@
 #include "lang/pass/generate_ir.hpp"
 #include "lang/pass/rename_label.hpp"
 #include "lang/pass/clean_labels.hpp"
+#include "lang/pass/devirtualize_methods.hpp"
+#include "lang/pass/infer_types.hpp"
+#include "lang/pass/inline_methods.hpp"
+#include "lang/pass/optimize_functions.hpp"
+#include "lang/pass/optimize_peepholes.hpp"
 #include "lang/pass/bytecode_backend.hpp"
+#include "lang/pass/cpp_backend.hpp"
@@ -72,6 +72,9 @@ namespace lang
             void visit(ast::IR_GotoIfFalseNode* node);
             void visit(ast::IR_InvokeNode* node);
             void visit(ast::IR_MethodNode* node);
+            void visit(ast::IR_MethodIntNode* node);
+            void visit(ast::IR_CallSymbolNode* node);
+            void visit(ast::IR_GuardSymbolNode* node);
             void visit(ast::IR_ReturnNode* node);
             void visit(ast::IR_LeaveNode* node);
             void visit(ast::IR_PopNode* node);
@@ -0,0 +1,67 @@
+/*  This file is part of Axolotl.
+ *
+ * Axolotl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Axolotl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Axolotl.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __AXOLOTL_LANG_STD_ATOMS_H__
+#define __AXOLOTL_LANG_STD_ATOMS_H__
+
+#include "lang/std_names.hpp"
+#include "core/atom.hpp"
+
+namespace lang
+{
+    // The protocol names are interned before any other one, in the order
+    //   of std_atom_names, their atoms are thus compile time constants
+
+    constexpr char const* std_atom_names[] =
+    {
+        "",
+        std_main,
+        std_classname, std_classid, std_del, std_call, std_serialize, std_unserialize,
+        std_add, std_sub, std_neg, std_mul, std_div, std_mod,
+        std_and, std_or, std_not,
+        std_equals, std_nequals, std_lt, std_lte, std_gt, std_gte,
+        std_self
+    };
+
+    constexpr core::Atom std_main_atom        = core::Atom::builtin(1);
+
+    constexpr core::Atom std_classname_atom   = core::Atom::builtin(2);
+    constexpr core::Atom std_classid_atom     = core::Atom::builtin(3);
+    constexpr core::Atom std_del_atom         = core::Atom::builtin(4);
+    constexpr core::Atom std_call_atom        = core::Atom::builtin(5);
+    constexpr core::Atom std_serialize_atom   = core::Atom::builtin(6);
+    constexpr core::Atom std_unserialize_atom = core::Atom::builtin(7);
+
+    constexpr core::Atom std_add_atom         = core::Atom::builtin(8);
+    constexpr core::Atom std_sub_atom         = core::Atom::builtin(9);
+    constexpr core::Atom std_neg_atom         = core::Atom::builtin(10);
+    constexpr core::Atom std_mul_atom         = core::Atom::builtin(11);
+    constexpr core::Atom std_div_atom         = core::Atom::builtin(12);
+    constexpr core::Atom std_mod_atom         = core::Atom::builtin(13);
+    constexpr core::Atom std_and_atom         = core::Atom::builtin(14);
+    constexpr core::Atom std_or_atom          = core::Atom::builtin(15);
+    constexpr core::Atom std_not_atom         = core::Atom::builtin(16);
+    constexpr core::Atom std_equals_atom      = core::Atom::builtin(17);
+    constexpr core::Atom std_nequals_atom     = core::Atom::builtin(18);
+    constexpr core::Atom std_lt_atom          = core::Atom::builtin(19);
+    constexpr core::Atom std_lte_atom         = core::Atom::builtin(20);
+    constexpr core::Atom std_gt_atom          = core::Atom::builtin(21);
+    constexpr core::Atom std_gte_atom         = core::Atom::builtin(22);
+
+    constexpr core::Atom std_self_atom        = core::Atom::builtin(23);
+}
+
+#endif // __AXOLOTL_LANG_STD_ATOMS_H__
@@ -30,6 +30,8 @@ namespace lang
     constexpr auto std_package_wildcard = "*";
 
     constexpr auto std_main        = "__main__";
+    //! Assigning this global opts a module out of inlining
+    constexpr auto std_noinline    = "__noinline__";
 
     constexpr auto std_classname   = "__classname__";
     constexpr auto std_classid     = "__classid__";
@@ -55,6 +55,10 @@ namespace lang
         std::size_t localsCount() const;
         std::size_t argumentsCount() const;
 
+        //! Drop the locals past the first `count' ones, once the code
+        //!   no longer uses their slots
+        void truncateLocals(std::size_t count);
+
     private:
         const_iterator M_find(std::string const& name, FindResult* res = nullptr) const;
 
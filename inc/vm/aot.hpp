@@ -0,0 +1,91 @@
+/*  This file is part of Axolotl.
+ *
+ * Axolotl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Axolotl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Axolotl.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __AXOLOTL_VM_AOT_H__
+#define __AXOLOTL_VM_AOT_H__
+
+#include "core/core.hpp"
+#include "vm/forward.hpp"
+#include "vm/module.hpp"
+#include "vm/import_table.hpp"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+// Runtime support of the modules compiled ahead of time to C++ (see
+//   lang::pass::CppBackend), generated units only include this header.
+
+namespace vm
+{
+    namespace aot
+    {
+        //! Native callback with an explicit signature, used for the
+        //!   functions of compiled modules whose arguments may be
+        //!   annotated with script classes
+        class Callback : public core::AbstractCallback
+        {
+        public:
+            typedef std::function<core::Object(std::vector<core::Object> const&)> Function;
+
+        public:
+            Callback(core::Signature const& signature, Function const& fun);
+
+            core::Object invoke(std::vector<core::Object> args);
+            core::Signature signature() const;
+
+        private:
+            core::Signature m_signature;
+            Function m_fun;
+        };
+
+        //! State of a compiled module, built by its record function
+        struct Unit
+        {
+            Module module;
+            //! Constants table, in the order of the module's constants
+            std::vector<core::Object> constants;
+            //! Globals of the module referenced by its code
+            std::vector<core::Object*> globals;
+            //! Names imported by the module, they are kept apart from its
+            //!   globals so that importing the module doesn't export them
+            Module imports;
+        };
+
+        typedef void (*RecordFunction)();
+
+        //! Register the record function of a compiled module, it is called
+        //!   along with the builtin modules by lib::recordAll(), or right
+        //!   away if they are already recorded
+        //! \return Always true, so it can initialize a static variable
+        bool add(RecordFunction record);
+        void recordAll();
+
+        //! Create the callable object of a compiled function
+        core::Object function(core::Signature::TypeList const& arguments, Callback::Function const& fun);
+
+        //! Generic operations, with the semantics of the matching instructions
+        core::Object invoke(core::Object fun, std::vector<core::Object> const& args);
+        core::Object method(core::Object self, core::Atom const& name, std::vector<core::Object> const& args);
+        core::Object loadMember(core::Object self, core::Atom const& name);
+        void storMember(core::Object self, core::Atom const& name, core::Object value);
+        bool truth(core::Object const& cond);
+        void import(Unit& unit, std::string const& name);
+        void importMask(Unit& unit, std::string const& name, std::string const& mask);
+    }
+}
+
+#endif // __AXOLOTL_VM_AOT_H__
@@ -0,0 +1,100 @@
+/*  This file is part of Axolotl.
+ *
+ * Axolotl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Axolotl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Axolotl.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef __AXOLOTL_VM_BYTECODE_CACHE_H__
+#define __AXOLOTL_VM_BYTECODE_CACHE_H__
+
+#include "vm/forward.hpp"
+#include "vm/module.hpp"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdint>
+
+namespace vm
+{
+    //! This is 'AXLC' in ASCII
+    static constexpr uint32_t CACHE_MAGIC = 0x434C5841;
+
+    //! Header of a cached module (a `.xlc' file next to the `.xl' one),
+    //!   it is followed by the import requests of the module, by its
+    //!   dependencies then by the blob
+    struct __attribute__((packed)) cache_hdr
+    {
+        //! Magic number, should be CACHE_MAGIC
+        uint32_t c_magic;
+        //! Should be bits::BLOB_VERSION
+        uint32_t c_blob_version;
+        //! Should be lang::COMPILER_VERSION
+        uint32_t c_compiler_version;
+        //! Hash of the source of the module
+        uint64_t c_source_hash;
+        //! Number of import requests (name, mask and alias strings)
+        uint32_t c_nrequests;
+        //! Number of dependencies (name string and source hash), these
+        //!   are all the user modules imported directly or not
+        uint32_t c_ndeps;
+        //! Size in bytes of the blob
+        uint32_t c_blob_size;
+        //! Hash of everything after the header, a corrupted file is
+        //!   compiled again
+        uint64_t c_body_hash;
+    };
+
+    //! Persistent cache of compiled user modules. A cached module is
+    //!   valid as long as neither its source nor the source of one of
+    //!   its dependencies changes. Loading it replays the imports the
+    //!   parser would have done, then uses the cached blob.
+    //! Set AXOLOTL_CACHE=0 to disable it.
+    class ByteCodeCache
+    {
+    public:
+        //! Load module `name' from its cache file
+        //! \param name The name of the module
+        //! \param source The source of the module, rewound before returning
+        //! \param module Output parameter for the loaded module
+        //! \return true if successful, false if the module must be compiled
+        static bool load(std::string const& name, std::istream& source, Module& module);
+
+        //! Write the cache file of a freshly compiled module, failures are
+        //!   ignored (the module is compiled again next time)
+        //! \param name The name of the module
+        //! \param module The compiled module
+        static void store(std::string const& name, Module& module);
+
+        static bool enabled();
+
+    private:
+        typedef std::vector<std::pair<std::string, uint64_t>> Dependencies;
+
+        static uint64_t M_hash(std::string const& data);
+        static uint64_t M_hash(uint8_t const* data, std::size_t size);
+        static bool M_sourceHash(std::string const& name, uint64_t& hash);
+        static std::string M_file(std::string const& name);
+
+    private:
+        //! Hash of the sources read by this process
+        static std::map<std::string, uint64_t> m_sources;
+
+        //! Dependencies of the user modules opened by this process
+        static std::map<std::string, Dependencies> m_dependencies;
+    };
+}
+
+#endif // __AXOLOTL_VM_BYTECODE_CACHE_H__
@@ -24,6 +24,7 @@
 
 #include <string>
 #include <map>
+#include <unordered_map>
 #include <vector>
 #include <list>
 
@@ -31,6 +32,8 @@ namespace vm
 {
     class Engine
     {
+        friend class Jit;
+
     private:
         struct DebugInfo
         {
@@ -41,6 +44,28 @@ namespace vm
             std::size_t extent;
         };
 
+        //! Observations made on an instruction that may be quickened
+        struct QuickSite
+        {
+            //! Quickened opcode the observations are in favor of
+            bits::Opcode opcode;
+            int hits;
+            int deopts;
+        };
+
+        //! Private copy of a module's code, rewritten in place with
+        //!   quickened instructions
+        struct QuickText
+        {
+            std::vector<uint8_t> code;
+            std::unordered_map<int, QuickSite> sites;
+        };
+
+        //! Same observations needed before an instruction is quickened
+        static constexpr int QUICKEN_HITS = 8;
+        //! Failed guards after which an instruction stays generic
+        static constexpr int QUICKEN_MAX_DEOPTS = 4;
+
     public:
         Engine(Module const& main_module);
         ~Engine();
@@ -48,6 +73,9 @@ namespace vm
         core::Object execute(Function const& fun, std::vector<core::Object> const& args);
         ImportTable* importTable() const;
 
+        //! Forget the code copy of a module which is being destroyed
+        void release(Module::Impl const* module);
+
     private:
         void M_initOpcodes();
         bool M_checkOpcode(bits::Opcode opcode) const;
@@ -63,36 +91,57 @@ namespace vm
         core::Object M_stackAt(int index) const;
 
         void M_changeModule(Module const& module);
-        uint32_t M_fetch();
+        uint8_t M_fetch();
+        int32_t M_fetchOperand();
         void M_decode();
         bool M_execute();
+        bool M_run();
         StackFrame M_makeFrame(bool dummy = false) const;
         bool M_setFrame(StackFrame const& frame);
         void M_invoke(core::Object fun, int argc);
         void M_enter(bool dummy = false);
         bool M_leave();
         void M_branchToFunction(Function const& fun);
+        void M_branchToSymbol(Module const& module, bits::blob_symbol const* symbol);
+        void M_method(core::Atom const& name, int argc);
+        //! \param typed Whether the classes of the arguments are already known to match
+        bool M_symbolMatches(bits::blob_idx symidx, bits::blob_symbol const* symbol, int argc, bool typed = false) const;
+        DebugInfo M_debugInfo(Module const& module, int pc) const;
+        //! Debug information of the call a method was inlined at, if the
+        //!   instruction at `pc' belongs to an inlined method
+        DebugInfo M_inlinedAt(Module const& module, int pc) const;
         void M_error(std::string const& msg) const;
 
+        void M_observe(bits::Opcode quickened);
+        bool M_deoptimize(bits::Opcode generic);
+
     private:
         Module m_main_module;
         ImportTable* m_import_table;
 
         std::vector<core::Object> m_stack;
         std::shared_ptr<bits::Buffer> m_text;
+        uint8_t* m_code;
+        int m_code_size;
+        //! Code copies of the modules
+        std::unordered_map<Module::Impl const*, QuickText> m_quick;
+        QuickText* m_quick_text;
         std::vector<int> m_backtrace;
 
         bits::Opcode m_ir;
-        DebugInfo m_debug;
         std::vector<uint32_t> m_operands;
 
         int m_pc;
+        int m_ir_pc;
         Module* m_module;
         int m_locals_start;
         int m_locals_count;
         int m_argc;
 
-        std::map<bits::Opcode, int> m_opcodes_nargs;
+        std::vector<int> m_opcodes_nargs;
+
+        Jit* m_jit;
+        JitProfile* m_profile;
     };
 }
 
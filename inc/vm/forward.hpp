@@ -25,6 +25,9 @@ namespace vm
     class Engine;
     class StackFrame;
     class Script;
+    class ByteCodeCache;
+    class Jit;
+    struct JitProfile;
 }
 
 #endif // __AXOLOTL_VM_FORWARD_H__
@@ -28,21 +28,21 @@ namespace vm
     class Function
     {
     public:
-        Function(Module const& module, bits::blob_symbol* symbol);
+        Function(Module const& module, bits::blob_symbol const* symbol);
         ~Function();
 
         core::Object invoke(std::vector<core::Object> const& args) const;
 
         core::Signature const& signature() const;
         Module const& module() const;
-        bits::blob_symbol* symbol() const;
+        bits::blob_symbol const* symbol() const;
 
     private:
         void M_createSignature();
 
     private:
         Module m_module;
-        bits::blob_symbol* m_symbol;
+        bits::blob_symbol const* m_symbol;
         std::shared_ptr<core::Signature> m_signature;
     };
 }
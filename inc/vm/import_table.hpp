@@ -23,6 +23,7 @@
 
 #include <string>
 #include <map>
+#include <vector>
 
 namespace vm
 {
@@ -37,6 +38,16 @@ namespace vm
             Module module;
         };
 
+    public:
+        //! An import done through the table, as written in the source
+        class Request
+        {
+        public:
+            std::string name;
+            std::string mask;
+            std::string alias;
+        };
+
     public:
         ImportTable();
         ~ImportTable();
@@ -55,6 +66,10 @@ namespace vm
 
         void setEngine(Engine* engine);
 
+        //! Imports done through this table, in order, this is what the
+        //!   parser of a module did (see ByteCodeCache)
+        std::vector<Request> const& requests() const;
+
     private:
         Module M_import(Module& to, std::string const& name, std::string const& alias, std::string const& mask);
         Import M_open(std::string const& name, std::string const& alias);
@@ -63,6 +78,7 @@ namespace vm
         lang::Symtab* m_symtab;
         std::map<std::string, Module> m_scope;
         std::map<std::string, Import> m_table;
+        std::vector<Request> m_requests;
 
     public:
         static void addBuiltin(Module const& module);
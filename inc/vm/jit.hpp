@@ -0,0 +1,189 @@
+/*  This file is part of Axolotl.
+ *
+ * Axolotl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Axolotl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Axolotl.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __AXOLOTL_VM_JIT_H__
+#define __AXOLOTL_VM_JIT_H__
+
+#include "vm/forward.hpp"
+#include "vm/module.hpp"
+#include "bits/blob.hpp"
+
+#include <unordered_map>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdio>
+
+namespace vm
+{
+    //! Native code of a compiled function
+    struct JitCode
+    {
+        //! Executable mapping (the entry stub is at its beginning)
+        uint8_t* base;
+        //! Size of the mapping
+        std::size_t size;
+        //! Address of the first instruction of the function
+        int start;
+        //! Offset in the mapping of each instruction (indexed by address
+        //!   relative to `start', -1 if no instruction begins there)
+        std::vector<int> entries;
+    };
+
+    //! Hotness counters of a script function
+    struct JitProfile
+    {
+        Module module;
+        bits::blob_symbol const* symbol;
+        std::size_t calls;
+        std::size_t backedges;
+        //! Compilation was attempted and failed
+        bool failed;
+        //! Compilation is pending in the background thread
+        bool queued;
+        JitCode* code;
+    };
+
+    //! Function handed to the compiler thread
+    struct JitJob
+    {
+        JitProfile* profile;
+        //! Snapshot of the (quickened) code of the function
+        std::vector<uint8_t> text;
+        int start;
+        //! Constants table of the module
+        std::vector<core::Object> const* constants;
+        //! Result, nullptr if the compilation failed
+        JitCode* code;
+    };
+
+    //! Where native code finds the fields it accesses, measured on live
+    //!   objects rather than assumed from the declarations
+    struct JitLayout
+    {
+        //! Whether objects and vectors have the expected shape, nothing
+        //!   is compiled otherwise
+        bool valid;
+        //! Engine fields
+        int32_t stack;
+        int32_t locals_start;
+        int32_t locals_count;
+        int32_t argc;
+        //! Object instance fields
+        int32_t data;
+        int32_t refcount;
+        int32_t frozen;
+        //! Vtables of int and bool values, and offsets of the values
+        uint64_t int_tag;
+        uint64_t bool_tag;
+        int32_t int_value;
+        int32_t bool_value;
+        //! Class and number of members of fresh ints
+        core::Class::Id int_class;
+        std::size_t int_members;
+    };
+
+    //! Baseline JIT compiler, hot functions are translated to x86-64 code.
+    //! Locals, constants, jumps and the quickened integer operations run
+    //!   natively on the engine's stack, native code calls back into the
+    //!   engine to allocate objects and for any other instruction (calls,
+    //!   methods, members...), or when a guard fails.
+    //! The interpreter takes over whenever control leaves the function.
+    //!
+    //! Execution is tiered: functions are interpreted first, while their
+    //!   instructions get quickened from the observed operand classes.
+    //!   Once hot, a snapshot of their quickened code is compiled by a
+    //!   background thread, the engine keeps interpreting meanwhile and
+    //!   installs the native code at the next call or backward jump.
+    //! The compiler takes the quickened instructions as type feedback:
+    //!   integer expressions over locals and constants are evaluated
+    //!   unboxed in registers, then branched on or stored in place without
+    //!   allocating. Their guards fall back to the boxed translation.
+    class Jit
+    {
+    public:
+        //! Values returned by run()
+        enum Status
+        {
+            //! Continue in the interpreter
+            CONTINUE = 1,
+            //! A dummy frame has been left, stop execution
+            STOP = 2
+        };
+
+        static constexpr std::size_t HOT_CALLS = 64;
+        static constexpr std::size_t HOT_BACKEDGES = 1024;
+
+    public:
+        Jit(Engine* engine);
+        ~Jit();
+
+        //! Whether native code can be generated on this platform (and
+        //!   the JIT was not disabled with AXOLOTL_JIT=0)
+        static bool enabled();
+
+        JitProfile* profile(Module const& module, bits::blob_symbol const* symbol);
+
+        //! Count a call to (or a backward jump in) a function, and
+        //!   compile it if it became hot
+        void call(JitProfile* profile);
+        void backEdge(JitProfile* profile);
+
+        //! Run the native code of a function from address `pc'
+        //! \return false if there is no native code for this address, true otherwise
+        //!         with `status' set to a Status value
+        bool run(JitProfile* profile, int pc, int& status);
+
+    private:
+        void M_request(JitProfile* profile);
+        void M_install();
+        void M_worker();
+        JitCode* M_compile(JitJob const& job) const;
+        static void M_release(JitCode* code);
+        void M_perfMap(JitProfile* profile);
+        static JitLayout M_layout(Engine* engine);
+
+        //! Helpers called by native code
+        static int M_step(Engine* engine, int opcode, int op0, int op1, int pc, int next_pc);
+        //! Destroy an object whose last reference was popped
+        static void M_drop(core::Object::Impl* impl);
+        //! Store an unboxed integer in local #index
+        static void M_storeInt(Engine* engine, int index, int value);
+        static void M_pushInt(Engine* engine, int value);
+        static void M_pushBool(Engine* engine, int value);
+
+    private:
+        Engine* m_engine;
+        JitLayout m_layout;
+        std::unordered_map<bits::blob_symbol const*, JitProfile> m_profiles;
+        FILE* m_perf_map;
+
+        //! Compiler thread, started with the first request
+        std::thread m_thread;
+        std::mutex m_mutex;
+        std::condition_variable m_wakeup;
+        std::deque<JitJob> m_requests;
+        std::deque<JitJob> m_results;
+        //! Set when m_results is not empty, checked at each safe point
+        std::atomic<bool> m_ready;
+        bool m_stop;
+    };
+}
+
+#endif // __AXOLOTL_VM_JIT_H__
@@ -24,14 +24,19 @@
 
 #include <string>
 #include <map>
+#include <unordered_map>
 #include <vector>
 #include <stdexcept>
 #include <list>
+#include <functional>
 
 namespace vm
 {
     class Module
     {
+    public:
+        class Impl;
+
     public:
         Module();
         Module(bits::Blob const& blob, ImportTable* import_table = nullptr);
@@ -44,8 +49,14 @@ namespace vm
 
         std::string const& name() const;
 
-        core::Object& global(std::string const& name);
-        core::Object global(std::string const& name) const;
+        core::Object& global(core::Atom const& name);
+        core::Object global(core::Atom const& name) const;
+
+        //! Atom of a string of the blob, interned on first use
+        core::Atom atom(bits::blob_off offset) const;
+        //! Class declaring a method symbol of the blob
+        //! \return The class id, 0 if the symbol is not a method
+        core::Class::Id methodClass(bits::blob_idx symidx) const;
 
         int addConstant(core::Object value);
         core::Object constant(int index) const;
@@ -66,21 +77,40 @@ namespace vm
         void init();
 
     private:
+        static Module M_fromImpl(Impl* impl);
+
         void M_incref();
         void M_decref();
         void M_processSymbols();
         void M_processTypeSpecs();
         void M_processConstants();
-        core::Object M_makeFunction(bits::blob_symbol* symbol) const;
+        bool M_materialize(core::Atom const& name) const;
+        core::Object M_makeFunction(bits::blob_symbol const* symbol) const;
+        core::Object M_makeClass(bits::blob_idx tsidx) const;
+        core::Object M_makeConstant(bits::blob_constant const* constant) const;
 
     public:
+        //! Builds a global on first access, see Module::setBlob
+        typedef std::function<core::Object()> LazyGlobal;
+
         class Impl
         {
         public:
             std::string name;
             bits::Blob blob;
-            std::map<std::string, core::Object> globals;
+            std::unordered_map<core::Atom, core::Object> globals;
+            //! Globals defined by the blob (or exported from another
+            //!   module) which were not accessed yet
+            std::unordered_map<core::Atom, LazyGlobal> lazy_globals;
+            //! Atoms of the blob strings, by offset
+            std::unordered_map<bits::blob_off, core::Atom> atoms;
+            //! Class ids by symbol index, filled on first use
+            std::vector<core::Class::Id> method_classes;
             std::vector<core::Object> constants;
+            //! Whether each constant was decoded from the blob yet
+            std::vector<bool> constants_loaded;
+            //! Index of the first constant which comes from the blob
+            std::size_t blob_constants;
             Engine* engine;
             ImportTable* import_table;
             bool init_called;
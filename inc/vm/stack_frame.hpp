@@ -31,7 +31,10 @@ namespace vm
         int locals_start;
         int locals_count;
         int argc;
-        core::Some debug;
+        //! Address of the calling instruction
+        int call_pc;
+        //! Profile of the function, used by the JIT
+        JitProfile* profile;
     };
 }
 
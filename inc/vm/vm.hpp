@@ -16,8 +16,11 @@
 
 #include "vm/forward.hpp"
 #include "vm/import_table.hpp"
+#include "vm/bytecode_cache.hpp"
 #include "vm/module.hpp"
 #include "vm/function.hpp"
 #include "vm/engine.hpp"
+#include "vm/jit.hpp"
+#include "vm/aot.hpp"
 #include "vm/stack_frame.hpp"
 #include "vm/script.hpp"
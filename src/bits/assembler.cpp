@@ -1,9 +1,8 @@
 #include "bits/assembler.hpp"
-#include "bits/basic_buffer.hpp"
+#include "bits/leb128.hpp"
 #include "lang/token.hpp"
 
 #include <stdexcept>
-#include <cstdlib>
 
 using namespace bits;
 using namespace core;
@@ -70,23 +69,18 @@ std::size_t DebugInfo::col() const
 std::size_t DebugInfo::extent() const
 { return m_extent; }
 
-Assembler::Assembler(Blob& blob, std::size_t chunk_size)
-    : m_blob(blob)
-    , m_raw(nullptr)
-    , m_raw_chunk_size(chunk_size)
-    , m_raw_size(0)
-    , m_raw_avail_size(0)
+Assembler::Assembler(BlobBuilder& builder, std::size_t chunk_size)
+    : m_builder(builder)
+    , m_text(chunk_size)
+    , m_finalized(false)
 {}
 
 Assembler::~Assembler()
-{
-    if (m_raw)
-        finalize();
-}
+{ finalize(); }
 
 void Assembler::setDebugInfo(std::string const& file)
 {
-    if (!m_blob.setDebugHeader(file))
+    if (!m_builder.setDebugHeader(file))
         throw std::runtime_error("bits::Assembler::setDebugInfo: can't set the debug header");
 }
 
@@ -105,16 +99,12 @@ void Assembler::emit(Opcode opcode, std::vector<Operand> const& operands, DebugI
 
     if (!info.empty())
     {
-        M_write(opcode | DEBUG_MASK);
-
-        blob_idx deidx = 0;
-        if (!m_blob.addDebugEntry(info.line(), info.col(), info.extent(), &deidx))
-            throw std::runtime_error("vits::Assembler::emit: can't add debug entry in blob");
-
-        M_write(deidx);
+        if (!m_builder.addDebugEntry(pos(), info.line(), info.col(), info.extent()))
+            throw std::runtime_error("bits::Assembler::emit: can't add debug entry in blob");
     }
-    else
-        M_write(opcode);
+
+    uint8_t byte = opcode;
+    M_write(&byte, 1);
 
     for (auto op : operands)
     {
@@ -123,20 +113,24 @@ void Assembler::emit(Opcode opcode, std::vector<Operand> const& operands, DebugI
             case Operand::String:
             {
                 blob_off sidx;
-                if (!m_blob.addString(op.data().as<std::string>(), sidx))
+                if (!m_builder.addString(op.data().as<std::string>(), sidx))
                     throw std::runtime_error("bits::Assembler::emit: can't add string in blob");
-                M_write(sidx);
+                M_writeOperand(sidx);
                 break;
             }
 
             case Operand::Index:
-                M_write(op.data().as<int>());
+                M_writeOperand(op.data().as<int>());
                 break;
 
             case Operand::LabelRef:
+            {
+                // Label references are padded so they can be patched in finalize()
+                uint8_t raw[LEB128_MAX];
                 m_label_refs.push_back(std::make_pair(pos(), op.data().as<std::string>()));
-                M_write(0);
+                M_write(raw, sleb128_encode_padded(0, raw));
                 break;
+            }
 
             default:
                 break;
@@ -146,7 +140,7 @@ void Assembler::emit(Opcode opcode, std::vector<Operand> const& operands, DebugI
 
 void Assembler::finalize()
 {
-    if (!m_raw)
+    if (m_finalized || !m_text.size())
         return;
     
     for (auto ref : m_label_refs)
@@ -155,29 +149,28 @@ void Assembler::finalize()
         if (label == m_labels.end())
             throw std::runtime_error("bits::Assembler::finalize: unresolved label `" + ref.second + "'");
 
-        m_raw[ref.first] = label->second;
+        uint8_t raw[LEB128_MAX];
+        m_text.copy(ref.first, raw, sleb128_encode_padded((int32_t) label->second, raw));
     }
 
-    Buffer* buffer = new BasicBuffer((uint8_t*) m_raw, m_raw_size * sizeof(uint32_t));
-    m_blob.setText(buffer);
-    delete buffer;
-
-    std::free(m_raw);
-    m_raw = nullptr;
+    m_builder.setText(&m_text);
+    m_finalized = true;
 }
 
 std::size_t Assembler::pos() const
-{ return m_raw_size; }
+{ return m_text.size(); }
 
-std::size_t Assembler::M_write(uint32_t word)
+std::size_t Assembler::M_write(uint8_t const* bytes, std::size_t len)
 {
-    if (m_raw_size >= m_raw_avail_size)
-    {
-        m_raw_avail_size += m_raw_chunk_size;
-        m_raw = (uint32_t*) std::realloc(m_raw, m_raw_avail_size * sizeof(uint32_t));
-    }
+    std::size_t at = m_text.size();
+    if (!m_text.inject(at, len) || !m_text.copy(at, (uint8_t*) bytes, len))
+        throw std::runtime_error("bits::Assembler::M_write: can't write to the text buffer");
 
-    m_raw[m_raw_size++] = word;
+    return at;
+}
 
-    return m_raw_size - 1;
+std::size_t Assembler::M_writeOperand(int32_t value)
+{
+    uint8_t raw[LEB128_MAX];
+    return M_write(raw, sleb128_encode(value, raw));
 }
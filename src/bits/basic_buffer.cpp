@@ -106,6 +106,11 @@ uint8_t* BasicBuffer::raw(std::size_t pos, std::size_t len)
     return m_raw + pos;
 }
 
+uint8_t const* BasicBuffer::view(std::size_t pos, std::size_t len)
+{
+    return raw(pos, len);
+}
+
 Buffer* BasicBuffer::sub(std::size_t pos, std::size_t len)
 {
     if (pos + len > m_size)
@@ -14,15 +14,19 @@
  * along with Axolotl.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+
 #include "bits/blob.hpp"
 #include "bits/basic_buffer.hpp"
+#include "bits/leb128.hpp"
+
+#include <cstring>
 
 using namespace bits;
 
 Blob::Blob()
+    : m_buffer(nullptr)
 {
-    m_buffer = new BasicBuffer();
-    m_buffer->refcount = 1;
+    M_load();
 }
 
 Blob::Blob(Buffer* buffer)
@@ -30,6 +34,8 @@ Blob::Blob(Buffer* buffer)
     m_buffer = buffer;
     if (m_buffer)
         ++m_buffer->refcount;
+
+    M_load();
 }
 
 Blob::Blob(Blob const& cpy)
@@ -37,6 +43,11 @@ Blob::Blob(Blob const& cpy)
     m_buffer = cpy.m_buffer;
     if (m_buffer)
         ++m_buffer->refcount;
+
+    m_raw = cpy.m_raw;
+    std::memcpy(m_sections, cpy.m_sections, sizeof(m_sections));
+    m_tspec_offsets = cpy.m_tspec_offsets;
+    m_signature_offsets = cpy.m_signature_offsets;
 }
 
 Blob::~Blob()
@@ -47,878 +58,296 @@ Blob::~Blob()
 
 Blob& Blob::operator=(Blob const& cpy)
 {
+    if (cpy.m_buffer)
+        ++cpy.m_buffer->refcount;
+
     if (m_buffer && !--m_buffer->refcount)
         delete m_buffer;
 
     m_buffer = cpy.m_buffer;
-    if (m_buffer)
-        ++m_buffer->refcount;
+
+    m_raw = cpy.m_raw;
+    std::memcpy(m_sections, cpy.m_sections, sizeof(m_sections));
+    m_tspec_offsets = cpy.m_tspec_offsets;
+    m_signature_offsets = cpy.m_signature_offsets;
 
     return *this;
 }
 
 Blob Blob::copy() const
 {
-    return Blob{m_buffer->copy()};
+    return Blob{m_buffer ? m_buffer->copy() : nullptr};
 }
 
-bool Blob::setModuleName(std::string const& module_name)
+bool Blob::check() const
 {
-    blob_idx sidx;
-    if (!addString(module_name, sidx))
+    blob_hdr const* hdr = M_header();
+    if (!hdr || hdr->h_magic != BLOB_MAGIC || hdr->h_version != BLOB_VERSION)
         return false;
 
-    blob_hdr* header = M_header();
-    if (!header)
+    std::size_t size = m_buffer->size();
+    if ((std::size_t) hdr->h_shoff + hdr->h_shnum * sizeof(blob_shdr) > size)
         return false;
 
-    header->h_module_name = sidx;
+    for (blob_idx i = 0; i < hdr->h_shnum; ++i)
+    {
+        blob_shdr const* shdr = M_sectionHeader(i);
+        if ((std::size_t) shdr->sh_offset + shdr->sh_size > size)
+            return false;
+    }
+
     return true;
 }
 
+bool Blob::write(std::ostream& out) const
+{
+    if (!m_raw)
+        return false;
+
+    out.write((char const*) m_raw, m_buffer->size());
+    return (bool) out;
+}
+
 std::string Blob::moduleName() const
 {
     std::string module_name = "";
 
-    blob_hdr* header = M_header();
+    blob_hdr const* header = M_header();
     if (header)
         string(header->h_module_name, module_name);
 
     return module_name;
 }
 
-bool Blob::string(blob_off off, std::string& str) const
+bool Blob::string(blob_off off, blob_string& str) const
 {
-    blob_shdr* strings = M_findSectionHeader(BLOB_ST_STRINGS);
-
-    if (!strings || off >= strings->sh_size)
+    M_Section const& strings = M_section(BLOB_ST_STRINGS);
+    if (off >= strings.size)
         return false;
 
-    std::shared_ptr<Buffer> data = M_sectionData(strings);
-
-    std::size_t len = 1;
-    for (int i = (int) off; i < (int) strings->sh_size; ++i, ++len)
-        if (!data->at(i))
-            break;
+    char const* start = (char const*) strings.data + off;
+    char const* end = (char const*) std::memchr(start, 0, strings.size - off);
+    if (!end)
+        return false;
 
-    str = (const char*) data->raw(off, len);
+    str.str = start;
+    str.len = (blob_len) (end - start);
     return true;
 }
 
-std::string Blob::string(blob_off soff) const
-{
-    std::string str = "";
-    string(soff, str);
-    return str;
-}
-
-bool Blob::addString(std::string const& str, blob_off& off)
+bool Blob::string(blob_off off, std::string& str) const
 {
-    // Get (or create if necessary) the STRINGS section
-    blob_shdr* strings = M_findSectionHeader(BLOB_ST_STRINGS);
-    if (!strings)
-    {
-        strings = M_createSectionHeader();
-        if (!strings)
-            return false;
-        strings->sh_type = BLOB_ST_STRINGS;
-    }
-
-    // Search if the string already exists
-    if (findString(str, &off))
-        return true;
-
-    // Get string as ASCII
-    const char* as_ascii = str.c_str();
-    std::size_t as_ascii_len = str.size() + 1;
-    off = strings->sh_size;
-
-    // Grow section
-    std::shared_ptr<Buffer> data = M_growSection(strings, as_ascii_len);
-    if (!data)
-        return false;
-
-    // Copy string entry
-    if (!data->copy(0, (uint8_t*) as_ascii, as_ascii_len))
+    blob_string entry;
+    if (!string(off, entry))
         return false;
 
+    str.assign(entry.str, entry.len);
     return true;
 }
 
-bool Blob::findString(std::string const& str, blob_off* soff)
+std::string Blob::string(blob_off soff) const
 {
-    blob_shdr* strings = M_findSectionHeader(BLOB_ST_STRINGS);
-    if (!strings)
-        return false;
-
-    std::shared_ptr<Buffer> data = M_sectionData(strings);
-    if (!data)
-        return false;
-
-    for (std::size_t pos = 0; pos < strings->sh_size;)
-    {
-        std::size_t len = 1;
-        for (int i = 0; i < (int) (strings->sh_size - pos); ++i, ++len)
-            if (!data->at(pos + i))
-                break;
-
-        if (str == (const char*) data->raw(pos, len))
-        {
-            if (soff)
-                *soff = (blob_off) pos;
-            return true;
-        }
-
-        pos += len;
-    }
-
-    return false;
+    std::string str = "";
+    string(soff, str);
+    return str;
 }
 
-blob_symbol* Blob::symbol(blob_idx symidx) const
+blob_symbol const* Blob::symbol(blob_idx symidx) const
 {
-    blob_shdr* symbols = M_findSectionHeader(BLOB_ST_SYMBOLS);
-    if (!symbols)
-        return nullptr;
-
-    if (symidx >= symbols->sh_size / sizeof(blob_symbol))
+    if (symidx >= symbolCount())
         return nullptr;
 
-    std::shared_ptr<Buffer> data = M_sectionData(symbols);
-    if (!data)
-        return nullptr;
-
-    return (blob_symbol*) data->raw(symidx * sizeof(blob_symbol), sizeof(blob_symbol));
+    return (blob_symbol const*) M_section(BLOB_ST_SYMBOLS).data + symidx;
 }
 
-blob_symbol* Blob::addSymbol(std::string const& name, blob_idx* symidx)
+std::size_t Blob::symbolCount() const
 {
-    // First of all, allocate the name entry
-    blob_off name_off;
-    if (!addString(name, name_off))
-        return nullptr;
-
-    // Get (or create if necessary) the SYMBOLS section
-    blob_shdr* symbols = M_findSectionHeader(BLOB_ST_SYMBOLS);
-    if (!symbols)
-    {
-        symbols = M_createSectionHeader();
-        if (!symbols)
-            return nullptr;
-        symbols->sh_type = BLOB_ST_SYMBOLS;
-    }
-
-    if (symidx)
-        *symidx = (int) (symbols->sh_size / sizeof(blob_symbol));
-
-    std::shared_ptr<Buffer> data = M_growSection(symbols, sizeof(blob_symbol));
-    if (!data)
-        return nullptr;
-
-    blob_symbol* sym = (blob_symbol*) data->raw(0, sizeof(blob_symbol));
-    sym->s_name = name_off;
-    sym->s_type = BLOB_SYMT_NULL;
-    sym->s_bind = BLOB_SYMB_NULL;
-    sym->s_addr = 0;
-    sym->s_nlocals = 0;
-    sym->s_signature = 0;
-
-    return sym;
+    return M_section(BLOB_ST_SYMBOLS).size / sizeof(blob_symbol);
 }
 
-blob_typespec* Blob::typeSpec(blob_idx tsidx, blob_off* tsoff) const
+blob_typespec const* Blob::typeSpec(blob_idx tsidx, blob_off* tsoff) const
 {
-    blob_shdr* tspecs = M_findSectionHeader(BLOB_ST_TSPECS);
-    if (!tspecs)
-        return nullptr;
-
-    std::shared_ptr<Buffer> data = M_sectionData(tspecs);
-    if (!data)
+    if (tsidx >= m_tspec_offsets.size())
         return nullptr;
 
-    blob_idx idx = 0;
-    for (std::size_t pos = 0; pos < tspecs->sh_size; ++idx)
-    {
-        blob_typespec* tspec = (blob_typespec*) data->raw(pos, sizeof(blob_typespec));
-        if (idx == tsidx)
-        {
-            if (tsoff)
-                *tsoff = pos;
-            return tspec;
-        }
-
-        pos += sizeof(blob_typespec) + tspec->ts_symbols * sizeof(blob_idx);
-    }
+    if (tsoff)
+        *tsoff = m_tspec_offsets[tsidx];
 
-    return nullptr;
+    return (blob_typespec const*) (M_section(BLOB_ST_TSPECS).data + m_tspec_offsets[tsidx]);
 }
 
 std::size_t Blob::typeSpecCount() const
 {
-    blob_shdr* tspecs = M_findSectionHeader(BLOB_ST_TSPECS);
-    if (!tspecs)
-        return 0;
-
-    std::shared_ptr<Buffer> data = M_sectionData(tspecs);
-    if (!data)
-        return 0;
-
-    blob_idx idx = 0;
-    for (std::size_t pos = 0; pos < tspecs->sh_size; ++idx)
-    {
-        blob_typespec* tspec = (blob_typespec*) data->raw(pos, sizeof(blob_typespec));
-        pos += sizeof(blob_typespec) + tspec->ts_symbols * sizeof(blob_idx);
-    }
-
-    return idx;
-}
-
-blob_typespec* Blob::addTypeSpec(std::string const& name, blob_idx* tsidx)
-{
-    // First of all, allocate the name entry
-    blob_off name_off;
-    if (!addString(name, name_off))
-        return nullptr;
-
-    // Get (or create if necessary) the TSPECS section
-    blob_shdr* tspecs = M_findSectionHeader(BLOB_ST_TSPECS);
-    if (!tspecs)
-    {
-        tspecs = M_createSectionHeader();
-        if (!tspecs)
-            return nullptr;
-        tspecs->sh_type = BLOB_ST_TSPECS;
-    }
-
-    if (tsidx)
-        *tsidx = typeSpecCount();
-
-    std::shared_ptr<Buffer> data = M_growSection(tspecs, sizeof(blob_typespec));
-    if (!data)
-        return nullptr;
-
-    blob_typespec* tspec = (blob_typespec*) data->raw(0, sizeof(blob_typespec));
-    tspec->ts_name = name_off;
-    tspec->ts_symbols = 0;
-
-    return tspec;
-}
-
-bool Blob::addTypeSpecSymbol(blob_idx tsidx, blob_idx symidx)
-{
-    // Get the TSPECS section
-    blob_shdr* tspecs = M_findSectionHeader(BLOB_ST_TSPECS);
-    if (!tspecs)
-        return false;
-
-    blob_off tsoff;
-    blob_typespec* tspec = typeSpec(tsidx, &tsoff);
-    if (!tspec)
-        return false;
-
-    blob_off doff = tsoff + sizeof(blob_typespec) + tspec->ts_symbols * sizeof(blob_idx);
-    ++tspec->ts_symbols;
-
-    std::shared_ptr<Buffer> data = M_growSection(tspecs, sizeof(blob_idx), doff);
-    if (!data)
-        return false;
-
-    if (!data->copy(0, (uint8_t*) &symidx, sizeof(blob_idx)))
-        return false;
-
-    return true;
+    return m_tspec_offsets.size();
 }
 
-blob_signature* Blob::signature(blob_idx sigidx, blob_off* sigoff) const
+blob_signature const* Blob::signature(blob_idx sigidx, blob_off* sigoff) const
 {
-    blob_shdr* signatures = M_findSectionHeader(BLOB_ST_SIGNATURES);
-    if (!signatures)
+    if (sigidx >= m_signature_offsets.size())
         return nullptr;
 
-    std::shared_ptr<Buffer> data = M_sectionData(signatures);
-    if (!data)
-        return nullptr;
-
-    blob_idx idx = 0;
-    for (std::size_t pos = 0; pos < signatures->sh_size; ++idx)
-    {
-        blob_signature* sig = (blob_signature*) data->raw(pos, sizeof(blob_signature));
-        if (idx == sigidx)
-        {
-            if (sigoff)
-                *sigoff = pos;
-            return sig;
-        }
-
-        pos += sizeof(blob_signature) + sig->si_argc * sizeof(blob_long);
-    }
+    if (sigoff)
+        *sigoff = m_signature_offsets[sigidx];
 
-    return nullptr;
+    return (blob_signature const*) (M_section(BLOB_ST_SIGNATURES).data + m_signature_offsets[sigidx]);
 }
 
 std::size_t Blob::signatureCount() const
 {
-    blob_shdr* signatures = M_findSectionHeader(BLOB_ST_SIGNATURES);
-    if (!signatures)
-        return 0;
-
-    std::shared_ptr<Buffer> data = M_sectionData(signatures);
-    if (!data)
-        return 0;
-
-    blob_idx idx = 0;
-    for (std::size_t pos = 0; pos < signatures->sh_size; ++idx)
-    {
-        blob_signature* sig = (blob_signature*) data->raw(pos, sizeof(blob_signature));
-        pos += sizeof(blob_signature) + sig->si_argc * sizeof(blob_long);
-    }
-
-    return idx;
-}
-
-bool Blob::addSignature(blob_idx& sigidx)
-{
-    // Get (or create if necessary) the SIGNATURES section
-    blob_shdr* signatures = M_findSectionHeader(BLOB_ST_SIGNATURES);
-    if (!signatures)
-    {
-        signatures = M_createSectionHeader();
-        if (!signatures)
-            return false;
-        signatures->sh_type = BLOB_ST_SIGNATURES;
-    }
-
-    sigidx = signatureCount();
-
-    std::shared_ptr<Buffer> data = M_growSection(signatures, sizeof(blob_signature));
-    if (!data)
-        return false;
-
-    blob_signature* sig = (blob_signature*) data->raw(0, sizeof(blob_signature));
-    sig->si_argc = 0;
-
-    return true;
-}
-
-bool Blob::addSignatureArgument(blob_idx sigidx, blob_long classid)
-{
-    // Get the SIGNATURES section
-    blob_shdr* signatures = M_findSectionHeader(BLOB_ST_SIGNATURES);
-    if (!signatures)
-        return false;
-
-    blob_off sigoff;
-    blob_signature* sig = signature(sigidx, &sigoff);
-    if (!sig)
-        return false;
-
-    blob_off doff = sigoff + sizeof(blob_signature) + sig->si_argc * sizeof(blob_long);
-    ++sig->si_argc;
-
-    std::shared_ptr<Buffer> data = M_growSection(signatures, sizeof(blob_long), doff);
-    if (!data)
-        return false;
-
-    if (!data->copy(0, (uint8_t*) &classid, sizeof(blob_long)))
-        return false;
-
-    return true;
+    return m_signature_offsets.size();
 }
 
-blob_constant* Blob::constant(blob_idx cstidx) const
+blob_constant const* Blob::constant(blob_idx cstidx) const
 {
-    blob_shdr* constants = M_findSectionHeader(BLOB_ST_CONSTANTS);
-    if (!constants)
-        return nullptr;
-
-    if (cstidx >= constants->sh_size / sizeof(blob_constant))
-        return nullptr;
-
-    std::shared_ptr<Buffer> data = M_sectionData(constants);
-    if (!data)
+    if (cstidx >= constantCount())
         return nullptr;
 
-    return (blob_constant*) data->raw(cstidx * sizeof(blob_constant), sizeof(blob_constant));
+    return (blob_constant const*) M_section(BLOB_ST_CONSTANTS).data + cstidx;
 }
 
-blob_constant* Blob::addConstant(blob_long classid, std::string const& serialized, blob_idx* cstidx)
+std::size_t Blob::constantCount() const
 {
-    blob_off serialized_off;
-    if (!addString(serialized, serialized_off))
-        return nullptr;
-
-    blob_constant* already_there = nullptr;
-    foreachConstant([&](blob_idx idx, blob_constant* cst)
-    {
-        if (cst->c_classid == classid && cst->c_serialized == serialized_off)
-        {
-            already_there = cst;
-            if (cstidx)
-                *cstidx = idx;
-        }
-    });
-
-    if (already_there)
-        return already_there;
-
-    // Get (or create if necessary) the SYMBOLS section
-    blob_shdr* constants = M_findSectionHeader(BLOB_ST_CONSTANTS);
-    if (!constants)
-    {
-        constants = M_createSectionHeader();
-        if (!constants)
-            return nullptr;
-        constants->sh_type = BLOB_ST_CONSTANTS;
-    }
-
-    if (cstidx)
-        *cstidx = (int) (constants->sh_size / sizeof(blob_constant));
-
-    std::shared_ptr<Buffer> data = M_growSection(constants, sizeof(blob_constant));
-    if (!data)
-        return nullptr;
-
-    blob_constant* cst = (blob_constant*) data->raw(0, sizeof(blob_constant));
-    cst->c_classid = classid;
-    cst->c_serialized = serialized_off;
-
-    return cst;
-}
-
-bool Blob::setText(Buffer* buffer)
-{
-    if (!buffer)
-        return false;
-
-    // Create the TEXT section
-    blob_shdr* text = M_findSectionHeader(BLOB_ST_TEXT);
-    if (!text)
-    {
-        text = M_createSectionHeader();
-        if (!text)
-            return false;
-        text->sh_type = BLOB_ST_TEXT;
-    }
-    else
-        return false;
-
-    std::shared_ptr<Buffer> data = M_growSection(text, buffer->size());
-    if (!data)
-        return false;
-
-    for (int i = 0; i < (int) buffer->size(); ++i)
-        data->at(i) = buffer->at(i);
-
-    return true;
+    return M_section(BLOB_ST_CONSTANTS).size / sizeof(blob_constant);
 }
 
 std::shared_ptr<Buffer> Blob::text() const
 {
-    blob_shdr* text = M_findSectionHeader(BLOB_ST_TEXT);
-    if (!text)
+    M_Section const& text = M_section(BLOB_ST_TEXT);
+    if (!text.data)
         return nullptr;
 
-    return std::shared_ptr<Buffer>(m_buffer->sub(text->sh_offset, text->sh_size));
+    return std::shared_ptr<Buffer>(m_buffer->sub(text.data - m_raw, text.size));
 }
 
-blob_debug_header* Blob::setDebugHeader(std::string const& file)
+blob_debug_header const* Blob::debugHeader() const
 {
-    // Add the file name
-    blob_idx file_sidx;
-    if (!addString(file, file_sidx))
-        return nullptr;
-
-    // Create the DEBUG section
-    blob_shdr* debug = M_findSectionHeader(BLOB_ST_DEBUG);
-    if (!debug)
-    {
-        debug = M_createSectionHeader();
-        if (!debug)
-            return nullptr;
-        debug->sh_type = BLOB_ST_DEBUG;
-    }
-    else
+    M_Section const& debug = M_section(BLOB_ST_DEBUG);
+    if (debug.size < sizeof(blob_debug_header))
         return nullptr;
 
-    std::shared_ptr<Buffer> data = M_growSection(debug, sizeof(blob_debug_header));
-    if (!data)
-        return nullptr;
-
-    blob_debug_header* header = (blob_debug_header*) data->raw(0, sizeof(blob_debug_header));
-    header->d_file = file_sidx;
-    header->d_count = 0;
-    return header;
+    return (blob_debug_header const*) debug.data;
 }
 
-blob_debug_header* Blob::debugHeader() const
+bool Blob::debugEntry(blob_off addr, blob_debug_entry& entry) const
 {
-    blob_shdr* debug = M_findSectionHeader(BLOB_ST_DEBUG);
-    if (!debug)
-        return nullptr;
+    bool found = false;
 
-    std::shared_ptr<Buffer> data = M_sectionData(debug);
-    if (!data)
-        return nullptr;
+    blob_debug_header const* header = debugHeader();
+    if (!header || !header->d_count)
+        return false;
 
-    return (blob_debug_header*) data->raw(0, sizeof(blob_debug_header));
-}
+    blob_len size;
+    uint8_t const* table = M_debugTable(size);
+    if (!table)
+        return false;
 
-blob_debug_entry* Blob::addDebugEntry(blob_off line, blob_off col, blob_len extent, blob_idx* deidx)
-{
-    blob_debug_entry* already_there = nullptr;
-    foreachDebugEntry([&](blob_idx idx, blob_debug_entry* entry)
+    blob_debug_entry current = { 0, 0, 0, 0 };
+    std::size_t pos = 0;
+    for (int i = 0; i < (int) header->d_count; ++i)
     {
-        if (entry->de_line == line && entry->de_col == col)
+        if (!M_decodeDebugEntry(table, size, pos, current))
+            break;
+        if (current.de_addr >= addr)
         {
-            already_there = entry;
-            if (deidx)
-                *deidx = idx;
+            found = current.de_addr == addr;
+            break;
         }
-    });
-
-    if (already_there)
-        return already_there;
-
-    blob_shdr* debug = M_findSectionHeader(BLOB_ST_DEBUG);
-    if (!debug)
-        return nullptr;
-
-    blob_debug_header* header = debugHeader();
-    if (!header)
-        return nullptr;
-    int idx = header->d_count++;
-
-    if (deidx)
-        *deidx = idx;
-
-    std::shared_ptr<Buffer> data = M_growSection(debug, sizeof(blob_debug_entry));
-    if (!data)
-        return nullptr;
-
-    blob_debug_entry* entry = (blob_debug_entry*) data->raw(0, sizeof(blob_debug_entry));
-    entry->de_line = line;
-    entry->de_col = col;
-    entry->de_extent = extent;
+    }
 
-    return entry;
+    if (found)
+        entry = current;
+    return found;
 }
 
-blob_debug_entry* Blob::debugEntry(blob_idx deidx) const
+void Blob::M_load()
 {
-    blob_shdr* debug = M_findSectionHeader(BLOB_ST_DEBUG);
-    if (!debug)
-        return nullptr;
-
-    blob_debug_header* header = debugHeader();
-    if (!header)
-        return nullptr;
-
-    if (deidx >= header->d_count)
-        return nullptr;
-
-    std::shared_ptr<Buffer> data = M_sectionData(debug);
-    if (!data)
-        return nullptr;
-
-    return (blob_debug_entry*) data->raw(sizeof(blob_debug_header) + deidx * sizeof(blob_debug_entry), sizeof(blob_debug_entry));
-}
+    m_raw = nullptr;
+    std::memset(m_sections, 0, sizeof(m_sections));
+    m_tspec_offsets.clear();
+    m_signature_offsets.clear();
 
-void Blob::foreachString(std::function<void(blob_idx, std::string const&)> const& action) const
-{
-    blob_shdr* strings = M_findSectionHeader(BLOB_ST_STRINGS);
-    if (!strings)
+    if (!m_buffer || m_buffer->size() < sizeof(blob_hdr))
         return;
 
-    std::shared_ptr<Buffer> data = M_sectionData(strings);
-    if (!data)
+    // A contiguous buffer gives its raw pointer without copying
+    m_raw = m_buffer->view(0, m_buffer->size());
+    if (!m_raw || !check())
         return;
 
-    for (std::size_t pos = 0; pos < strings->sh_size;)
+    // The first section of each type is the one used
+    blob_hdr const* hdr = M_header();
+    for (blob_idx i = hdr->h_shnum; i-- > 1;)
     {
-        std::size_t len = 1;
-        for (int i = 0; i < (int) (strings->sh_size - pos); ++i, ++len)
-            if (!data->at(pos + i))
-                break;
-
-        std::string str = (const char*) data->raw(pos, len);
-        action(pos, str);
+        blob_shdr const* shdr = M_sectionHeader(i);
+        if (shdr->sh_type <= BLOB_ST_NULL || shdr->sh_type > BLOB_ST_DEBUG || !shdr->sh_size)
+            continue;
 
-        pos += len;
+        m_sections[shdr->sh_type].data = m_raw + shdr->sh_offset;
+        m_sections[shdr->sh_type].size = shdr->sh_size;
     }
-}
-
-void Blob::foreachSymbol(std::function<void(blob_idx, blob_symbol*)> const& action) const
-{
-    blob_shdr* symbols = M_findSectionHeader(BLOB_ST_SYMBOLS);
-    if (!symbols)
-        return;
-
-    int count = (int) (symbols->sh_size / sizeof(blob_symbol));
-    for (int i = 0; i < count; ++i)
-        action(i, symbol(i));
-}
-
-void Blob::foreachTypeSpec(std::function<void(blob_idx, blob_typespec*)> const& action) const
-{
-    int count = (int) typeSpecCount();
-    for (int i = 0; i < count; ++i)
-        action(i, typeSpec(i));
-}
-
-bool Blob::foreachTypeSpecSymbol(blob_idx tsidx, std::function<void(blob_idx)> const& action) const
-{
-    // Get the TSPECS section
-    blob_shdr* tspecs = M_findSectionHeader(BLOB_ST_TSPECS);
-    if (!tspecs)
-        return false;
-
-    std::shared_ptr<Buffer> data = M_sectionData(tspecs);
-    if (!data)
-        return false;
-
-    blob_off tsoff;
-    blob_typespec* tspec = typeSpec(tsidx, &tsoff);
-    if (!tspec)
-        return false;
 
-    for (int i = 0; i < (int) tspec->ts_symbols; ++i)
+    // Index variable sized entries once and for all
+    M_Section const& tspecs = m_sections[BLOB_ST_TSPECS];
+    for (std::size_t pos = 0; pos + sizeof(blob_typespec) <= tspecs.size;)
     {
-        blob_off off = tsoff + sizeof(blob_typespec) + i * sizeof(blob_idx);
-        action(*((blob_idx*) data->raw(off, sizeof(blob_idx))));
+        blob_typespec const* tspec = (blob_typespec const*) (tspecs.data + pos);
+        m_tspec_offsets.push_back((blob_off) pos);
+        pos += sizeof(blob_typespec) + tspec->ts_symbols * sizeof(blob_idx);
     }
 
-    return true;
-}
-
-void Blob::foreachSignature(std::function<void(blob_idx, blob_signature*)> const& action) const
-{
-    int count = (int) signatureCount();
-    for (int i = 0; i < count; ++i)
-        action(i, signature(i));
-}
-
-bool Blob::foreachSignatureArgument(blob_idx sigidx, std::function<void(blob_long)> const& action) const
-{
-    // Get the SIGNATURES section
-    blob_shdr* signatures = M_findSectionHeader(BLOB_ST_SIGNATURES);
-    if (!signatures)
-        return false;
-
-    std::shared_ptr<Buffer> data = M_sectionData(signatures);
-    if (!data)
-        return false;
-
-    blob_off sigoff;
-    blob_signature* sig = signature(sigidx, &sigoff);
-    if (!sig)
-        return false;
-
-    for (int i = 0; i < (int) sig->si_argc; ++i)
+    M_Section const& signatures = m_sections[BLOB_ST_SIGNATURES];
+    for (std::size_t pos = 0; pos + sizeof(blob_signature) <= signatures.size;)
     {
-        blob_off off = sigoff + sizeof(blob_signature) + i * sizeof(blob_long);
-        action(*((blob_long*) data->raw(off, sizeof(blob_long))));
+        blob_signature const* sig = (blob_signature const*) (signatures.data + pos);
+        m_signature_offsets.push_back((blob_off) pos);
+        pos += sizeof(blob_signature) + sig->si_argc * sizeof(blob_long);
     }
-
-    return true;
-}
-
-void Blob::foreachConstant(std::function<void(blob_idx, blob_constant*)> const& action) const
-{
-    blob_shdr* constants = M_findSectionHeader(BLOB_ST_CONSTANTS);
-    if (!constants)
-        return;
-
-    int count = (int) (constants->sh_size / sizeof(blob_constant));
-    for (int i = 0; i < count; ++i)
-        action(i, constant(i));
-}
-
-void Blob::foreachDebugEntry(std::function<void(blob_idx, blob_debug_entry*)> const& action) const
-{
-    blob_shdr* debug = M_findSectionHeader(BLOB_ST_DEBUG);
-    if (!debug)
-        return;
-
-    blob_debug_header* header = debugHeader();
-    if (!header)
-        return;
-
-    for (int i = 0; i < (int) header->d_count; ++i)
-        action(i, debugEntry(i));
-}
-
-blob_hdr* Blob::M_header() const
-{
-    return (blob_hdr*) m_buffer->raw(0, sizeof(blob_hdr));
 }
 
-blob_shdr* Blob::M_sectionHeader(blob_idx sidx) const
+blob_hdr const* Blob::M_header() const
 {
-    blob_hdr* hdr = M_header();
-    if (!hdr || sidx >= hdr->h_shnum)
+    if (!m_raw)
         return nullptr;
 
-    return (blob_shdr*) m_buffer->raw(hdr->h_shoff + sidx * sizeof(blob_shdr), sizeof(blob_shdr));
-}
-
-blob_idx Blob::M_sectionIndex(blob_shdr* shdr) const
-{
-    blob_hdr* hdr = M_header();
-    if (!hdr || !shdr)
-        return false;
-
-    return (blob_idx) (shdr - (blob_shdr*) m_buffer->raw(hdr->h_shoff, sizeof(blob_shdr)));
-}
-
-std::shared_ptr<Buffer> Blob::M_sectionData(blob_idx sidx) const
-{
-    return M_sectionData(M_sectionHeader(sidx));
+    return (blob_hdr const*) m_raw;
 }
 
-std::shared_ptr<Buffer> Blob::M_sectionData(blob_shdr* shdr) const
+blob_shdr const* Blob::M_sectionHeader(blob_idx sidx) const
 {
-    if (!shdr || !shdr->sh_offset || !shdr->sh_size)
+    blob_hdr const* hdr = M_header();
+    if (!hdr || sidx >= hdr->h_shnum)
         return nullptr;
 
-    return std::shared_ptr<Buffer>(m_buffer->sub(shdr->sh_offset, shdr->sh_size));
+    return (blob_shdr const*) (m_raw + hdr->h_shoff) + sidx;
 }
 
-blob_idx Blob::M_findSectionIndex(blob_shtype type) const
+Blob::M_Section const& Blob::M_section(blob_shtype type) const
 {
-    blob_hdr* hdr = M_header();
-    if (!hdr)
-        return 0;
-
-    for (int i = 0; i < (int) hdr->h_shnum; ++i)
-    {
-        if (M_sectionHeader(i)->sh_type == type)
-            return i;
-    }
-
-    return 0;
+    return m_sections[type];
 }
 
-blob_shdr* Blob::M_findSectionHeader(blob_shtype type) const
+uint8_t const* Blob::M_debugTable(blob_len& size) const
 {
-    blob_idx idx = M_findSectionIndex(type);
-    if (!idx)
+    M_Section const& debug = M_section(BLOB_ST_DEBUG);
+    if (debug.size < sizeof(blob_debug_header))
         return nullptr;
 
-    return M_sectionHeader(idx);
+    size = debug.size - sizeof(blob_debug_header);
+    return debug.data + sizeof(blob_debug_header);
 }
 
-bool Blob::M_createHeader()
+bool Blob::M_decodeDebugEntry(uint8_t const* table, blob_len size, std::size_t& pos, blob_debug_entry& entry)
 {
-    if (m_buffer->size())
+    uint8_t const* end = table + size;
+    uint32_t addr;
+    int32_t line;
+    if (!uleb128_decode(table, pos, end, addr) ||
+        !sleb128_decode(table, pos, end, line) ||
+        !uleb128_decode(table, pos, end, entry.de_col) ||
+        !uleb128_decode(table, pos, end, entry.de_extent))
         return false;
 
-    if (!m_buffer->inject(0, sizeof(blob_hdr)))
-        return false;
-
-    blob_hdr* hdr = M_header();
-    if (!hdr)
-        return false;
-
-    hdr->h_magic = BLOB_MAGIC;
-    hdr->h_version = BLOB_VERSION;
-    hdr->h_shoff = 0;
-    hdr->h_shnum = 0;
-
+    entry.de_addr += addr;
+    entry.de_line += line;
     return true;
 }
-
-blob_shdr* Blob::M_createSectionHeader(blob_idx* sidx)
-{
-    if (!m_buffer->size())
-        M_createHeader();
-
-    blob_hdr* hdr = M_header();
-    if (!hdr)
-        return nullptr;
-
-    // If empty, create the first NULL section
-    if (!hdr->h_shnum)
-    {
-        hdr->h_shnum = 1;
-        hdr->h_shoff = sizeof(blob_hdr);
-
-        blob_shdr shdr = { BLOB_ST_NULL, 0, 0 };
-        if (!m_buffer->inject(sizeof(blob_hdr), sizeof(blob_shdr)))
-            return nullptr;
-
-        if (!m_buffer->copy(sizeof(blob_hdr), (uint8_t*) &shdr, sizeof(blob_shdr)))
-            return nullptr;
-
-        hdr = M_header();
-        if (!hdr)
-            return nullptr;
-    }
-
-    // Save the new section's index
-    blob_idx new_sidx = hdr->h_shnum++;
-
-    // We will insert the header at this position
-    std::size_t inject_at = sizeof(blob_hdr) + new_sidx * sizeof(blob_shdr);
-
-    // Shift any section which has data after the insertion point
-    for (int i = 0; i < (int) new_sidx; ++i)
-    {
-        blob_shdr* shdr = M_sectionHeader(i);
-        if (!shdr)
-            return nullptr;
-
-        if (shdr->sh_offset >= inject_at)
-            shdr->sh_offset += sizeof(blob_shdr);
-    }
-
-    if (!m_buffer->inject(inject_at, sizeof(blob_shdr)))
-        return nullptr;
-
-    blob_shdr shdr = { BLOB_ST_NULL, 0, 0 };
-    if (!m_buffer->copy(inject_at, (uint8_t*) &shdr, sizeof(blob_shdr)))
-        return nullptr;
-
-    if (sidx)
-        *sidx = new_sidx;
-
-    return M_sectionHeader(new_sidx);
-}
-
-std::shared_ptr<Buffer> Blob::M_growSection(blob_idx sidx, blob_len amount, long doff)
-{
-    return M_growSection(M_sectionHeader(sidx), amount, doff);
-}
-
-std::shared_ptr<Buffer> Blob::M_growSection(blob_shdr* shdr, blob_len amount, long doff)
-{
-    if (!shdr)
-        return 0;
-
-    blob_hdr* hdr = M_header();
-    if (!hdr)
-        return 0;
-
-    // If the section is empty, make it start at the end of the buffer
-    if (!shdr->sh_offset)
-        shdr->sh_offset = m_buffer->size();
-
-    // We will insert the new data at this position in the buffer
-    std::size_t inject_at = shdr->sh_offset + (doff >= 0 ? doff : shdr->sh_size);
-
-    // Shift any section which has data after the insertion point
-    for (int i = 0; i < (int) hdr->h_shnum; ++i)
-    {
-        blob_shdr* shdr = M_sectionHeader(i);
-        if (!shdr)
-            return nullptr;
-        if (shdr->sh_offset >= inject_at && shdr->sh_size)
-            shdr->sh_offset += amount;
-    }
-
-    shdr->sh_size += amount;
-
-    if (!m_buffer->inject(inject_at, amount))
-        return nullptr;
-
-    return std::shared_ptr<Buffer>(m_buffer->sub(inject_at, amount));
-}
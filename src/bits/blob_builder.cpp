@@ -0,0 +1,339 @@
+/*  This file is part of Axolotl.
+ *
+ * Axolotl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Axolotl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Axolotl.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "bits/blob_builder.hpp"
+#include "bits/basic_buffer.hpp"
+#include "bits/leb128.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+using namespace bits;
+
+std::size_t BlobBuilder::M_ConstantHash::operator()(std::pair<blob_long, blob_long> const& key) const
+{
+    return std::hash<blob_long>()(key.first) ^ (std::hash<blob_long>()(key.second) << 1);
+}
+
+BlobBuilder::BlobBuilder()
+    : m_module_name(0)
+    , m_has_text(false)
+    , m_has_debug(false)
+    , m_debug_header({ 0, 0, 0, 0 })
+{}
+
+BlobBuilder::~BlobBuilder()
+{}
+
+bool BlobBuilder::setModuleName(std::string const& module_name)
+{
+    return addString(module_name, m_module_name);
+}
+
+bool BlobBuilder::addString(std::string const& str, blob_off& off)
+{
+    auto found = m_string_index.find(str);
+    if (found != m_string_index.end())
+    {
+        off = found->second;
+        return true;
+    }
+
+    off = (blob_off) m_strings.size();
+    m_strings.append(str.c_str(), str.size() + 1);
+    m_string_index.insert(std::make_pair(str, off));
+
+    return true;
+}
+
+bool BlobBuilder::findString(std::string const& str, blob_off* soff) const
+{
+    auto found = m_string_index.find(str);
+    if (found == m_string_index.end())
+        return false;
+
+    if (soff)
+        *soff = found->second;
+    return true;
+}
+
+blob_symbol* BlobBuilder::addSymbol(std::string const& name, blob_idx* symidx)
+{
+    blob_off name_off;
+    if (!addString(name, name_off))
+        return nullptr;
+
+    if (symidx)
+        *symidx = (blob_idx) m_symbols.size();
+
+    blob_symbol sym = { name_off, BLOB_SYMT_NULL, BLOB_SYMB_NULL, 0, 0, 0 };
+    m_symbols.push_back(sym);
+
+    return &m_symbols.back();
+}
+
+blob_typespec* BlobBuilder::addTypeSpec(std::string const& name, blob_idx* tsidx)
+{
+    blob_off name_off;
+    if (!addString(name, name_off))
+        return nullptr;
+
+    if (tsidx)
+        *tsidx = (blob_idx) m_tspecs.size();
+
+    M_TypeSpec tspec;
+    tspec.header.ts_name = name_off;
+    tspec.header.ts_symbols = 0;
+    m_tspecs.push_back(tspec);
+
+    return &m_tspecs.back().header;
+}
+
+bool BlobBuilder::addTypeSpecSymbol(blob_idx tsidx, blob_idx symidx)
+{
+    if (tsidx >= m_tspecs.size())
+        return false;
+
+    M_TypeSpec& tspec = m_tspecs[tsidx];
+    tspec.symbols.push_back(symidx);
+    ++tspec.header.ts_symbols;
+
+    return true;
+}
+
+bool BlobBuilder::addSignature(blob_idx& sigidx)
+{
+    sigidx = (blob_idx) m_signatures.size();
+    m_signatures.push_back(std::vector<blob_long>());
+
+    return true;
+}
+
+bool BlobBuilder::addSignatureArgument(blob_idx sigidx, blob_long classid)
+{
+    if (sigidx >= m_signatures.size())
+        return false;
+
+    m_signatures[sigidx].push_back(classid);
+    return true;
+}
+
+blob_constant* BlobBuilder::addConstant(blob_long classid, blob_cstkind kind, blob_long value, blob_idx* cstidx)
+{
+    // The kind is not part of the key, as it only depends on the class
+    auto key = std::make_pair(classid, value);
+    auto found = m_constant_index.find(key);
+    if (found != m_constant_index.end())
+    {
+        if (cstidx)
+            *cstidx = found->second;
+        return &m_constants[found->second];
+    }
+
+    blob_idx idx = (blob_idx) m_constants.size();
+    if (cstidx)
+        *cstidx = idx;
+
+    blob_constant cst = { classid, kind, value };
+    m_constants.push_back(cst);
+    m_constant_index.insert(std::make_pair(key, idx));
+
+    return &m_constants.back();
+}
+
+blob_constant* BlobBuilder::addConstant(blob_long classid, std::string const& serialized, blob_idx* cstidx)
+{
+    blob_off serialized_off;
+    if (!addString(serialized, serialized_off))
+        return nullptr;
+
+    return addConstant(classid, BLOB_CST_SERIALIZED, serialized_off, cstidx);
+}
+
+bool BlobBuilder::setText(Buffer* buffer)
+{
+    if (!buffer || m_has_text)
+        return false;
+
+    m_has_text = true;
+    if (!buffer->size())
+        return true;
+
+    uint8_t* raw = buffer->raw(0, buffer->size());
+    if (!raw)
+        return false;
+
+    m_text.assign(raw, raw + buffer->size());
+    return true;
+}
+
+blob_debug_header* BlobBuilder::setDebugHeader(std::string const& file)
+{
+    if (m_has_debug)
+        return nullptr;
+
+    blob_off file_off;
+    if (!addString(file, file_off))
+        return nullptr;
+
+    m_has_debug = true;
+    m_debug_header.d_file = file_off;
+    m_debug_header.d_count = 0;
+    m_debug_header.d_last_addr = 0;
+    m_debug_header.d_last_line = 0;
+
+    return &m_debug_header;
+}
+
+bool BlobBuilder::addDebugEntry(blob_off addr, blob_off line, blob_off col, blob_len extent)
+{
+    if (!m_has_debug)
+        return false;
+
+    // Entries must be sorted by address
+    if (m_debug_header.d_count && addr <= m_debug_header.d_last_addr)
+        return false;
+
+    uint8_t raw[4 * LEB128_MAX];
+    std::size_t len = 0;
+    len += uleb128_encode(addr - m_debug_header.d_last_addr, raw + len);
+    len += sleb128_encode((int32_t) line - (int32_t) m_debug_header.d_last_line, raw + len);
+    len += uleb128_encode(col, raw + len);
+    len += uleb128_encode(extent, raw + len);
+
+    m_debug_table.insert(m_debug_table.end(), raw, raw + len);
+
+    ++m_debug_header.d_count;
+    m_debug_header.d_last_addr = addr;
+    m_debug_header.d_last_line = line;
+
+    return true;
+}
+
+Blob BlobBuilder::build() const
+{
+    std::size_t tspecs_size = 0;
+    for (auto const& tspec : m_tspecs)
+        tspecs_size += sizeof(blob_typespec) + tspec.symbols.size() * sizeof(blob_idx);
+
+    std::size_t signatures_size = 0;
+    for (auto const& sig : m_signatures)
+        signatures_size += sizeof(blob_signature) + sig.size() * sizeof(blob_long);
+
+    // Sections are laid out in this order, empty ones are left out
+    std::vector<blob_shdr> sections;
+    auto section = [&](blob_shtype type, std::size_t size, bool present)
+    {
+        if (present)
+            sections.push_back({ type, 0, (blob_len) size });
+    };
+
+    section(BLOB_ST_STRINGS, m_strings.size(), !m_strings.empty());
+    section(BLOB_ST_TEXT, m_text.size(), m_has_text);
+    section(BLOB_ST_SYMBOLS, m_symbols.size() * sizeof(blob_symbol), !m_symbols.empty());
+    section(BLOB_ST_TSPECS, tspecs_size, !m_tspecs.empty());
+    section(BLOB_ST_SIGNATURES, signatures_size, !m_signatures.empty());
+    section(BLOB_ST_CONSTANTS, m_constants.size() * sizeof(blob_constant), !m_constants.empty());
+    section(BLOB_ST_DEBUG, sizeof(blob_debug_header) + m_debug_table.size(), m_has_debug);
+
+    blob_len shnum = (blob_len) sections.size() + 1;
+    std::size_t size = sizeof(blob_hdr) + shnum * sizeof(blob_shdr);
+    for (auto& shdr : sections)
+    {
+        shdr.sh_offset = (blob_off) size;
+        size += shdr.sh_size;
+    }
+
+    BasicBuffer* buffer = new BasicBuffer();
+    if (!buffer->inject(0, size))
+    {
+        delete buffer;
+        throw std::runtime_error("bits::BlobBuilder::build: can't allocate the blob");
+    }
+
+    uint8_t* raw = buffer->raw(0, size);
+
+    blob_hdr hdr = { BLOB_MAGIC, BLOB_VERSION, sizeof(blob_hdr), shnum, m_module_name };
+    std::memcpy(raw, &hdr, sizeof(blob_hdr));
+
+    // The first section header is the NULL section, left zeroed
+    std::memcpy(raw + sizeof(blob_hdr) + sizeof(blob_shdr), sections.data(), sections.size() * sizeof(blob_shdr));
+
+    for (auto const& shdr : sections)
+    {
+        uint8_t* data = raw + shdr.sh_offset;
+
+        switch (shdr.sh_type)
+        {
+            case BLOB_ST_STRINGS:
+                std::memcpy(data, m_strings.data(), m_strings.size());
+                break;
+
+            case BLOB_ST_TEXT:
+                if (!m_text.empty())
+                    std::memcpy(data, m_text.data(), m_text.size());
+                break;
+
+            case BLOB_ST_SYMBOLS:
+                std::memcpy(data, m_symbols.data(), shdr.sh_size);
+                break;
+
+            case BLOB_ST_TSPECS:
+                for (auto const& tspec : m_tspecs)
+                {
+                    std::memcpy(data, &tspec.header, sizeof(blob_typespec));
+                    data += sizeof(blob_typespec);
+
+                    // data() may be null when empty, memcpy must not get it
+                    if (!tspec.symbols.empty())
+                        std::memcpy(data, tspec.symbols.data(), tspec.symbols.size() * sizeof(blob_idx));
+                    data += tspec.symbols.size() * sizeof(blob_idx);
+                }
+                break;
+
+            case BLOB_ST_SIGNATURES:
+                for (auto const& sig : m_signatures)
+                {
+                    blob_signature header = { (blob_len) sig.size() };
+                    std::memcpy(data, &header, sizeof(blob_signature));
+                    data += sizeof(blob_signature);
+
+                    if (!sig.empty())
+                        std::memcpy(data, sig.data(), sig.size() * sizeof(blob_long));
+                    data += sig.size() * sizeof(blob_long);
+                }
+                break;
+
+            case BLOB_ST_CONSTANTS:
+                if (!m_constants.empty())
+                    std::memcpy(data, m_constants.data(), shdr.sh_size);
+                break;
+
+            case BLOB_ST_DEBUG:
+                std::memcpy(data, &m_debug_header, sizeof(blob_debug_header));
+                if (!m_debug_table.empty())
+                    std::memcpy(data + sizeof(blob_debug_header), m_debug_table.data(), m_debug_table.size());
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    // The blob locates its sections once they are all written
+    return Blob(buffer);
+}
@@ -0,0 +1,283 @@
+/*  This file is part of Axolotl.
+ *
+ * Axolotl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Axolotl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Axolotl.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "bits/chunked_buffer.hpp"
+#include "bits/basic_buffer.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace bits;
+
+//! A sub-buffer, it reads and writes through its parent
+class ChunkedBuffer::Slice : public Buffer
+{
+public:
+    Slice(ChunkedBuffer* parent, std::size_t offset, std::size_t size)
+        : m_parent(parent)
+        , m_offset(offset)
+        , m_size(size)
+    {}
+
+    Buffer* copy() const
+    {
+        BasicBuffer* cpy = new BasicBuffer();
+        if (m_size && cpy->inject(0, m_size))
+            cpy->copy(0, m_parent->raw(m_offset, m_size), m_size);
+        return cpy;
+    }
+
+    bool readonly() const
+    { return m_parent->readonly(); }
+
+    std::size_t size() const
+    { return m_size; }
+
+    uint8_t at(std::size_t i) const
+    { return ((ChunkedBuffer const*) m_parent)->at(m_offset + i); }
+
+    uint8_t& at(std::size_t i)
+    { return m_parent->at(m_offset + i); }
+
+    bool inject(std::size_t, std::size_t)
+    { return false; }
+
+    bool copy(std::size_t pos, uint8_t* data, std::size_t length)
+    {
+        if (pos + length > m_size)
+            return false;
+
+        return m_parent->copy(m_offset + pos, data, length);
+    }
+
+    uint8_t* raw(std::size_t pos, std::size_t len)
+    {
+        if (pos + len > m_size)
+            return nullptr;
+
+        return m_parent->raw(m_offset + pos, len);
+    }
+
+    uint8_t const* view(std::size_t pos, std::size_t len)
+    { return raw(pos, len); }
+
+    Buffer* sub(std::size_t pos, std::size_t len)
+    {
+        if (pos + len > m_size)
+            return nullptr;
+
+        return new Slice(m_parent, m_offset + pos, len);
+    }
+
+private:
+    ChunkedBuffer* m_parent;
+    std::size_t m_offset;
+    std::size_t m_size;
+};
+
+ChunkedBuffer::ChunkedBuffer(std::size_t chunk_size)
+    : m_chunk_size(chunk_size ? chunk_size : 1)
+    , m_size(0)
+    , m_window(nullptr)
+    , m_window_start(0)
+    , m_window_size(0)
+{}
+
+ChunkedBuffer::~ChunkedBuffer()
+{}
+
+Buffer* ChunkedBuffer::copy() const
+{
+    BasicBuffer* cpy = new BasicBuffer();
+    if (!m_size || !cpy->inject(0, m_size))
+        return cpy;
+
+    for (std::size_t i = 0; i < m_chunks.size(); ++i)
+    {
+        if (m_chunks[i].size())
+            cpy->copy(m_offsets[i], (uint8_t*) m_chunks[i].data(), m_chunks[i].size());
+    }
+
+    return cpy;
+}
+
+bool ChunkedBuffer::readonly() const
+{
+    return false;
+}
+
+std::size_t ChunkedBuffer::size() const
+{
+    return m_size;
+}
+
+uint8_t ChunkedBuffer::at(std::size_t i) const
+{
+    // Buffers are mostly read sequentially, so the chunk of the
+    //   previous access is tried first
+    if (i - m_window_start >= m_window_size)
+        M_find(i);
+
+    return m_window[i - m_window_start];
+}
+
+uint8_t& ChunkedBuffer::at(std::size_t i)
+{
+    if (i - m_window_start >= m_window_size)
+        M_find(i);
+
+    return m_window[i - m_window_start];
+}
+
+bool ChunkedBuffer::inject(std::size_t pos, std::size_t length)
+{
+    if (pos > m_size)
+        return false;
+
+    if (!length)
+        return true;
+
+    if (m_chunks.empty())
+    {
+        m_chunks.push_back(std::vector<uint8_t>(length, 0));
+        m_offsets.push_back(0);
+        m_size = length;
+        return true;
+    }
+
+    // Growing the end of a chunk is preferred to growing the start of
+    //   the next one, as sections grow at their end
+    std::size_t c = pos ? M_find(pos - 1) : 0;
+    std::vector<uint8_t>& chunk = m_chunks[c];
+    std::size_t off = pos - m_offsets[c];
+
+    if (chunk.size() + length <= m_chunk_size)
+        chunk.insert(chunk.begin() + off, length, 0);
+    else
+    {
+        // Split the chunk at the injection point, so no structure
+        //   written as a whole spans two chunks
+        std::vector<std::vector<uint8_t>> parts;
+        if (off)
+            parts.push_back(std::vector<uint8_t>(chunk.begin(), chunk.begin() + off));
+        parts.push_back(std::vector<uint8_t>(length, 0));
+        if (off < chunk.size())
+            parts.push_back(std::vector<uint8_t>(chunk.begin() + off, chunk.end()));
+
+        m_chunks[c].swap(parts[0]);
+        for (std::size_t i = 1; i < parts.size(); ++i)
+        {
+            m_chunks.insert(m_chunks.begin() + c + i, std::vector<uint8_t>());
+            m_chunks[c + i].swap(parts[i]);
+        }
+        m_offsets.resize(m_chunks.size());
+    }
+
+    m_size += length;
+    M_index(c);
+
+    // Chunks may have moved
+    m_window_size = 0;
+
+    return true;
+}
+
+bool ChunkedBuffer::copy(std::size_t pos, uint8_t* data, std::size_t length)
+{
+    if (pos + length > m_size)
+        return false;
+
+    while (length)
+    {
+        std::size_t c = M_find(pos);
+        std::size_t off = pos - m_offsets[c];
+        std::size_t count = std::min(length, m_chunks[c].size() - off);
+
+        std::memcpy(m_chunks[c].data() + off, data, count);
+        pos += count;
+        data += count;
+        length -= count;
+    }
+
+    return true;
+}
+
+uint8_t* ChunkedBuffer::raw(std::size_t pos, std::size_t len)
+{
+    if (pos + len > m_size || m_chunks.empty())
+        return nullptr;
+
+    if (pos - m_window_start < m_window_size && pos + len - m_window_start <= m_window_size)
+        return m_window + (pos - m_window_start);
+
+    if (pos == m_size)
+        return m_chunks.back().data() + m_chunks.back().size();
+
+    std::size_t first = M_find(pos);
+    std::size_t last = len ? M_find(pos + len - 1) : first;
+    if (first != last)
+        M_join(first, last);
+
+    return m_chunks[first].data() + (pos - m_offsets[first]);
+}
+
+uint8_t const* ChunkedBuffer::view(std::size_t pos, std::size_t len)
+{
+    return raw(pos, len);
+}
+
+Buffer* ChunkedBuffer::sub(std::size_t pos, std::size_t len)
+{
+    if (pos + len > m_size)
+        return nullptr;
+
+    return new Slice(this, pos, len);
+}
+
+std::size_t ChunkedBuffer::M_find(std::size_t pos) const
+{
+    // Last chunk starting at or before `pos'
+    auto it = std::upper_bound(m_offsets.begin(), m_offsets.end(), pos);
+    std::size_t c = (std::size_t) (it - m_offsets.begin()) - 1;
+
+    m_window = (uint8_t*) m_chunks[c].data();
+    m_window_start = m_offsets[c];
+    m_window_size = m_chunks[c].size();
+
+    return c;
+}
+
+void ChunkedBuffer::M_join(std::size_t first, std::size_t last)
+{
+    m_window_size = 0;
+
+    std::vector<uint8_t> joined;
+    joined.reserve(m_offsets[last] + m_chunks[last].size() - m_offsets[first]);
+
+    for (std::size_t i = first; i <= last; ++i)
+        joined.insert(joined.end(), m_chunks[i].begin(), m_chunks[i].end());
+
+    m_chunks[first].swap(joined);
+    m_chunks.erase(m_chunks.begin() + first + 1, m_chunks.begin() + last + 1);
+    m_offsets.erase(m_offsets.begin() + first + 1, m_offsets.begin() + last + 1);
+}
+
+void ChunkedBuffer::M_index(std::size_t from)
+{
+    for (std::size_t i = from; i < m_chunks.size(); ++i)
+        m_offsets[i] = i ? m_offsets[i - 1] + m_chunks[i - 1].size() : 0;
+}
@@ -17,11 +17,13 @@
 #include "bits/disassembler.hpp"
 #include "bits/blob.hpp"
 #include "bits/opcodes.hpp"
+#include "bits/leb128.hpp"
 
 #include <iomanip>
 #include <vector>
 #include <map>
 #include <sstream>
+#include <cstring>
 
 using namespace bits;
 
@@ -40,23 +42,25 @@ void Disassembler::dumpAll()
     m_os << std::endl;
     dumpConstants();
     m_os << std::endl;
+    dumpDebug();
+    m_os << std::endl;
     dumpText();
 }
 
 void Disassembler::dumpStrings()
 {
     m_os << "Strings :" << std::endl;
-    m_blob.foreachString([&](blob_idx sidx, std::string const& str)
+    m_blob.foreachString([&](blob_idx sidx, blob_string const& str)
     {
         m_os << "  [" << std::setw(4) << std::hex << sidx << std::dec << "] ";
-        m_os << str << std::endl;
+        m_os << str.str << std::endl;
     });
 }
 
 void Disassembler::dumpSymbols()
 {
     m_os << "Symbols :" << std::endl;
-    m_blob.foreachSymbol([&](blob_idx symidx, blob_symbol* sym)
+    m_blob.foreachSymbol([&](blob_idx symidx, blob_symbol const* sym)
     {
         m_os << "  [" << std::setw(4) << symidx << "] ";
 
@@ -89,12 +93,12 @@ void Disassembler::dumpSymbols()
 void Disassembler::dumpTypeSpecs()
 {
     m_os << "Type specifications :" << std::endl;
-    m_blob.foreachTypeSpec([&](blob_idx tsidx, blob_typespec* tspec)
+    m_blob.foreachTypeSpec([&](blob_idx tsidx, blob_typespec const* tspec)
     {
         m_os << "  [" << std::setw(4) << tsidx << "] " << m_blob.string(tspec->ts_name) << std::endl;
         m_blob.foreachTypeSpecSymbol(tsidx, [&](blob_idx symidx)
         {
-            blob_symbol* sym = m_blob.symbol(symidx);
+            blob_symbol const* sym = m_blob.symbol(symidx);
             m_os << "         [" << std::setw(4) << symidx << "] " << m_blob.string(sym->s_name);
             M_dumpSignature(sym->s_signature);
             m_os << std::endl;
@@ -105,11 +109,22 @@ void Disassembler::dumpTypeSpecs()
 void Disassembler::dumpConstants()
 {
     m_os << "Constants :" << std::endl;
-    m_blob.foreachConstant([&](blob_idx cstidx, blob_constant* cst)
+    m_blob.foreachConstant([&](blob_idx cstidx, blob_constant const* cst)
     {
         m_os << "  [" << std::setw(4) << cstidx << "] ";
         m_os << std::setw(16) << std::left << std::hex << cst->c_classid << std::right << " ";
-        m_os << '\'' << m_blob.string(cst->c_serialized) << '\'' << std::endl;
+        m_os << '\'' << M_constantValue(cst) << '\'' << std::endl;
+    });
+}
+
+void Disassembler::dumpDebug()
+{
+    m_os << "Debug table :" << std::endl;
+    m_blob.foreachDebugEntry([&](blob_idx, blob_debug_entry const& entry)
+    {
+        m_os << "  " << std::setw(8) << std::setfill('0') << std::hex
+             << entry.de_addr << std::setfill(' ') << std::dec << " ";
+        m_os << entry.de_line << ":" << entry.de_col << " (" << entry.de_extent << ")" << std::endl;
     });
 }
 
@@ -120,24 +135,24 @@ void Disassembler::dumpText()
     std::shared_ptr<Buffer> text = m_blob.text();
     if (!text)
         return;
-    int count = (int) (text->size() / sizeof(uint32_t));
+    int count = (int) text->size();
+    uint8_t const* code = count ? text->view(0, count) : nullptr;
 
     auto decodeInstruction = [&](int& pc, std::vector<int>& operands)
     {
-        auto fetch = [&]()
-        { return *((uint32_t*) text->raw(sizeof(uint32_t) * pc++, sizeof(uint32_t))); };
-
-        Opcode opcode = (Opcode) fetch();
+        std::size_t pos = pc;
+        Opcode opcode = (Opcode) code[pos++];
 
-        if (opcode & DEBUG_MASK)
+        for (int i = 0; i < opcode_nargs(opcode); ++i)
         {
-            fetch();
-            opcode = (Opcode) (opcode & (~DEBUG_MASK));
+            // A truncated operand ends the text
+            int32_t operand = 0;
+            if (!sleb128_decode(code, pos, code + count, operand))
+                pos = count;
+            operands.push_back((int) operand);
         }
 
-        for (int i = 0; i < opcode_nargs(opcode); ++i)
-            operands.push_back((int) fetch());
-
+        pc = (int) pos;
         return opcode;
     };
 
@@ -171,6 +186,13 @@ void Disassembler::dumpText()
                 break;
             }
 
+            case GUARD_SYMBOL:
+            {
+                is_jmp = true;
+                target = operands[1];
+                break;
+            }
+
             default:
                 break;
         }
@@ -191,8 +213,8 @@ void Disassembler::dumpText()
     for (int pc = 0; pc < count; )
     {
         // Find if this instruction begins a symbol
-        blob_symbol* symbol = nullptr;
-        m_blob.foreachSymbol([&](blob_idx, blob_symbol* sym)
+        blob_symbol const* symbol = nullptr;
+        m_blob.foreachSymbol([&](blob_idx, blob_symbol const* sym)
         {
             if ((int) sym->s_addr == pc)
                 symbol = sym;
@@ -232,11 +254,11 @@ void Disassembler::dumpText()
                 }
                 else
                 {
-                    blob_constant* cst = m_blob.constant(operands[0]);
+                    blob_constant const* cst = m_blob.constant(operands[0]);
                     if (!cst)
                         m_os << "<invalid>";
                     else
-                        m_os << "(" << std::setw(16) << std::hex << cst->c_classid << ") '" << m_blob.string(cst->c_serialized) << "'";
+                        m_os << "(" << std::setw(16) << std::hex << cst->c_classid << ") '" << M_constantValue(cst) << "'";
                 }
                 break;
             }
@@ -263,6 +285,17 @@ void Disassembler::dumpText()
                 break;
 
             case METHOD:
+            case ADD_INT:
+            case SUB_INT:
+            case MUL_INT:
+            case DIV_INT:
+            case MOD_INT:
+            case EQ_INT:
+            case NE_INT:
+            case LT_INT:
+            case LE_INT:
+            case GT_INT:
+            case GE_INT:
             {
                 std::string name;
                 if (!m_blob.string(operands[0], name))
@@ -271,6 +304,27 @@ void Disassembler::dumpText()
                 break;
             }
 
+            case CALL_SYMBOL:
+            case CALL_SYMBOL_TYPED:
+            {
+                std::string name;
+                blob_symbol const* symbol = m_blob.symbol(operands[0]);
+                if (!symbol || !m_blob.string(symbol->s_name, name))
+                    name = "<invalid>";
+                m_os << name << " (#" << operands[0] << "), " << operands[1];
+                break;
+            }
+
+            case GUARD_SYMBOL:
+            {
+                std::string name;
+                blob_symbol const* symbol = m_blob.symbol(operands[0]);
+                if (!symbol || !m_blob.string(symbol->s_name, name))
+                    name = "<invalid>";
+                m_os << name << " (#" << operands[0] << "), " << jmp_targets[operands[1]].first;
+                break;
+            }
+
             case JMPR:
             case JMPR_IF_FALSE:
             case JMPR_IF_TRUE:
@@ -334,17 +388,17 @@ bool Disassembler::functionAt(int pc, std::string& name, int& offset)
     if (!text)
         return false;
 
-    int count = (int) (text->size() / sizeof(uint32_t));
+    int count = (int) text->size();
     if (pc < 0 || pc > count)
         return false;
 
-    std::vector<std::pair<int, blob_symbol*>> sym_addrs;
-    m_blob.foreachSymbol([&](blob_idx, blob_symbol* sym)
+    std::vector<std::pair<int, blob_symbol const*>> sym_addrs;
+    m_blob.foreachSymbol([&](blob_idx, blob_symbol const* sym)
     {
         sym_addrs.push_back(std::make_pair((int) sym->s_addr, sym));
     });
 
-    blob_symbol* symbol = nullptr;
+    blob_symbol const* symbol = nullptr;
     for (int i = 0; i < (int) (sym_addrs.size()-1); ++i)
     {
         if (pc >= sym_addrs[i].first &&
@@ -363,3 +417,47 @@ bool Disassembler::functionAt(int pc, std::string& name, int& offset)
     offset = pc - symbol->s_addr;
     return true;
 }
+
+std::string Disassembler::M_constantValue(blob_constant const* cst) const
+{
+    std::ostringstream ss;
+
+    switch (cst->c_kind)
+    {
+        case BLOB_CST_INT:
+            ss << (int32_t) (int64_t) cst->c_value;
+            break;
+
+        case BLOB_CST_ULONG:
+            ss << cst->c_value;
+            break;
+
+        case BLOB_CST_FLOAT:
+        {
+            uint32_t bits = (uint32_t) cst->c_value;
+            float value;
+            std::memcpy(&value, &bits, sizeof(float));
+            ss << value;
+            break;
+        }
+
+        case BLOB_CST_BOOL:
+            ss << std::boolalpha << (cst->c_value != 0);
+            break;
+
+        case BLOB_CST_CHAR:
+            ss << (char) cst->c_value;
+            break;
+
+        case BLOB_CST_STRING:
+        case BLOB_CST_SERIALIZED:
+            ss << m_blob.string((blob_off) cst->c_value);
+            break;
+
+        default:
+            ss << "<invalid>";
+            break;
+    }
+
+    return ss.str();
+}
@@ -0,0 +1,157 @@
+/*  This file is part of Axolotl.
+ *
+ * Axolotl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Axolotl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Axolotl.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "bits/mapped_buffer.hpp"
+#include "bits/basic_buffer.hpp"
+
+#include <stdexcept>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace bits;
+
+MappedBuffer::Mapping::~Mapping()
+{
+    if (addr)
+        munmap(addr, length);
+}
+
+MappedBuffer::MappedBuffer()
+    : m_raw(nullptr)
+    , m_size(0)
+{}
+
+MappedBuffer::~MappedBuffer()
+{}
+
+bool MappedBuffer::open(std::string const& file, std::size_t offset, std::size_t length)
+{
+    m_mapping.reset();
+    m_raw = nullptr;
+    m_size = 0;
+
+    int fd = ::open(file.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    bool success = !fstat(fd, &st) && length && offset + length <= (std::size_t) st.st_size &&
+        M_map(fd, offset, length);
+
+    close(fd);
+    return success;
+}
+
+bool MappedBuffer::open(std::string const& file)
+{
+    m_mapping.reset();
+    m_raw = nullptr;
+    m_size = 0;
+
+    int fd = ::open(file.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    bool success = !fstat(fd, &st) && st.st_size > 0 && M_map(fd, 0, (std::size_t) st.st_size);
+
+    close(fd);
+    return success;
+}
+
+bool MappedBuffer::M_map(int fd, std::size_t offset, std::size_t length)
+{
+    // The mapping must start on a page boundary
+    std::size_t page = (std::size_t) sysconf(_SC_PAGESIZE);
+    std::size_t start = offset - offset % page;
+
+    void* addr = mmap(nullptr, offset + length - start, PROT_READ, MAP_PRIVATE, fd, (off_t) start);
+    if (addr == MAP_FAILED)
+        return false;
+
+    m_mapping = std::make_shared<Mapping>();
+    m_mapping->addr = addr;
+    m_mapping->length = offset + length - start;
+
+    m_raw = (uint8_t*) addr + (offset - start);
+    m_size = length;
+    return true;
+}
+
+Buffer* MappedBuffer::copy() const
+{
+    BasicBuffer view(m_raw, m_size);
+    return view.copy();
+}
+
+bool MappedBuffer::readonly() const
+{
+    return true;
+}
+
+std::size_t MappedBuffer::size() const
+{
+    return m_size;
+}
+
+uint8_t MappedBuffer::at(std::size_t i) const
+{
+    return m_raw[i];
+}
+
+uint8_t& MappedBuffer::at(std::size_t)
+{
+    throw std::runtime_error("bits::MappedBuffer::at: the buffer is read-only");
+}
+
+bool MappedBuffer::inject(std::size_t, std::size_t)
+{
+    return false;
+}
+
+bool MappedBuffer::copy(std::size_t, uint8_t*, std::size_t)
+{
+    return false;
+}
+
+uint8_t* MappedBuffer::raw(std::size_t, std::size_t)
+{
+    return nullptr;
+}
+
+uint8_t const* MappedBuffer::view(std::size_t pos, std::size_t len)
+{
+    if (pos + len > m_size)
+        return nullptr;
+
+    return m_raw + pos;
+}
+
+Buffer* MappedBuffer::sub(std::size_t pos, std::size_t len)
+{
+    if (pos + len > m_size)
+        return nullptr;
+
+    MappedBuffer* buf = new MappedBuffer();
+    buf->m_mapping = m_mapping;
+    buf->m_raw = m_raw + pos;
+    buf->m_size = len;
+    return buf;
+}
@@ -16,8 +16,6 @@
 
 #include "bits/opcodes.hpp"
 
-#include <map>
-
 namespace bits
 {
     std::string opcode_as_string(Opcode op)
@@ -48,25 +46,21 @@ namespace bits
 
     int opcode_nargs(Opcode op)
     {
-        static std::map<Opcode, int> opcodes_nargs;
-        static bool opcodes_nargs_inited = false;
-
-        if (!opcodes_nargs_inited)
-        {   
+        // Opcodes are numbered in order of definition, the table is
+        //   constant so that any thread (e.g. the JIT) may read it
+        static const int opcodes_nargs[] =
+        {
             #define DEF_MASK(name, value)
-            #define DEF_OPCODE(name, nargs) opcodes_nargs[name] = nargs;
+            #define DEF_OPCODE(name, nargs) nargs,
             #include "bits/opcodes.def"
             #undef DEF_OPCODE
             #undef DEF_MASK
+        };
 
-            opcodes_nargs_inited = true;
-        }
-
-        auto it = opcodes_nargs.find(op);
-        if (it == opcodes_nargs.end())
+        if (op < 0 || op >= (int) (sizeof(opcodes_nargs) / sizeof(int)))
             return -1;
 
-        return it->second;
+        return opcodes_nargs[op];
     }
 
     Opcode opcode_remove_masks(int op)
@@ -0,0 +1,109 @@
+#include "core/atom.hpp"
+#include "core/exception.hpp"
+#include "lang/std_atoms.hpp"
+
+#include <unordered_map>
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+using namespace core;
+
+namespace
+{
+    const std::size_t CHUNK_SIZE = 1024;
+    const std::size_t MAX_CHUNKS = 4096;
+
+    //! The table is shared by the whole process, not owned by a runtime,
+    //!   so that builtin atoms can be constants. Names are only ever
+    //!   appended, looking up an interned atom or its name never locks.
+    struct AtomTable
+    {
+        //! Names by id, in chunks which never move once published
+        std::atomic<std::string*> chunks[MAX_CHUNKS];
+        std::atomic<std::size_t> size;
+        std::unordered_map<std::string, Atom::Id> ids;
+        //! Guards the insertions, the JIT worker may intern names as well
+        std::mutex mutex;
+
+        AtomTable()
+            : size(0)
+        {
+            for (auto& chunk : chunks)
+                chunk.store(nullptr, std::memory_order_relaxed);
+
+            // The builtin names come first so that their atoms are
+            //   known at compile time, id 0 is the one of default atoms
+            for (char const* name : lang::std_atom_names)
+                insert(name);
+        }
+
+        //! Must be called with the mutex held, or before the table is shared
+        Atom::Id insert(std::string const& name)
+        {
+            std::size_t id = size.load(std::memory_order_relaxed);
+            if (id >= CHUNK_SIZE * MAX_CHUNKS)
+                throw InternalError("core::Atom: too many atoms");
+
+            std::string* chunk = chunks[id / CHUNK_SIZE].load(std::memory_order_relaxed);
+            if (!chunk)
+            {
+                chunk = new std::string[CHUNK_SIZE];
+                chunks[id / CHUNK_SIZE].store(chunk, std::memory_order_release);
+            }
+
+            chunk[id % CHUNK_SIZE] = name;
+            ids[name] = (Atom::Id) id;
+            size.store(id + 1, std::memory_order_release);
+            return (Atom::Id) id;
+        }
+
+        std::string const& name(Atom::Id id) const
+        { return chunks[id / CHUNK_SIZE].load(std::memory_order_acquire)[id % CHUNK_SIZE]; }
+    };
+
+    AtomTable& table()
+    {
+        // Atoms are built during static initialization (e.g. the members
+        //   of the builtin classes), the order of which is unknown
+        static AtomTable* table = new AtomTable();
+        return *table;
+    }
+
+    Atom::Id intern(std::string const& name)
+    {
+        // Each thread remembers the names it already interned, the shared
+        //   map is only looked up under the lock
+        static thread_local std::unordered_map<std::string, Atom::Id> cache;
+
+        auto cached = cache.find(name);
+        if (cached != cache.end())
+            return cached->second;
+
+        AtomTable& t = table();
+        Atom::Id id;
+        {
+            std::lock_guard<std::mutex> lock(t.mutex);
+
+            auto it = t.ids.find(name);
+            id = it != t.ids.end() ? it->second : t.insert(name);
+        }
+
+        cache[name] = id;
+        return id;
+    }
+}
+
+Atom::Atom(std::string const& name)
+    : m_id(intern(name))
+{}
+
+Atom::Atom(char const* name)
+    : m_id(intern(name))
+{}
+
+std::string const& Atom::name() const
+{ return table().name(m_id); }
+
+std::size_t Atom::count()
+{ return table().size.load(std::memory_order_acquire); }
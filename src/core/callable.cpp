@@ -8,6 +8,11 @@ Callable::Callable(Callable::ScriptedMetaType const& scripted)
     , m_meta(scripted)
 {}
 
+Callable::Callable(Callable::NativeMetaType const& native)
+    : m_kind(Kind::Native)
+    , m_meta(native)
+{}
+
 Callable::~Callable()
 {}
 
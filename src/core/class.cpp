@@ -16,7 +16,9 @@
 
 #include "core/class.hpp"
 #include "core/core.hpp"
+#include "core/dispatch_cache.hpp"
 #include "lang/std_names.hpp"
+#include "lang/std_atoms.hpp"
 
 #include <functional>
 
@@ -36,12 +38,13 @@ Class::Class(std::string const& module_name, std::string const& classname, bool
     m_impl->refcount = 1;
     m_impl->classid = hashId(module_name, classname);
     m_impl->classname = classname;
+    m_impl->classname_atom = classname;
     m_impl->in_script = in_script;
 
-    addMember(lang::std_classname, classname);
-    addMember(lang::std_classid, m_impl->classid);
+    addMember(lang::std_classname_atom, classname);
+    addMember(lang::std_classid_atom, m_impl->classid);
 
-    addMember(lang::std_equals,
+    addMember(lang::std_equals_atom,
     [](Object self, Object obj)
     {
         if (self.classname() != obj.classname())
@@ -49,23 +52,23 @@ Class::Class(std::string const& module_name, std::string const& classname, bool
         return self.serialize() == obj.serialize();
     });
 
-    addMember(lang::std_lt,
+    addMember(lang::std_lt_atom,
     [](Object self, Object obj)
     { return (self.classname() + self.serialize()) < (obj.classname() + obj.serialize()); });
 
-    addMember(lang::std_lte,
+    addMember(lang::std_lte_atom,
     [](Object self, Object obj)
     { return (self < obj) || (self == obj); });
 
-    addMember(lang::std_gt,
+    addMember(lang::std_gt_atom,
     [](Object self, Object obj)
     { return obj < self; });
 
-    addMember(lang::std_gte,
+    addMember(lang::std_gte_atom,
     [](Object self, Object obj)
     { return (self > obj) || (self == obj); });
 
-    addMember(lang::std_nequals,
+    addMember(lang::std_nequals_atom,
     [](Object self, Object obj)
     { return !(self == obj); });
 }
@@ -91,8 +94,11 @@ Class::Id Class::classid() const
 std::string const& Class::classname() const
 { return m_impl->classname; }
 
-void Class::addMember(std::string const& name, Object value)
-{ m_impl->members.push_back(std::make_pair(name, value)); }
+void Class::addMember(Atom const& name, Object value)
+{
+    m_impl->members.push_back(std::make_pair(name, value));
+    detail::DispatchCache::invalidate();
+}
 
 Object Class::construct(Some&& value) const
 {
@@ -101,13 +107,16 @@ Object Class::construct(Some&& value) const
     for (auto m : m_impl->members)
         object.newPolymorphic(m.first) = m.second;
 
+    // These are the methods of the class, not overrides
+    object.m_impl->overridden = false;
+
     return object;
 }
 
 Object Class::unserialize(std::string const& value) const
 {
     for (auto m : m_impl->members)
-        if (m.first == lang::std_unserialize)
+        if (m.first == lang::std_unserialize_atom)
             return m.second.invoke({ value });
 
     return Object::nil();
@@ -124,10 +133,10 @@ void Class::finalizeObject(Object& self) const
             
             Object self = thisclass.construct();
             o.insert(o.begin(), self);
-            self.invokePolymorphic(thisclass.classname(), o);
+            self.invokePolymorphic(thisclass.m_impl->classname_atom, o);
             return self;
         };
-        self.newPolymorphic(lang::std_call) = Callable(std::function<Object(std::vector<Object>)>(proxy), true);
+        self.newPolymorphic(lang::std_call_atom) = Callable(std::function<Object(std::vector<Object>)>(proxy), true);
     }
     else
     {
@@ -136,18 +145,36 @@ void Class::finalizeObject(Object& self) const
         {
             o.erase(o.begin());
 
+            Atom const& name = thisclass.m_impl->classname_atom;
+            detail::DispatchCache::Key key;
+            bool cacheable = detail::DispatchCache::key(detail::DispatchCache::CONSTRUCTOR, thisclass.classid(), name, o, key);
+            if (cacheable)
+            {
+                detail::DispatchCache::Entry const* entry = detail::DispatchCache::find(key);
+                if (entry)
+                {
+                    // Copied, invoking it may replace the entry
+                    Object fun = entry->fun;
+                    return fun.unwrap<Callable>().invoke(o);
+                }
+            }
+
             for (auto const& m : thisclass.m_impl->members)
             {
-                if (m.first != thisclass.classname())
+                if (m.first != name)
                     continue;
 
                 if (m.second.callable() && m.second.unwrap<Callable>().signature().match(o))
+                {
+                    if (cacheable)
+                        detail::DispatchCache::store(key, 0, m.second);
                     return m.second.invoke(o);
+                }
             }
 
             return Object::nil();
         };
-        self.newPolymorphic(lang::std_call) = Callable(std::function<Object(std::vector<Object>)>(proxy), true);
+        self.newPolymorphic(lang::std_call_atom) = Callable(std::function<Object(std::vector<Object>)>(proxy), true);
     }
 
     // No constructors were provided
@@ -161,6 +188,7 @@ void Class::finalizeObject(Object& self) const
 Object& Class::operator[](std::string const& name)
 {
     m_impl->members.push_back(std::make_pair(name, Object()));
+    detail::DispatchCache::invalidate();
     return m_impl->members.back().second;
 }
 
@@ -0,0 +1,75 @@
+#include "core/dispatch_cache.hpp"
+#include "core/type_registry.hpp"
+
+using namespace core;
+using namespace detail;
+
+// The first generation is 1, so that the entries of a new table are stale
+std::size_t DispatchCache::m_generation = 1;
+
+bool DispatchCache::Key::operator==(Key const& other) const
+{
+    if (classid != other.classid || name != other.name ||
+        kind != other.kind || argc != other.argc)
+        return false;
+
+    for (std::size_t i = 0; i < argc; ++i)
+        if (args[i] != other.args[i])
+            return false;
+
+    return true;
+}
+
+bool DispatchCache::key(Kind kind, Class::Id classid, Atom const& name,
+                        std::vector<Object> const& args, Key& key)
+{
+    // Before the builtins are bound the table would be filled with
+    //   pending objects, and nothing is worth caching anyway
+    if (!type_registry_sealed || args.size() > MAX_ARGS)
+        return false;
+
+    key.classid = classid;
+    key.name = name.id();
+    key.kind = (uint16_t) kind;
+    key.argc = (uint16_t) args.size();
+    for (std::size_t i = 0; i < args.size(); ++i)
+        key.args[i] = args[i].classid();
+
+    return true;
+}
+
+DispatchCache::Entry const* DispatchCache::find(Key const& key)
+{
+    Entry const& entry = M_table()[M_hash(key) % SIZE];
+    if (entry.generation != m_generation || !(entry.key == key))
+        return nullptr;
+    return &entry;
+}
+
+void DispatchCache::store(Key const& key, uint64_t stamp, Object const& fun)
+{
+    Entry& entry = M_table()[M_hash(key) % SIZE];
+    entry.key = key;
+    entry.generation = m_generation;
+    entry.stamp = stamp;
+    entry.fun = fun;
+}
+
+void DispatchCache::invalidate()
+{ ++m_generation; }
+
+std::size_t DispatchCache::M_hash(Key const& key)
+{
+    std::size_t hash = key.classid ^ ((std::size_t) key.name << 7) ^ key.kind;
+    for (std::size_t i = 0; i < key.argc; ++i)
+        hash = hash * 31 + key.args[i];
+    return hash ^ (hash >> 17);
+}
+
+DispatchCache::Entry* DispatchCache::M_table()
+{
+    // Never freed: the entries hold functions, which may in turn hold
+    //   modules, and those must not be destroyed after the runtime
+    static Entry* table = new Entry[SIZE]();
+    return table;
+}
@@ -3,18 +3,38 @@
 #include "core/callable.hpp"
 #include "core/callback_impl.hpp"
 #include "core/exception.hpp"
+#include "core/dispatch_cache.hpp"
 #include "lang/std_names.hpp"
+#include "lang/std_atoms.hpp"
+
+#include <cassert>
 
 using namespace core;
 
+Object::Impl* Object::m_nil_impl = nullptr;
+std::vector<Object>* Object::m_pending = nullptr;
+
 Object::Object()
     : m_weak(false)
-    , m_impl(new Impl())
 {
+    if (m_nil_impl)
+    {
+        m_impl = m_nil_impl;
+        M_incref();
+        return;
+    }
+
+    m_impl = new Impl();
     m_impl->meta = Some();
     m_impl->pending_type_id = detail::uniqueTypeId<void>();
     m_impl->pending = true;
     m_impl->refcount = 1;
+    m_impl->frozen = false;
+    m_impl->overridden = false;
+
+    if (!m_pending)
+        m_pending = new std::vector<Object>();
+    m_pending->push_back(*this);
 }
 
 Object::Object(Object const& cpy, bool weaken)
@@ -32,6 +52,8 @@ Object::Object(Some&& meta, Class const& the_class)
     m_impl->the_class = the_class;
     m_impl->pending = false;
     m_impl->refcount = 1;
+    m_impl->frozen = false;
+    m_impl->overridden = false;
 }
 
 Object::Object(Some&& meta, std::size_t pending_type_id)
@@ -42,6 +64,12 @@ Object::Object(Some&& meta, std::size_t pending_type_id)
     m_impl->pending = true;
     m_impl->pending_type_id = pending_type_id;
     m_impl->refcount = 1;
+    m_impl->frozen = false;
+    m_impl->overridden = false;
+
+    if (!m_pending)
+        m_pending = new std::vector<Object>();
+    m_pending->push_back(*this);
 }
 
 Object::~Object()
@@ -66,21 +94,38 @@ bool Object::weak() const
 
 Object Object::weakref() const
 {
-    M_fixPending();
+    assert(!m_impl->pending);
     return Object(*this, true);
 }
 
 Object Object::copy() const
 {
-    Object cpy;
-    *cpy.m_impl = *m_impl;
-    cpy.m_impl->refcount = 1;
+    assert(!m_impl->pending);
+    Object cpy(Some(m_impl->meta), m_impl->the_class);
+    cpy.m_impl->members = m_impl->members;
+    cpy.m_impl->overridden = m_impl->overridden;
     return cpy;
 }
 
+bool Object::overridden() const
+{ return m_impl->overridden; }
+
+bool Object::frozen() const
+{ return m_impl->frozen; }
+
+void Object::freeze()
+{ m_impl->frozen = true; }
+
+Object Object::thawed() const
+{
+    if (m_impl->frozen)
+        return copy();
+    return *this;
+}
+
 Some const& Object::meta() const
 {
-    M_fixPending();
+    assert(!m_impl->pending);
     return m_impl->meta;
 }
 
@@ -89,25 +134,29 @@ bool Object::pending() const
 
 bool Object::callable() const
 {
-    M_fixPending();
+    assert(!m_impl->pending);
     return m_impl->meta.is<Callable>();
 }
 
 bool Object::invokable() const
 {
-    M_fixPending();
-    return callable() || has(lang::std_call);
+    assert(!m_impl->pending);
+    return callable() || has(lang::std_call_atom);
 }
 
 bool Object::isNil() const
 {
-    M_fixPending();
+    assert(!m_impl->pending);
+    if (m_impl == m_nil_impl)
+        return true;
+    if (m_nil_impl)
+        return m_impl->the_class.classid() == m_nil_impl->the_class.classid();
     return classname() == lang::std_nil_classname;
 }
 
 Class const& Object::theClass() const
 {
-    M_fixPending();
+    assert(!m_impl->pending);
     return m_impl->the_class;
 }
 
@@ -117,31 +166,54 @@ std::string Object::classname() const
 Class::Id Object::classid() const
 { return theClass().classid(); }
 
-bool Object::has(std::string const& id) const
+bool Object::has(Atom const& id) const
 {
-    M_fixPending();
+    assert(!m_impl->pending);
     return m_impl->members.count(id) >= 1;
 }
 
-bool Object::isPolymorphic(std::string const& id) const
+bool Object::isPolymorphic(Atom const& id) const
 {
-    M_fixPending();
+    assert(!m_impl->pending);
     return m_impl->members.count(id) > 1;
 }
 
-Object& Object::newPolymorphic(std::string const& id)
+Object& Object::newPolymorphic(Atom const& id)
 {
-    M_fixPending();
-    return m_impl->members.insert(std::pair<std::string, Object>(id, Object::nil()))->second;
+    assert(!m_impl->pending);
+    m_impl->overridden = true;
+    return m_impl->members.insert(std::pair<Atom, Object>(id, Object::nil()))->second;
 }
 
-Object Object::findPolymorphic(std::string const& id, std::vector<Object> const& args) const
+Object Object::findPolymorphic(Atom const& id, std::vector<Object> const& args) const
 {
-    M_fixPending();
+    assert(!m_impl->pending);
     auto range = m_impl->members.equal_range(id);
+    if (range.first == range.second)
+        return nil();
+
+    // The stamp of a cached lookup is the number of candidates and the
+    //   position of the match, instances can't replace one of several
+    //   candidates (see Object::member) so this and the identity of the
+    //   match tell whether this instance resolves the same way
+    std::size_t count = std::distance(range.first, range.second);
+    detail::DispatchCache::Key key;
+    bool cacheable = detail::DispatchCache::key(detail::DispatchCache::MEMBER, classid(), id, args, key);
+    if (cacheable)
+    {
+        detail::DispatchCache::Entry const* entry = detail::DispatchCache::find(key);
+        if (entry && (entry->stamp >> 32) == count)
+        {
+            auto it = range.second;
+            std::advance(it, -(long) (entry->stamp & 0xffffffff) - 1);
+            if (it->second.m_impl == entry->fun.m_impl)
+                return it->second;
+        }
+    }
 
     // Search backward to follow the 'least specialized first' rule
-    for (auto it = --range.second; ; --it)
+    std::size_t position = 0;
+    for (auto it = --range.second; ; --it, ++position)
     {
         Object& obj = it->second;
         if (!obj.callable())
@@ -150,7 +222,11 @@ Object Object::findPolymorphic(std::string const& id, std::vector<Object> const&
             // throw std::runtime_error("core::Object::findPolymorphic: polymorphic member is not callable");
         }
         if (obj.unwrap<Callable>().signature().match(args))
+        {
+            if (cacheable)
+                detail::DispatchCache::store(key, ((uint64_t) count << 32) | position, obj);
             return obj;
+        }
 
         if (it == range.first)
             break;
@@ -159,64 +235,76 @@ Object Object::findPolymorphic(std::string const& id, std::vector<Object> const&
     return nil();
 }
 
-Object& Object::member(std::string const& id)
+Object& Object::member(Atom const& id)
 {
-    M_fixPending();
+    assert(!m_impl->pending);
     if (isPolymorphic(id))
     {
-        throw NoMemberError(*this, id);
-        // throw std::runtime_error("core::Object::member: member '" + id + "' is polymorphic");
+        throw NoMemberError(*this, id.name());
+        // throw std::runtime_error("core::Object::member: member '" + id.name() + "' is polymorphic");
     }
 
     if (!has(id))
-        m_impl->members.insert(std::pair<std::string, Object>(id, Object::nil()));
+    {
+        // The nil instance is shared, never let it grow members
+        if (m_impl == m_nil_impl)
+            throw NoMemberError(*this, id.name());
+        m_impl->members.insert(std::pair<Atom, Object>(id, Object::nil()));
+    }
+
+    // The caller may replace a method
+    Object& member = m_impl->members.find(id)->second;
+    if (member.callable())
+        m_impl->overridden = true;
 
-    return m_impl->members.find(id)->second;
+    return member;
 }
 
-Object const& Object::member(std::string const& id) const
+Object const& Object::member(Atom const& id) const
 {
-    M_fixPending();
+    assert(!m_impl->pending);
     if (isPolymorphic(id))
     {
-        throw NoMemberError(*this, id);
-        // throw std::runtime_error("core::Object::member: member '" + id + "' is polymorphic");
+        throw NoMemberError(*this, id.name());
+        // throw std::runtime_error("core::Object::member: member '" + id.name() + "' is polymorphic");
     }
 
     auto it = m_impl->members.find(id);
     if (it == m_impl->members.end())
-        throw NoMemberError(*this, id);
+        throw NoMemberError(*this, id.name());
 
     return it->second;
 }
 
-Object Object::invokeMember(std::string const& name, std::vector<Object> const& args) const
+Object Object::invokeMember(Atom const& name, std::vector<Object> const& args) const
 {
-    M_fixPending();
+    assert(!m_impl->pending);
     if (!has(name))
     {
-        throw NoMemberError(*this, name);
-        // throw std::runtime_error("member `" + name + "' does not exists in class `" + classname() + "'\n");
+        throw NoMemberError(*this, name.name());
+        // throw std::runtime_error("member `" + name.name() + "' does not exists in class `" + classname() + "'\n");
     }
 
     return member(name).invoke(args);
 }
 
-Object Object::invokePolymorphic(std::string const& name, std::vector<Object> const& args) const
+Object Object::invokePolymorphic(Atom const& name, std::vector<Object> const& args) const
 {
-    M_fixPending();
+    assert(!m_impl->pending);
     Object morph = findPolymorphic(name, args);
     if (morph.isNil())
     {
-        throw SignatureError(*this, name, args);
+        throw SignatureError(*this, name.name(), args);
         // throw std::runtime_error("core::Object::findPolymorphic: no polymorphic member matches the current signature");
     }
-    return morph.invoke(args);
+
+    // The signature was just matched, don't check it again
+    return morph.m_impl->meta.as<Callable>().invoke(args);
 }
 
 Object Object::invoke(std::vector<Object> const& args) const
 {
-    M_fixPending();
+    assert(!m_impl->pending);
     if (callable())
     {
         if (!m_impl->meta.as<Callable>().signature().match(args))
@@ -229,23 +317,23 @@ Object Object::invoke(std::vector<Object> const& args) const
 
     std::vector<Object> cpy = args;
     cpy.insert(cpy.begin(), *this);
-    return invokePolymorphic(lang::std_call, cpy);
+    return invokePolymorphic(lang::std_call_atom, cpy);
 }
 
-Object Object::method(std::string const& name, std::vector<Object> const& args) const
+Object Object::method(Atom const& name, std::vector<Object> const& args) const
 {
-    M_fixPending();
+    assert(!m_impl->pending);
     std::vector<Object> new_args = { *this };
     std::copy(args.begin(), args.end(), std::back_inserter(new_args));
 
     Object morph = findPolymorphic(name, new_args);
     if (morph.isNil())
     {
-        throw SignatureError(*this, name, args);
+        throw SignatureError(*this, name.name(), args);
         // throw std::runtime_error("core::Object:method: no polymorphic member matches the current signature");
     }
 
-    return morph.invoke(new_args);
+    return morph.m_impl->meta.as<Callable>().invoke(new_args);
 }
 
 Object Object::operator==(Object const& other) const
@@ -256,7 +344,7 @@ Object Object::operator==(Object const& other) const
     if (other.isNil() || isNil())
         return false;
 
-    return invokePolymorphic(lang::std_equals, { *this, other });
+    return invokePolymorphic(lang::std_equals_atom, { *this, other });
 }
 
 Object Object::operator!=(Object const& other) const
@@ -267,44 +355,44 @@ Object Object::operator!=(Object const& other) const
     if (other.isNil() || isNil())
         return true;
 
-    return invokePolymorphic(lang::std_nequals, { *this, other });
+    return invokePolymorphic(lang::std_nequals_atom, { *this, other });
 }
 
 Object Object::operator&&(Object const& other) const
-{ return invokePolymorphic(lang::std_and, { *this, other}); }
+{ return invokePolymorphic(lang::std_and_atom, { *this, other}); }
 
 Object Object::operator||(Object const& other) const
-{ return invokePolymorphic(lang::std_or, { *this, other}); }
+{ return invokePolymorphic(lang::std_or_atom, { *this, other}); }
 
 Object Object::operator!() const
-{ return invokePolymorphic(lang::std_not, { *this }); }
+{ return invokePolymorphic(lang::std_not_atom, { *this }); }
 
 Object Object::operator+(Object const& other) const
-{ return invokePolymorphic(lang::std_add, { *this, other}); }
+{ return invokePolymorphic(lang::std_add_atom, { *this, other}); }
 
 Object Object::operator-(Object const& other) const
-{ return invokePolymorphic(lang::std_sub, { *this, other}); }
+{ return invokePolymorphic(lang::std_sub_atom, { *this, other}); }
 
 Object Object::operator*(Object const& other) const
-{ return invokePolymorphic(lang::std_mul, { *this, other}); }
+{ return invokePolymorphic(lang::std_mul_atom, { *this, other}); }
 
 Object Object::operator/(Object const& other) const
-{ return invokePolymorphic(lang::std_div, { *this, other}); }
+{ return invokePolymorphic(lang::std_div_atom, { *this, other}); }
 
 Object Object::operator%(Object const& other) const
-{ return invokePolymorphic(lang::std_mod, { *this, other}); }
+{ return invokePolymorphic(lang::std_mod_atom, { *this, other}); }
 
 Object Object::operator<(Object const& other) const
-{ return invokePolymorphic(lang::std_lt, { *this, other }); }
+{ return invokePolymorphic(lang::std_lt_atom, { *this, other }); }
 
 Object Object::operator<=(Object const& other) const
-{ return invokePolymorphic(lang::std_lte, { *this, other }); }
+{ return invokePolymorphic(lang::std_lte_atom, { *this, other }); }
 
 Object Object::operator>(Object const& other) const
-{ return invokePolymorphic(lang::std_gt, { *this, other }); }
+{ return invokePolymorphic(lang::std_gt_atom, { *this, other }); }
 
 Object Object::operator>=(Object const& other) const
-{ return invokePolymorphic(lang::std_gte, { *this, other }); }
+{ return invokePolymorphic(lang::std_gte_atom, { *this, other }); }
 
 Object::operator bool() const
 { return unwrap<bool>(); }
@@ -313,7 +401,7 @@ std::string Object::serialize() const
 {
     if (isNil())
         return "";
-    return invokeMember(lang::std_serialize, { *this }).unwrap<std::string>();
+    return invokeMember(lang::std_serialize_atom, { *this }).unwrap<std::string>();
 }
 
 Object Object::nil()
@@ -337,15 +425,42 @@ void Object::M_decref()
 
 void Object::M_destroy()
 {
-    if (has(lang::std_del))
-        invokeMember(lang::std_del, { weakref() });
+    if (has(lang::std_del_atom))
+        invokeMember(lang::std_del_atom, { weakref() });
+}
+
+void Object::M_bind()
+{
+    if (!m_impl->pending)
+        return;
+
+    // Bind in place so that every handle sharing this instance sees it
+    Object bound = type_class(m_impl->pending_type_id).construct(std::move(m_impl->meta));
+    m_impl->meta = std::move(bound.m_impl->meta);
+    m_impl->the_class = bound.m_impl->the_class;
+    m_impl->members = std::move(bound.m_impl->members);
+    m_impl->overridden = bound.m_impl->overridden;
+    m_impl->pending = false;
 }
 
-void Object::M_fixPending() const
+void Object::bindPending()
 {
-    if (!m_impl || !m_impl->pending)
+    if (m_nil_impl)
         return;
 
-    Class const& the_class = type_class(m_impl->pending_type_id);
-    *const_cast<Object*>(this) = the_class.construct(Some(m_impl->meta));
+    // Build the shared nil first, so that binding does not create
+    //   new pending objects
+    Object nil = type_class<void>().construct();
+    m_nil_impl = nil.m_impl;
+    ++m_nil_impl->refcount;
+    detail::type_registry_sealed = true;
+
+    if (!m_pending)
+        return;
+
+    for (std::size_t i = 0; i < m_pending->size(); ++i)
+        (*m_pending)[i].M_bind();
+
+    delete m_pending;
+    m_pending = nullptr;
 }
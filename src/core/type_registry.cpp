@@ -6,21 +6,25 @@ namespace core
 {
     namespace detail
     {
-        std::map<std::size_t, Class>* type_registry = nullptr;
+        TypeRegistry* type_registry = nullptr;
+        ClassRegistry* class_registry = nullptr;
+        bool type_registry_sealed = false;
 
         static void __attribute__((constructor)) type_registry_init()
         {
-            type_registry = new std::map<std::size_t, Class>();
+            type_registry = new TypeRegistry();
+            class_registry = new ClassRegistry();
 
             Class::AnyClass = Class(lang::std_any_classname, lang::std_core_module_name);
             Class::AnyId = Class::AnyClass.classid();
-            type_registry->insert(std::make_pair(uniqueTypeId<Object>(), Class::AnyClass));
+            associate<Object>(Class::AnyClass);
 
             lib::recordAll();
         }
 
         static void __attribute__((destructor)) type_registry_fini()
         {
+            delete class_registry;
             delete type_registry;
         }
     }
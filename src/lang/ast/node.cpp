@@ -192,6 +192,22 @@ void Node::exchangeWith(Node* node)
     m_siblings.clear();
 }
 
+void Node::substituteInChain(Node* node)
+{
+    substituteWith(node);
+
+    if (m_prev)
+        m_prev->m_next = node;
+    if (m_next)
+        m_next->m_prev = node->last();
+
+    node->m_prev = m_prev;
+    node->M_last() = m_next;
+
+    m_next = nullptr;
+    m_prev = nullptr;
+}
+
 void Node::replaceBy(Node* node)
 {
     node->setParent(m_parent);
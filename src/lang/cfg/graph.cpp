@@ -0,0 +1,307 @@
+#include "lang/cfg/graph.hpp"
+#include "lang/ast/node.hpp"
+
+#include "lang/ast/ast.hpp"
+
+#include <algorithm>
+
+using namespace lang;
+using namespace ast;
+using namespace cfg;
+
+Graph::Graph(IR_FunDeclNode* fun)
+    : m_fun(fun)
+    , m_lowered(false)
+{
+    bool split = true;
+    for (Node* it = fun->siblings()[0]; it; )
+    {
+        Node* next = it->next();
+        it->removeFromChain();
+
+        if (split || dynamic_cast<IR_LabelNode*>(it))
+        {
+            if (split || !m_blocks.back().nodes.empty())
+                m_blocks.push_back(Block());
+            split = false;
+        }
+
+        if (IR_LabelNode* label = dynamic_cast<IR_LabelNode*>(it))
+            m_labels[label->name] = m_blocks.size() - 1;
+
+        m_blocks.back().nodes.push_back(it);
+        split = jumpTarget(it) || endsFlow(it);
+
+        it = next;
+    }
+
+    link();
+}
+
+Graph::~Graph()
+{
+    if (!m_lowered)
+        lower();
+}
+
+IR_FunDeclNode* Graph::function() const
+{ return m_fun; }
+
+std::vector<Block>& Graph::blocks()
+{ return m_blocks; }
+
+std::vector<Block> const& Graph::blocks() const
+{ return m_blocks; }
+
+void Graph::erase(Node* node)
+{ m_erased.push_back(node); }
+
+void Graph::replace(std::size_t block, std::size_t index, Node* node)
+{
+    erase(m_blocks[block].nodes[index]);
+    m_blocks[block].nodes[index] = node;
+}
+
+void Graph::link()
+{
+    for (auto& block : m_blocks)
+    {
+        block.succs.clear();
+        block.preds.clear();
+    }
+
+    for (std::size_t b = 0; b < m_blocks.size(); ++b)
+    {
+        Block& block = m_blocks[b];
+        if (block.dead)
+            continue;
+
+        Node* last = block.nodes.empty() ? nullptr : block.nodes.back();
+        if (std::string const* target = last ? jumpTarget(last) : nullptr)
+        {
+            auto it = m_labels.find(*target);
+            if (it != m_labels.end())
+                block.succs.push_back(it->second);
+        }
+
+        if ((!last || !endsFlow(last)) && b + 1 < m_blocks.size() &&
+            std::find(block.succs.begin(), block.succs.end(), b + 1) == block.succs.end())
+            block.succs.push_back(b + 1);
+
+        for (auto succ : block.succs)
+            m_blocks[succ].preds.push_back(b);
+    }
+}
+
+bool Graph::removeUnreachable()
+{
+    std::vector<bool> reached(m_blocks.size(), false);
+    for (auto b : reversePostOrder())
+        reached[b] = true;
+
+    bool removed = false;
+    for (std::size_t b = 0; b < m_blocks.size(); ++b)
+    {
+        Block& block = m_blocks[b];
+        if (reached[b] || block.dead)
+            continue;
+
+        for (auto node : block.nodes)
+            erase(node);
+
+        block.nodes.clear();
+        block.dead = true;
+        removed = true;
+    }
+
+    if (removed)
+        link();
+
+    return removed;
+}
+
+std::vector<std::size_t> Graph::reversePostOrder() const
+{
+    std::vector<std::size_t> order;
+    if (m_blocks.empty())
+        return order;
+
+    // Blocks along with the next successor to visit
+    std::vector<std::pair<std::size_t, std::size_t>> stack;
+    std::vector<bool> visited(m_blocks.size(), false);
+
+    stack.push_back(std::make_pair(0, 0));
+    visited[0] = true;
+    while (!stack.empty())
+    {
+        auto& top = stack.back();
+        std::vector<std::size_t> const& succs = m_blocks[top.first].succs;
+
+        if (top.second < succs.size())
+        {
+            std::size_t succ = succs[top.second++];
+            if (!visited[succ])
+            {
+                visited[succ] = true;
+                stack.push_back(std::make_pair(succ, 0));
+            }
+        }
+        else
+        {
+            order.push_back(top.first);
+            stack.pop_back();
+        }
+    }
+
+    std::reverse(order.begin(), order.end());
+    return order;
+}
+
+std::vector<std::vector<bool>> Graph::dominators() const
+{
+    std::size_t count = m_blocks.size();
+    std::vector<std::size_t> order = reversePostOrder();
+
+    std::vector<std::vector<bool>> dom(count, std::vector<bool>(count, false));
+    std::vector<bool> reached(count, false);
+    for (auto b : order)
+    {
+        reached[b] = true;
+        if (b)
+            dom[b].assign(count, true);
+    }
+
+    if (order.empty())
+        return dom;
+    dom[0][0] = true;
+
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        for (auto b : order)
+        {
+            if (!b)
+                continue;
+
+            std::vector<bool> meet(count, true);
+            for (auto pred : m_blocks[b].preds)
+            {
+                if (!reached[pred])
+                    continue;
+                for (std::size_t d = 0; d < count; ++d)
+                    meet[d] = meet[d] && dom[pred][d];
+            }
+            meet[b] = true;
+
+            if (meet != dom[b])
+            {
+                dom[b] = meet;
+                changed = true;
+            }
+        }
+    }
+
+    return dom;
+}
+
+void Graph::lower()
+{
+    m_lowered = true;
+
+    Node* slot = m_fun->siblings()[0];
+    Node* head = nullptr;
+    Node* last = nullptr;
+    for (auto const& block : m_blocks)
+    {
+        for (auto node : block.nodes)
+        {
+            if (last)
+                last->chain(node);
+            else
+                head = node;
+            last = node;
+        }
+    }
+
+    if (head && head != slot)
+    {
+        slot->substituteWith(head);
+        head->setParent(m_fun);
+    }
+
+    // The nodes were unlinked, deleting them leaves the others alone
+    for (auto node : m_erased)
+    {
+        if (node != slot || head)
+            delete node;
+    }
+    m_erased.clear();
+}
+
+bool Graph::stackEffect(Node* node, int& pops, int& pushes)
+{
+    pops = 0;
+    pushes = 0;
+
+    if (dynamic_cast<IR_LoadConstNode*>(node) || dynamic_cast<IR_LoadLocalNode*>(node) ||
+        dynamic_cast<IR_LoadGlobalNode*>(node))
+        pushes = 1;
+    else if (dynamic_cast<IR_StorLocalNode*>(node) || dynamic_cast<IR_StorGlobalNode*>(node) ||
+             dynamic_cast<IR_PopNode*>(node) || dynamic_cast<IR_ReturnNode*>(node) ||
+             dynamic_cast<IR_GotoIfTrueNode*>(node) || dynamic_cast<IR_GotoIfFalseNode*>(node))
+        pops = 1;
+    else if (dynamic_cast<IR_LoadMemberNode*>(node))
+    {
+        pops = 1;
+        pushes = 1;
+    }
+    else if (dynamic_cast<IR_StorMemberNode*>(node))
+        pops = 2;
+    else if (IR_InvokeNode* invoke = dynamic_cast<IR_InvokeNode*>(node))
+    {
+        pops = invoke->argc + 1;
+        pushes = 1;
+    }
+    else if (IR_MethodNode* method = dynamic_cast<IR_MethodNode*>(node))
+    {
+        pops = method->argc + 1;
+        pushes = 1;
+    }
+    else if (dynamic_cast<IR_MethodIntNode*>(node))
+    {
+        pops = 2;
+        pushes = 1;
+    }
+    else if (IR_CallSymbolNode* call = dynamic_cast<IR_CallSymbolNode*>(node))
+    {
+        pops = call->argc + 1;
+        pushes = 1;
+    }
+    else if (!dynamic_cast<IR_LabelNode*>(node) && !dynamic_cast<IR_GotoNode*>(node) &&
+             !dynamic_cast<IR_GuardSymbolNode*>(node) && !dynamic_cast<IR_LeaveNode*>(node) &&
+             !dynamic_cast<IR_ImportNode*>(node) && !dynamic_cast<IR_ImportMaskNode*>(node))
+        return false;
+
+    return true;
+}
+
+std::string const* Graph::jumpTarget(Node* node)
+{
+    if (IR_GotoNode* jump = dynamic_cast<IR_GotoNode*>(node))
+        return &jump->name;
+    if (IR_GotoIfTrueNode* jump = dynamic_cast<IR_GotoIfTrueNode*>(node))
+        return &jump->name;
+    if (IR_GotoIfFalseNode* jump = dynamic_cast<IR_GotoIfFalseNode*>(node))
+        return &jump->name;
+    if (IR_GuardSymbolNode* guard = dynamic_cast<IR_GuardSymbolNode*>(node))
+        return &guard->name;
+
+    return nullptr;
+}
+
+bool Graph::endsFlow(Node* node)
+{
+    return dynamic_cast<IR_GotoNode*>(node) || dynamic_cast<IR_ReturnNode*>(node) ||
+           dynamic_cast<IR_LeaveNode*>(node);
+}
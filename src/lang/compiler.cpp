@@ -49,6 +49,12 @@ Module Compiler::compile()
 
     M_generateIR();
 
+    // The C++ backend has no guards, inlined calls are left out of its IR
+    if (m_flags & EMIT_CPP)
+        M_cppBackend();
+
+    M_optimizeIR();
+
     if (m_flags & PP_IR)
         M_prettyPrint();
 
@@ -87,6 +93,7 @@ void Compiler::M_transformAST()
 
     NodeVisitor::apply<BindNames>(m_root, m_parser);
     NodeVisitor::apply<ResolveNames>(m_root, m_parser);
+    NodeVisitor::apply<FoldConstants>(m_root, m_parser);
     NodeVisitor::apply<ResolveConsts>(m_root, m_parser);
 }
 
@@ -94,11 +101,31 @@ void Compiler::M_generateIR()
 {
     NodeGenerator::transform<GenerateIR>(m_root, m_parser);
     NodeVisitor::apply<CleanLabels>(m_root, m_parser);
+    NodeVisitor::apply<DevirtualizeMethods>(m_root, m_parser);
+}
+
+void Compiler::M_optimizeIR()
+{
+    NodeVisitor::apply<InferTypes>(m_root, m_parser);
+    NodeVisitor::apply<InlineMethods>(m_root, m_parser);
+    NodeVisitor::apply<OptimizeFunctions>(m_root, m_parser);
+
+    OptimizePeepholes peepholes(m_parser);
+    m_root->accept(&peepholes);
+
+    if (m_flags & PEEPHOLE_STATS)
+    {
+        for (int i = 0; i < OptimizePeepholes::RULES_COUNT; ++i)
+        {
+            OptimizePeepholes::Rule rule = (OptimizePeepholes::Rule) i;
+            m_out << OptimizePeepholes::ruleName(rule) << ": " << peepholes.hits(rule) << std::endl;
+        }
+    }
 }
 
 Blob Compiler::M_byteCodeBackend()
 {
-    ByteCodeBackend* backend = new ByteCodeBackend(m_parser);
+    ByteCodeBackend* backend = new ByteCodeBackend(m_parser, m_module);
     m_root->accept(backend);
 
     backend->finalize();
@@ -108,6 +135,12 @@ Blob Compiler::M_byteCodeBackend()
     return blob;
 }
 
+void Compiler::M_cppBackend()
+{
+    CppBackend backend(m_parser, m_module, m_out);
+    m_root->accept(&backend);
+}
+
 void Compiler::M_prettyPrint()
 {
     NodeVisitor::apply<PrettyPrint>(m_root, m_parser, m_out);
@@ -3,12 +3,15 @@
 #include "lang/ast/node_visitor.hpp"
 #include "lang/parser_base.hpp"
 #include "core/class.hpp"
+#include "vm/module.hpp"
 
 #include "lang/std_names.hpp"
 #include "lib/dict.hpp"
 
 #include <vector>
 #include <algorithm>
+#include <cstring>
+#include <unordered_map>
 
 using namespace lang;
 using namespace ast;
@@ -17,11 +20,35 @@ using namespace bits;
 using namespace lib;
 using namespace core;
 
-ByteCodeBackend::ByteCodeBackend(ParserBase* parser)
+// Specialized form of a method called on two integers
+static Opcode int_method(std::string const& name)
+{
+    static const std::unordered_map<std::string, Opcode> opcodes =
+    {
+        { std_add, ADD_INT },
+        { std_sub, SUB_INT },
+        { std_mul, MUL_INT },
+        { std_div, DIV_INT },
+        { std_mod, MOD_INT },
+        { std_equals, EQ_INT },
+        { std_nequals, NE_INT },
+        { std_lt, LT_INT },
+        { std_lte, LE_INT },
+        { std_gt, GT_INT },
+        { std_gte, GE_INT }
+    };
+
+    auto it = opcodes.find(name);
+    return it != opcodes.end() ? it->second : INVALID;
+}
+
+ByteCodeBackend::ByteCodeBackend(ParserBase* parser, vm::Module const& module)
     : NodeVisitor(parser)
     , m_assembler(nullptr)
 {
-    m_assembler = new Assembler(m_blob);
+    m_builder.setModuleName(module.name());
+
+    m_assembler = new Assembler(m_builder);
     m_assembler->setDebugInfo(parser->streamName());
 }
 
@@ -29,7 +56,10 @@ ByteCodeBackend::~ByteCodeBackend()
 { delete m_assembler; }
 
 void ByteCodeBackend::finalize()
-{ m_assembler->finalize(); }
+{
+    m_assembler->finalize();
+    m_blob = m_builder.build();
+}
 
 Blob const& ByteCodeBackend::blob() const
 { return m_blob; }
@@ -41,11 +71,13 @@ void ByteCodeBackend::visit(IR_ProgNode* node)
     {
         if (it->which() == Symbol::Const)
         {
-            if (!m_blob.addConstant(it->data().classid(), it->data().serialize()))
+            if (!M_addConstant(it->data()))
                 M_error(node, "internal error: unable to add constant entry to blob");
         }
     }
 
+    M_numberSymbols(node->siblings()[0]);
+
     // Generate bytecode for the whole program
     node->siblings()[0]->accept(this);
 }
@@ -60,7 +92,7 @@ void ByteCodeBackend::visit(IR_FunDeclNode* node)
 
     // Add function signature
     blob_idx sigidx;
-    if (!m_blob.addSignature(sigidx))
+    if (!m_builder.addSignature(sigidx))
         M_error(node, "internal error: unable to insert symbol signature in blob");
 
     // Populate function signature
@@ -69,16 +101,18 @@ void ByteCodeBackend::visit(IR_FunDeclNode* node)
         if (it->which() == Symbol::Argument)
         {
             Class::Id id = it->data().unwrap<Class::Id>();
-            if (!m_blob.addSignatureArgument(sigidx, id))
+            if (!m_builder.addSignatureArgument(sigidx, id))
                 M_error(node, "internal error: unable to insert signature argument");
         }
     }
 
     // Add symbol entry
     blob_idx symidx;
-    blob_symbol* symbol = m_blob.addSymbol(node->name, &symidx);
+    blob_symbol* symbol = m_builder.addSymbol(node->name, &symidx);
     if (!symbol)
         M_error(node, "internal error: unable to insert symbol in blob");
+    if (symidx != m_symbols[node])
+        M_error(node, "internal error: symbol index differs from the expected one");
 
     // Setup symbol entry
     symbol->s_addr = (blob_off) addr;
@@ -90,7 +124,7 @@ void ByteCodeBackend::visit(IR_FunDeclNode* node)
         symbol->s_type = BLOB_SYMT_METHOD;
         symbol->s_bind = BLOB_SYMB_LOCAL;
 
-        if (!m_blob.addTypeSpecSymbol(M_currentClassDeclIndex(), symidx))
+        if (!m_builder.addTypeSpecSymbol(M_currentClassDeclIndex(), symidx))
             M_error(node, "internal error: unable to insert symbol to type spec in blob");
     }
     else
@@ -105,7 +139,7 @@ void ByteCodeBackend::visit(IR_FunDeclNode* node)
 void ByteCodeBackend::visit(IR_ClassDeclNode* node)
 {
     blob_idx tsidx;
-    if (!m_blob.addTypeSpec(node->name, &tsidx))
+    if (!m_builder.addTypeSpec(node->name, &tsidx))
         M_error(node, "internal error: unable to create a new type in blob");
 
     M_pushClassDeclIndex(tsidx);
@@ -195,6 +229,37 @@ void ByteCodeBackend::visit(IR_MethodNode* node)
     M_follow(node);
 }
 
+void ByteCodeBackend::visit(IR_MethodIntNode* node)
+{
+    Opcode opcode = int_method(node->name);
+    if (opcode == INVALID)
+        M_error(node, "internal error: no integer instruction for this method");
+
+    // Same operands as METHOD, which the engine falls back to
+    m_assembler->emit(opcode, { node->name, 1 }, node->startToken());
+    M_follow(node);
+}
+
+void ByteCodeBackend::visit(IR_CallSymbolNode* node)
+{
+    auto it = m_symbols.find(node->target);
+    if (it == m_symbols.end())
+        M_error(node, "internal error: call to an unknown symbol");
+
+    m_assembler->emit(node->typed ? CALL_SYMBOL_TYPED : CALL_SYMBOL, { (int) it->second, node->argc }, node->startToken());
+    M_follow(node);
+}
+
+void ByteCodeBackend::visit(IR_GuardSymbolNode* node)
+{
+    auto it = m_symbols.find(node->target);
+    if (it == m_symbols.end())
+        M_error(node, "internal error: guard on an unknown symbol");
+
+    m_assembler->emit(GUARD_SYMBOL, { (int) it->second, Operand::label(node->name) }, node->startToken());
+    M_follow(node);
+}
+
 void ByteCodeBackend::visit(IR_ReturnNode* node)
 {
     m_assembler->emit(RETURN, { }, node->startToken());
@@ -228,6 +293,51 @@ void ByteCodeBackend::visit(IR_ImportMaskNode* node)
 void ByteCodeBackend::visitDefault(Node* node)
 { M_error(node, "unimplemented"); }
 
+bool ByteCodeBackend::M_addConstant(Object const& value)
+{
+    blob_long classid = value.classid();
+    Some const& meta = value.meta();
+
+    // Builtin scalars are stored as is, so that loading them
+    //   does not go through __unserialize__
+    if (meta.is<int>())
+        return m_builder.addConstant(classid, BLOB_CST_INT, (blob_long) (int64_t) meta.as<int>());
+    else if (meta.is<std::size_t>())
+        return m_builder.addConstant(classid, BLOB_CST_ULONG, (blob_long) meta.as<std::size_t>());
+    else if (meta.is<float>())
+    {
+        float f = meta.as<float>();
+        uint32_t bits;
+        std::memcpy(&bits, &f, sizeof(float));
+        return m_builder.addConstant(classid, BLOB_CST_FLOAT, bits);
+    }
+    else if (meta.is<bool>())
+        return m_builder.addConstant(classid, BLOB_CST_BOOL, meta.as<bool>() ? 1 : 0);
+    else if (meta.is<char>())
+        return m_builder.addConstant(classid, BLOB_CST_CHAR, (blob_long) (unsigned char) meta.as<char>());
+    else if (meta.is<std::string>())
+    {
+        blob_off soff;
+        if (!m_builder.addString(meta.as<std::string>(), soff))
+            return false;
+        return m_builder.addConstant(classid, BLOB_CST_STRING, soff);
+    }
+
+    return m_builder.addConstant(classid, value.serialize());
+}
+
+void ByteCodeBackend::M_numberSymbols(Node* node)
+{
+    // Symbols are added in the order the functions are visited
+    for (Node* it = node; it; it = it->next())
+    {
+        if (IR_FunDeclNode* fun = dynamic_cast<IR_FunDeclNode*>(it))
+            m_symbols[fun] = (blob_idx) m_symbols.size();
+        else if (dynamic_cast<IR_ClassDeclNode*>(it))
+            M_numberSymbols(it->siblings()[0]);
+    }
+}
+
 bool ByteCodeBackend::M_inClassDecl() const
 { return m_class_decls.size(); }
 
@@ -0,0 +1,922 @@
+#include "lang/pass/cpp_backend.hpp"
+#include "lang/ast/node.hpp"
+#include "lang/ast/node_visitor.hpp"
+#include "lang/parser_base.hpp"
+#include "lang/std_names.hpp"
+#include "core/core.hpp"
+
+#include <iomanip>
+#include <algorithm>
+
+using namespace lang;
+using namespace ast;
+using namespace pass;
+using namespace core;
+
+namespace
+{
+    // Operators of int that are computed unboxed (the comparisons derived
+    //   by core::Class from __lt__ and __equals__ are exact for ints)
+    struct IntOperator
+    {
+        char const* op;
+        bool compare;
+    };
+
+    IntOperator const* int_operator(std::string const& name)
+    {
+        static const std::map<std::string, IntOperator> operators =
+        {
+            { std_add,     { "+",  false } },
+            { std_sub,     { "-",  false } },
+            { std_mul,     { "*",  false } },
+            { std_div,     { "/",  false } },
+            { std_mod,     { "%",  false } },
+            { std_equals,  { "==", true } },
+            { std_nequals, { "!=", true } },
+            { std_lt,      { "<",  true } },
+            { std_lte,     { "<=", true } },
+            { std_gt,      { ">",  true } },
+            { std_gte,     { ">=", true } }
+        };
+
+        auto it = operators.find(name);
+        return it != operators.end() ? &it->second : nullptr;
+    }
+}
+
+CppBackend::CppBackend(ParserBase* parser, vm::Module const& module, std::ostream& out)
+    : NodeVisitor(parser)
+    , m_module(module)
+    , m_out(out)
+    , m_collect(true)
+    , m_function(-1)
+    , m_reachable(true)
+{}
+
+CppBackend::~CppBackend()
+{}
+
+void CppBackend::visit(IR_ProgNode* node)
+{
+    Symtab* top = node->symtab()->top();
+    for (auto it = top->begin(); it != top->end(); ++it)
+    {
+        if (it->which() == Symbol::Const)
+            m_constants.push_back(it->data());
+    }
+
+    // Functions must all be known before direct calls are emitted
+    m_collect = true;
+    node->siblings()[0]->accept(this);
+    m_collect = false;
+    node->siblings()[0]->accept(this);
+
+    std::string const& module_name = m_module.name();
+
+    m_out << "// Module `" << module_name << "' compiled ahead of time by Axolotl, do not edit." << std::endl;
+    m_out << "// Class identifiers are computed by the runtime, except those of classes" << std::endl;
+    m_out << "//   the compiler does not know about, build this unit with the same" << std::endl;
+    m_out << "//   toolchain as the interpreter." << std::endl;
+    m_out << std::endl;
+    m_out << "#include \"vm/aot.hpp\"" << std::endl;
+    m_out << std::endl;
+    m_out << "namespace" << std::endl;
+    m_out << "{" << std::endl;
+    m_out << "    vm::aot::Unit* u = nullptr;" << std::endl;
+    m_out << std::endl;
+
+    std::vector<std::string> names(m_names.size());
+    for (auto const& name : m_names)
+        names[name.second] = name.first;
+
+    for (int i = 0; i < (int) names.size(); ++i)
+        m_out << "    core::Atom const n" << i << "(" << M_quote(names[i]) << ");" << std::endl;
+    if (names.size())
+        m_out << std::endl;
+
+    for (int i = 0; i < (int) m_functions.size(); ++i)
+        m_out << "    " << M_prototype(i) << ";" << std::endl;
+    m_out << std::endl;
+
+    m_out << m_code.str();
+
+    // The record function builds the module the way vm::Module does
+    //   from a blob: functions, classes then constants
+    m_out << "    void record()" << std::endl;
+    m_out << "    {" << std::endl;
+    m_out << "        u = new vm::aot::Unit();" << std::endl;
+    m_out << "        u->module = vm::Module(" << M_quote(module_name) << ");" << std::endl;
+    m_out << "        u->imports = vm::Module(" << M_quote(module_name) << ");" << std::endl;
+    m_out << "        vm::ImportTable::addBuiltin(u->module);" << std::endl;
+
+    auto callable = [&](int index)
+    {
+        Function const& fun = m_functions[index];
+
+        std::ostringstream ss;
+        ss << "vm::aot::function({ ";
+        for (int i = 0; i < (int) fun.arguments.size(); ++i)
+            ss << (i ? ", " : "") << M_class(fun.arguments[i]);
+        ss << (fun.arguments.size() ? " }" : "}");
+        ss << ", [](std::vector<core::Object> const&" << (fun.arguments.size() ? " args" : "") << ") { return f" << index << "(";
+        for (int i = 0; i < (int) fun.arguments.size(); ++i)
+        {
+            ss << (i ? ", " : "") << "args[" << i << "]";
+            if (M_isInt(fun.arguments[i]))
+                ss << ".unwrap<int>()";
+        }
+        ss << "); })";
+
+        return ss.str();
+    };
+
+    m_out << std::endl;
+    for (int i = 0; i < (int) m_functions.size(); ++i)
+    {
+        if (m_functions[i].classname.size())
+            continue;
+
+        m_out << "        u->module.global(" << M_quote(m_functions[i].name) << ") = " << callable(i) << ";" << std::endl;
+    }
+
+    for (auto const& classname : m_classes)
+    {
+        m_out << std::endl;
+        m_out << "        {" << std::endl;
+        m_out << "            core::Class c(" << M_quote(module_name) << ", " << M_quote(classname) << ", true);" << std::endl;
+        for (int i = 0; i < (int) m_functions.size(); ++i)
+        {
+            if (m_functions[i].classname != classname)
+                continue;
+
+            m_out << "            c.addMember(" << M_quote(m_functions[i].name) << ", " << callable(i) << ");" << std::endl;
+        }
+        m_out << "            u->module.global(" << M_quote(classname) << ") = c;" << std::endl;
+        m_out << "        }" << std::endl;
+    }
+
+    if (m_constants.size())
+        m_out << std::endl;
+    for (auto const& constant : m_constants)
+    {
+        m_out << "        u->constants.push_back(u->module.constant(u->module.addConstant(core::class_from_classid("
+              << M_class(constant.classid()) << ").unserialize(" << M_quote(constant.serialize()) << "))));" << std::endl;
+    }
+
+    std::vector<std::string> globals(m_globals.size());
+    for (auto const& global : m_globals)
+        globals[global.second] = global.first;
+
+    if (globals.size())
+        m_out << std::endl;
+    for (auto const& global : globals)
+        m_out << "        u->globals.push_back(&u->module.global(" << M_quote(global) << "));" << std::endl;
+
+    m_out << "    }" << std::endl;
+    m_out << std::endl;
+    m_out << "    bool recorded = vm::aot::add(&record);" << std::endl;
+    m_out << "}" << std::endl;
+}
+
+void CppBackend::visit(IR_FunDeclNode* node)
+{
+    if (m_collect)
+    {
+        Function fun;
+        fun.name = node->name;
+        fun.classname = m_classname;
+        fun.locals = node->symtab()->localsCount();
+
+        for (auto it = node->symtab()->begin(); it != node->symtab()->end(); ++it)
+        {
+            if (it->which() == Symbol::Argument)
+                fun.arguments.push_back(it->data().unwrap<Class::Id>());
+        }
+
+        m_function_index[node] = (int) m_functions.size();
+        m_functions.push_back(fun);
+
+        node->siblings()[0]->accept(this);
+        M_follow(node);
+        return;
+    }
+
+    m_function = m_function_index[node];
+    m_body.str("");
+    m_stack.clear();
+    for (auto& slots : m_slots)
+        slots.clear();
+    m_label_depths.clear();
+    m_label_ids.clear();
+    m_reachable = true;
+
+    node->siblings()[0]->accept(this);
+
+    // Functions end with LEAVE, this is only a safety net
+    if (m_reachable)
+        M_line("return core::Object::nil();");
+
+    Function const& fun = m_functions[m_function];
+
+    m_code << "    // " << m_module.name() << "." << (fun.classname.size() ? fun.classname + "." : "") << fun.name << std::endl;
+    m_code << "    " << M_prototype(m_function) << std::endl;
+    m_code << "    {" << std::endl;
+
+    if (fun.locals)
+    {
+        m_code << "        core::Object";
+        for (int i = 0; i < (int) fun.locals; ++i)
+            m_code << (i ? ", l" : " l") << i;
+        m_code << ";" << std::endl;
+    }
+
+    static char const* declarations[] = { "core::Object", "int", "bool" };
+    static char const* initializers[] = { "", " = 0", " = false" };
+    for (int type = T_OBJECT; type <= T_BOOL; ++type)
+    {
+        if (m_slots[type].empty())
+            continue;
+
+        m_code << "        " << declarations[type];
+        bool first = true;
+        for (int index : m_slots[type])
+        {
+            m_code << (first ? " " : ", ") << M_slot((Type) type, index) << initializers[type];
+            first = false;
+        }
+        m_code << ";" << std::endl;
+    }
+
+    m_code << std::endl;
+    m_code << m_body.str();
+    m_code << "    }" << std::endl;
+    m_code << std::endl;
+
+    M_follow(node);
+}
+
+void CppBackend::visit(IR_ClassDeclNode* node)
+{
+    if (m_collect)
+        m_classes.push_back(node->name);
+
+    m_classname = node->name;
+    node->siblings()[0]->accept(this);
+    m_classname = "";
+
+    M_follow(node);
+}
+
+void CppBackend::visit(IR_LoadConstNode* node)
+{
+    if (M_collecting(node))
+        return;
+
+    int index = M_top() + 1;
+
+    // Constants table
+    if (node->index >= 0)
+    {
+        if (node->index >= (int) m_constants.size())
+            M_error(node, "internal error: invalid constant index");
+
+        Object const& constant = m_constants[node->index];
+
+        if (constant.meta().is<int>())
+        {
+            M_line(M_slot(T_INT, index) + " = " + std::to_string(constant.unwrap<int>()) + ";");
+            M_push(node, T_INT);
+        }
+        else if (constant.meta().is<bool>())
+        {
+            M_line(M_slot(T_BOOL, index) + " = " + (constant.unwrap<bool>() ? "true" : "false") + ";");
+            M_push(node, T_BOOL);
+        }
+        else
+        {
+            M_line(M_slot(T_OBJECT, index) + " = u->constants[" + std::to_string(node->index) + "];");
+            M_push(node, T_OBJECT);
+        }
+    }
+    // Arguments
+    else
+    {
+        Function const& fun = m_functions[m_function];
+        int arg = - node->index - 1;
+        if (arg >= (int) fun.arguments.size())
+            M_error(node, "internal error: invalid argument index");
+
+        Type type = M_isInt(fun.arguments[arg]) ? T_INT : T_OBJECT;
+        M_line(M_slot(type, index) + " = a" + std::to_string(arg) + ";");
+        M_push(node, type);
+    }
+
+    M_follow(node);
+}
+
+void CppBackend::visit(IR_LoadGlobalNode* node)
+{
+    if (M_collecting(node))
+        return;
+
+    int function = M_direct(node->name);
+
+    // Functions are only loaded if they are not called directly
+    if (function >= 0)
+    {
+        M_push(node, T_FUNCTION, function, M_global(node->name));
+    }
+    else if (M_defines(node->name))
+    {
+        M_line(M_slot(T_OBJECT, M_top() + 1) + " = *u->globals[" + std::to_string(M_global(node->name)) + "];");
+        M_push(node, T_OBJECT);
+    }
+    // Imported names are looked up when they are loaded, importing
+    //   a module may replace them
+    else
+    {
+        M_line(M_slot(T_OBJECT, M_top() + 1) + " = u->imports.global(n" + std::to_string(M_name(node->name)) + ");");
+        M_push(node, T_OBJECT);
+    }
+
+    M_follow(node);
+}
+
+void CppBackend::visit(IR_StorGlobalNode* node)
+{
+    if (m_collect)
+    {
+        m_stored_globals.insert(node->name);
+        M_follow(node);
+        return;
+    }
+
+    M_line("*u->globals[" + std::to_string(M_global(node->name)) + "] = " + M_stored(M_top()) + ";");
+    M_pop(node);
+
+    M_follow(node);
+}
+
+void CppBackend::visit(IR_LoadLocalNode* node)
+{
+    if (M_collecting(node))
+        return;
+
+    M_line(M_slot(T_OBJECT, M_top() + 1) + " = l" + std::to_string(node->index) + ";");
+    M_push(node, T_OBJECT);
+
+    M_follow(node);
+}
+
+void CppBackend::visit(IR_StorLocalNode* node)
+{
+    if (M_collecting(node))
+        return;
+
+    M_line("l" + std::to_string(node->index) + " = " + M_stored(M_top()) + ";");
+    M_pop(node);
+
+    M_follow(node);
+}
+
+void CppBackend::visit(IR_LoadMemberNode* node)
+{
+    if (M_collecting(node))
+        return;
+
+    int self = M_top();
+    std::string expr = "vm::aot::loadMember(" + M_box(self) + ", n" + std::to_string(M_name(node->name)) + ")";
+
+    M_pop(node);
+    M_line(M_slot(T_OBJECT, self) + " = " + expr + ";");
+    M_push(node, T_OBJECT);
+
+    M_follow(node);
+}
+
+void CppBackend::visit(IR_StorMemberNode* node)
+{
+    if (M_collecting(node))
+        return;
+
+    // The object is on top of the value
+    int self = M_top();
+    if (self < 1)
+        M_error(node, "internal error: operand stack underflow");
+
+    M_line("vm::aot::storMember(" + M_box(self) + ", n" + std::to_string(M_name(node->name)) + ", " + M_box(self - 1) + ");");
+    M_pop(node);
+    M_pop(node);
+
+    M_follow(node);
+}
+
+void CppBackend::visit(IR_LabelNode* node)
+{
+    if (M_collecting(node))
+        return;
+
+    if (!m_used_labels.count(node->name))
+    {
+        M_follow(node);
+        return;
+    }
+
+    // Every edge reaching a label has its operands boxed
+    auto it = m_label_depths.find(node->name);
+    if (m_reachable)
+    {
+        M_spill((int) m_stack.size());
+        M_checkDepth(node, node->name);
+    }
+    else if (it != m_label_depths.end())
+    {
+        m_stack.clear();
+        for (int i = 0; i < it->second; ++i)
+            M_push(node, T_OBJECT);
+    }
+    else
+    {
+        M_spill((int) m_stack.size());
+        m_label_depths[node->name] = (int) m_stack.size();
+    }
+
+    m_body << "    " << M_labelName(node->name) << ":;" << std::endl;
+    m_reachable = true;
+
+    M_follow(node);
+}
+
+void CppBackend::visit(IR_GotoNode* node)
+{
+    if (m_collect)
+    {
+        m_used_labels.insert(node->name);
+        M_follow(node);
+        return;
+    }
+
+    // Jumps following a return are never taken
+    if (m_reachable)
+        M_jump(node, node->name, 0);
+    m_reachable = false;
+
+    M_follow(node);
+}
+
+void CppBackend::visit(IR_GotoIfTrueNode* node)
+{
+    if (m_collect)
+    {
+        m_used_labels.insert(node->name);
+        M_follow(node);
+        return;
+    }
+
+    M_jump(node, node->name, 1);
+    M_follow(node);
+}
+
+void CppBackend::visit(IR_GotoIfFalseNode* node)
+{
+    if (m_collect)
+    {
+        m_used_labels.insert(node->name);
+        M_follow(node);
+        return;
+    }
+
+    M_jump(node, node->name, -1);
+    M_follow(node);
+}
+
+void CppBackend::visit(IR_InvokeNode* node)
+{
+    if (M_collecting(node))
+        return;
+
+    // Arguments are below the function
+    int top = M_top();
+    int base = top - node->argc;
+    if (base < 0)
+        M_error(node, "internal error: operand stack underflow");
+
+    Slot fun = m_stack[top];
+    std::ostringstream ss;
+
+    // A direct call needs no signature check, so it is only made
+    //   when the arguments are known to match
+    bool direct = false;
+    if (fun.type == T_FUNCTION)
+    {
+        Function const& callee = m_functions[fun.function];
+        direct = node->argc == (int) callee.arguments.size();
+
+        std::ostringstream args;
+        for (int i = 0; direct && i < node->argc; ++i)
+        {
+            Class::Id classid = callee.arguments[i];
+            if (M_isInt(classid) && m_stack[base + i].type == T_INT)
+                args << (i ? ", " : "") << M_slot(T_INT, base + i);
+            else if (classid == Class::AnyId)
+                args << (i ? ", " : "") << M_box(base + i);
+            else
+                direct = false;
+        }
+
+        if (direct)
+            ss << "f" << fun.function << "(" << args.str() << ")";
+    }
+
+    if (!direct)
+    {
+        ss << "vm::aot::invoke(" << M_box(top) << ", {";
+        for (int i = 0; i < node->argc; ++i)
+            ss << (i ? ", " : " ") << M_box(base + i);
+        ss << (node->argc ? " })" : "})");
+    }
+
+    for (int i = 0; i <= node->argc; ++i)
+        M_pop(node);
+
+    M_line(M_slot(T_OBJECT, base) + " = " + ss.str() + ";");
+    M_push(node, T_OBJECT);
+
+    M_follow(node);
+}
+
+void CppBackend::visit(IR_MethodNode* node)
+{
+    if (M_collecting(node))
+        return;
+
+    M_method(node, node->name, node->argc);
+    M_follow(node);
+}
+
+void CppBackend::visit(IR_MethodIntNode* node)
+{
+    if (M_collecting(node))
+        return;
+
+    M_method(node, node->name, 1);
+    M_follow(node);
+}
+
+void CppBackend::visit(IR_CallSymbolNode* node)
+{
+    if (M_collecting(node))
+        return;
+
+    // The generated code has no symbols to branch to, the method
+    //   is dispatched as usual
+    M_method(node, node->name, node->argc);
+    M_follow(node);
+}
+
+void CppBackend::visit(IR_ReturnNode* node)
+{
+    if (M_collecting(node))
+        return;
+
+    M_line("return " + M_box(M_top()) + ";");
+    M_pop(node);
+    m_reachable = false;
+
+    M_follow(node);
+}
+
+void CppBackend::visit(IR_LeaveNode* node)
+{
+    if (M_collecting(node))
+        return;
+
+    M_line("return core::Object::nil();");
+    m_reachable = false;
+
+    M_follow(node);
+}
+
+void CppBackend::visit(IR_PopNode* node)
+{
+    if (M_collecting(node))
+        return;
+
+    M_pop(node);
+    M_follow(node);
+}
+
+void CppBackend::visit(IR_ImportNode* node)
+{
+    if (M_collecting(node))
+        return;
+
+    M_line("vm::aot::import(*u, n" + std::to_string(M_name(node->name)) + ".name());");
+    M_follow(node);
+}
+
+void CppBackend::visit(IR_ImportMaskNode* node)
+{
+    if (M_collecting(node))
+        return;
+
+    M_line("vm::aot::importMask(*u, n" + std::to_string(M_name(node->name)) +
+           ".name(), n" + std::to_string(M_name(node->mask)) + ".name());");
+    M_follow(node);
+}
+
+void CppBackend::visitDefault(Node* node)
+{ M_error(node, "unimplemented"); }
+
+bool CppBackend::M_collecting(Node* node)
+{
+    if (m_collect)
+        M_follow(node);
+
+    return m_collect;
+}
+
+void CppBackend::M_method(Node* node, std::string const& name, int argc)
+{
+    // Arguments are below the object
+    int self = M_top();
+    int base = self - argc;
+    if (base < 0)
+        M_error(node, "internal error: operand stack underflow");
+
+    IntOperator const* op = int_operator(name);
+    if (op && argc == 1 && m_stack[self].type == T_INT && m_stack[base].type == T_INT)
+    {
+        std::string expr = M_slot(T_INT, self) + " " + op->op + " " + M_slot(T_INT, base);
+        Type type = op->compare ? T_BOOL : T_INT;
+
+        M_pop(node);
+        M_pop(node);
+
+        M_line(M_slot(type, base) + " = " + expr + ";");
+        M_push(node, type);
+    }
+    else
+    {
+        std::ostringstream ss;
+        ss << "vm::aot::method(" << M_box(self) << ", n" << M_name(name) << ", {";
+        for (int i = 0; i < argc; ++i)
+            ss << (i ? ", " : " ") << M_box(base + i);
+        ss << (argc ? " })" : "})");
+
+        for (int i = 0; i <= argc; ++i)
+            M_pop(node);
+
+        M_line(M_slot(T_OBJECT, base) + " = " + ss.str() + ";");
+        M_push(node, T_OBJECT);
+    }
+}
+
+void CppBackend::M_push(Node* node, Type type, int function, int global)
+{
+    Slot slot;
+    slot.type = type;
+    slot.function = function;
+    slot.global = global;
+
+    if (type != T_FUNCTION)
+        m_slots[type].insert((int) m_stack.size());
+
+    m_stack.push_back(slot);
+}
+
+CppBackend::Slot CppBackend::M_pop(Node* node)
+{
+    if (m_stack.empty())
+        M_error(node, "internal error: operand stack underflow");
+
+    Slot slot = m_stack.back();
+    m_stack.pop_back();
+    return slot;
+}
+
+int CppBackend::M_top() const
+{ return (int) m_stack.size() - 1; }
+
+std::string CppBackend::M_box(int index) const
+{
+    Slot const& slot = m_stack.at(index);
+    std::string i = std::to_string(index);
+
+    switch (slot.type)
+    {
+        case T_INT:
+            return "core::Object(i" + i + ")";
+
+        case T_BOOL:
+            return "core::Object(b" + i + ")";
+
+        case T_FUNCTION:
+            return "(*u->globals[" + std::to_string(slot.global) + "])";
+
+        default:
+            return "o" + i;
+    }
+}
+
+std::string CppBackend::M_stored(int index) const
+{
+    // Stored values are thawed, as the engine does
+    Type type = m_stack.at(index).type;
+    if (type == T_INT || type == T_BOOL)
+        return M_box(index);
+
+    return M_box(index) + ".thawed()";
+}
+
+std::string CppBackend::M_slot(Type type, int index)
+{
+    static char const prefixes[] = { 'o', 'i', 'b' };
+
+    if (type != T_FUNCTION)
+        m_slots[type].insert(index);
+
+    return prefixes[type] + std::to_string(index);
+}
+
+void CppBackend::M_spill(int count)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        if (m_stack[i].type == T_OBJECT)
+            continue;
+
+        M_line(M_slot(T_OBJECT, i) + " = " + M_box(i) + ";");
+        m_stack[i].type = T_OBJECT;
+    }
+}
+
+void CppBackend::M_line(std::string const& line)
+{ m_body << "        " << line << std::endl; }
+
+std::string CppBackend::M_labelName(std::string const& label)
+{
+    auto it = m_label_ids.find(label);
+    if (it == m_label_ids.end())
+        it = m_label_ids.insert(std::make_pair(label, (int) m_label_ids.size())).first;
+
+    return "L" + std::to_string(it->second);
+}
+
+void CppBackend::M_checkDepth(Node* node, std::string const& label)
+{
+    auto it = m_label_depths.find(label);
+    if (it == m_label_depths.end())
+        m_label_depths[label] = (int) m_stack.size();
+    else if (it->second != (int) m_stack.size())
+        M_error(node, "internal error: inconsistent operand stack at label '" + label + "'");
+}
+
+void CppBackend::M_jump(Node* node, std::string const& label, int cond)
+{
+    std::string test;
+    if (cond)
+    {
+        int index = M_top();
+        if (index < 0)
+            M_error(node, "internal error: operand stack underflow");
+
+        if (m_stack[index].type == T_BOOL)
+            test = M_slot(T_BOOL, index);
+        else
+            test = "vm::aot::truth(" + M_box(index) + ")";
+
+        if (cond < 0)
+            test = "!" + test;
+
+        M_pop(node);
+    }
+
+    M_spill((int) m_stack.size());
+    M_checkDepth(node, label);
+
+    if (cond)
+        M_line("if (" + test + ") goto " + M_labelName(label) + ";");
+    else
+        M_line("goto " + M_labelName(label) + ";");
+}
+
+int CppBackend::M_name(std::string const& name)
+{
+    auto it = m_names.find(name);
+    if (it == m_names.end())
+        it = m_names.insert(std::make_pair(name, (int) m_names.size())).first;
+
+    return it->second;
+}
+
+int CppBackend::M_global(std::string const& name)
+{
+    auto it = m_globals.find(name);
+    if (it == m_globals.end())
+        it = m_globals.insert(std::make_pair(name, (int) m_globals.size())).first;
+
+    return it->second;
+}
+
+int CppBackend::M_direct(std::string const& name) const
+{
+    // Only functions of the module that are never assigned
+    if (m_stored_globals.count(name) || name == std_main)
+        return -1;
+
+    for (int i = 0; i < (int) m_functions.size(); ++i)
+    {
+        if (m_functions[i].classname.empty() && m_functions[i].name == name)
+            return i;
+    }
+
+    return -1;
+}
+
+bool CppBackend::M_defines(std::string const& name) const
+{
+    if (m_stored_globals.count(name))
+        return true;
+
+    for (auto const& fun : m_functions)
+    {
+        if (fun.classname.empty() && fun.name == name)
+            return true;
+    }
+
+    return std::find(m_classes.begin(), m_classes.end(), name) != m_classes.end();
+}
+
+bool CppBackend::M_isInt(Class::Id classid) const
+{ return classid == type_class<int>().classid(); }
+
+std::string CppBackend::M_class(Class::Id classid) const
+{
+    if (classid == Class::AnyId)
+        return "core::Class::AnyId";
+
+    // Builtin classes
+    if (classid == type_class<int>().classid())
+        return "core::type_class<int>().classid()";
+    if (classid == type_class<bool>().classid())
+        return "core::type_class<bool>().classid()";
+    if (classid == type_class<float>().classid())
+        return "core::type_class<float>().classid()";
+    if (classid == type_class<std::size_t>().classid())
+        return "core::type_class<std::size_t>().classid()";
+    if (classid == type_class<std::string>().classid())
+        return "core::type_class<std::string>().classid()";
+    if (classid == type_class<std::vector<Object>>().classid())
+        return "core::type_class<std::vector<core::Object>>().classid()";
+    if (classid == Object::nil().classid())
+        return "core::Object::nil().classid()";
+
+    // Classes of this module
+    for (auto const& classname : m_classes)
+    {
+        if (classid == Class::hashId(m_module.name(), classname))
+            return "core::Class::hashId(" + M_quote(m_module.name()) + ", " + M_quote(classname) + ")";
+    }
+
+    return "(core::Class::Id) " + std::to_string(classid) + "ULL";
+}
+
+std::string CppBackend::M_prototype(int index) const
+{
+    Function const& fun = m_functions[index];
+
+    std::ostringstream ss;
+    ss << "core::Object f" << index << "(";
+    for (int i = 0; i < (int) fun.arguments.size(); ++i)
+        ss << (i ? ", " : "") << (M_isInt(fun.arguments[i]) ? "int a" : "core::Object a") << i;
+    ss << ")";
+
+    return ss.str();
+}
+
+std::string CppBackend::M_quote(std::string const& str)
+{
+    std::ostringstream ss;
+    ss << '"';
+    for (unsigned char c : str)
+    {
+        switch (c)
+        {
+            case '"':  ss << "\\\""; break;
+            case '\\': ss << "\\\\"; break;
+            case '\n': ss << "\\n";  break;
+            case '\t': ss << "\\t";  break;
+            default:
+                if (c < 0x20 || c >= 0x7F)
+                    ss << '\\' << std::oct << std::setw(3) << std::setfill('0') << (int) c << std::dec;
+                else
+                    ss << c;
+                break;
+        }
+    }
+    ss << '"';
+
+    return ss.str();
+}
@@ -0,0 +1,229 @@
+#include "lang/pass/devirtualize_methods.hpp"
+#include "lang/ast/node.hpp"
+#include "lang/ast/node_visitor.hpp"
+#include "lang/symtab.hpp"
+#include "core/type_registry.hpp"
+
+#include "lang/ast/ast.hpp"
+#include "lang/std_names.hpp"
+
+using namespace lang;
+using namespace ast;
+using namespace pass;
+using namespace core;
+
+DevirtualizeMethods::~DevirtualizeMethods()
+{}
+
+void DevirtualizeMethods::visit(IR_ProgNode* node)
+{
+    // Same order as the constants table of the blob
+    Symtab* top = node->symtab()->top();
+    for (auto it = top->begin(); it != top->end(); ++it)
+    {
+        if (it->which() == Symbol::Const)
+            m_constants.push_back(it->data().classid());
+    }
+
+    M_collectStoredMembers(node);
+
+    node->siblings()[0]->accept(this);
+}
+
+void DevirtualizeMethods::visit(IR_ClassDeclNode* node)
+{
+    std::vector<IR_FunDeclNode*> methods;
+    for (Node* it = node->siblings()[0]; it; it = it->next())
+    {
+        if (IR_FunDeclNode* fun = dynamic_cast<IR_FunDeclNode*>(it))
+            methods.push_back(fun);
+    }
+
+    for (auto fun : methods)
+        M_devirtualize(fun, methods);
+
+    M_follow(node);
+}
+
+void DevirtualizeMethods::M_collectStoredMembers(Node* node)
+{
+    for (Node* it = node; it; it = it->next())
+    {
+        if (IR_StorMemberNode* stor = dynamic_cast<IR_StorMemberNode*>(it))
+            m_stored_members.insert(stor->name);
+
+        for (auto sib : it->siblings())
+            M_collectStoredMembers(sib);
+    }
+}
+
+void DevirtualizeMethods::M_devirtualize(IR_FunDeclNode* fun, std::vector<IR_FunDeclNode*> const& methods)
+{
+    TypeStack args = M_signature(fun);
+    TypeStack stack;
+
+    for (Node* it = fun->siblings()[0]; it; )
+    {
+        Node* next = it->next();
+
+        if (IR_LoadConstNode* load = dynamic_cast<IR_LoadConstNode*>(it))
+        {
+            std::size_t index = load->index < 0 ? (std::size_t) (-load->index - 1) : (std::size_t) load->index;
+            TypeStack const& table = load->index < 0 ? args : m_constants;
+            stack.push_back(index < table.size() ? table[index] : Class::AnyId);
+        }
+        else if (dynamic_cast<IR_LoadGlobalNode*>(it) || dynamic_cast<IR_LoadLocalNode*>(it))
+            stack.push_back(Class::AnyId);
+        else if (dynamic_cast<IR_LoadMemberNode*>(it))
+        {
+            if (stack.empty())
+                return;
+            stack.back() = Class::AnyId;
+        }
+        else if (dynamic_cast<IR_StorLocalNode*>(it) || dynamic_cast<IR_StorGlobalNode*>(it) ||
+                 dynamic_cast<IR_PopNode*>(it) || dynamic_cast<IR_ReturnNode*>(it) ||
+                 dynamic_cast<IR_GotoIfTrueNode*>(it) || dynamic_cast<IR_GotoIfFalseNode*>(it))
+        {
+            if (stack.empty())
+                return;
+            stack.pop_back();
+        }
+        else if (dynamic_cast<IR_StorMemberNode*>(it))
+        {
+            if (stack.size() < 2)
+                return;
+            stack.resize(stack.size() - 2);
+        }
+        else if (IR_InvokeNode* invoke = dynamic_cast<IR_InvokeNode*>(it))
+        {
+            if ((int) stack.size() < invoke->argc + 1)
+                return;
+            stack.resize(stack.size() - invoke->argc - 1);
+            stack.push_back(Class::AnyId);
+        }
+        else if (IR_MethodNode* method = dynamic_cast<IR_MethodNode*>(it))
+        {
+            int argc = method->argc;
+            if ((int) stack.size() < argc + 1)
+                return;
+
+            Class::Id result = Class::AnyId;
+            if (argc == 1)
+                result = M_resultClass(method->name, stack[stack.size() - 1], stack[stack.size() - 2]);
+
+            // Only the methods called on self have a statically known class
+            IR_LoadConstNode* self = dynamic_cast<IR_LoadConstNode*>(method->prev());
+            if (self && self->index == -1 && !m_stored_members.count(method->name))
+            {
+                // The class of self is only checked at runtime
+                TypeStack call_args(1, Class::AnyId);
+                call_args.insert(call_args.end(), stack.end() - argc - 1, stack.end() - 1);
+
+                if (IR_FunDeclNode* target = M_resolve(method->name, call_args, methods))
+                {
+                    IR_CallSymbolNode* new_node = new IR_CallSymbolNode(method->startToken());
+                    new_node->name = method->name;
+                    new_node->argc = argc;
+                    new_node->target = target;
+                    new_node->typed = false;
+
+                    method->exchangeWith(new_node);
+                    delete method;
+                }
+            }
+
+            stack.resize(stack.size() - argc - 1);
+            stack.push_back(result);
+        }
+        else if (IR_CallSymbolNode* call = dynamic_cast<IR_CallSymbolNode*>(it))
+        {
+            if ((int) stack.size() < call->argc + 1)
+                return;
+            stack.resize(stack.size() - call->argc - 1);
+            stack.push_back(Class::AnyId);
+        }
+        else if (dynamic_cast<IR_LabelNode*>(it))
+        {
+            // Jumps may land here with anything on the stack
+            for (auto& type : stack)
+                type = Class::AnyId;
+        }
+        else if (!dynamic_cast<IR_GotoNode*>(it) && !dynamic_cast<IR_LeaveNode*>(it) &&
+                 !dynamic_cast<IR_ImportNode*>(it) && !dynamic_cast<IR_ImportMaskNode*>(it))
+        {
+            // Unknown effect on the stack, nothing past it can be trusted
+            return;
+        }
+
+        it = next;
+    }
+}
+
+IR_FunDeclNode* DevirtualizeMethods::M_resolve(std::string const& name, TypeStack const& args,
+                                               std::vector<IR_FunDeclNode*> const& methods) const
+{
+    // Later definitions come first, as in the members of a class
+    IR_FunDeclNode* target = nullptr;
+    bool certain = false;
+    for (auto it = methods.rbegin(); it != methods.rend(); ++it)
+    {
+        if ((*it)->name != name)
+            continue;
+
+        TypeStack params = M_signature(*it);
+        if (params.size() != args.size())
+            continue;
+
+        bool excluded = false;
+        bool matches = true;
+        for (std::size_t i = 0; i < params.size() && !excluded; ++i)
+        {
+            if (params[i] == Class::AnyId || i == 0)
+                continue;
+
+            excluded = args[i] != Class::AnyId && params[i] != args[i];
+            matches = matches && params[i] == args[i];
+        }
+
+        if (excluded)
+            continue;
+
+        // A guess is only worth it if nothing else could be called
+        if (target)
+            return certain ? target : nullptr;
+
+        target = *it;
+        certain = matches;
+    }
+
+    return target;
+}
+
+DevirtualizeMethods::TypeStack DevirtualizeMethods::M_signature(IR_FunDeclNode* fun)
+{
+    TypeStack params;
+    for (auto it = fun->symtab()->begin(); it != fun->symtab()->end(); ++it)
+    {
+        if (it->which() == Symbol::Argument)
+            params.push_back(it->data().unwrap<Class::Id>());
+    }
+
+    return params;
+}
+
+Class::Id DevirtualizeMethods::M_resultClass(std::string const& name, Class::Id self, Class::Id arg)
+{
+    Class::Id int_id = type_class<int>().classid();
+    if (self != int_id || arg != int_id)
+        return Class::AnyId;
+
+    if (name == std_add || name == std_sub || name == std_mul ||
+        name == std_div || name == std_mod)
+        return int_id;
+
+    if (name == std_equals || name == std_nequals || name == std_lt ||
+        name == std_lte || name == std_gt || name == std_gte)
+        return type_class<bool>().classid();
+
+    return Class::AnyId;
+}
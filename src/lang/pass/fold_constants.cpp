@@ -0,0 +1,221 @@
+#include "lang/pass/fold_constants.hpp"
+#include "lang/ast/node.hpp"
+#include "lang/ast/node_visitor.hpp"
+#include "lang/symtab.hpp"
+#include "core/type_registry.hpp"
+#include "core/exception.hpp"
+
+#include "lang/ast/ast.hpp"
+#include "lang/std_names.hpp"
+
+#include <climits>
+#include <string>
+
+using namespace lang;
+using namespace ast;
+using namespace pass;
+using namespace core;
+
+FoldConstants::~FoldConstants()
+{}
+
+void FoldConstants::visit(MethodNode* node)
+{
+    // Operands first, so that nested operators fold in turn
+    for (std::size_t i = 0; i < node->siblings().size(); ++i)
+        node->siblings()[i]->accept(this);
+
+    Node* new_node = M_fold(node);
+    if (!new_node)
+        new_node = M_simplify(node);
+
+    if (new_node)
+    {
+        node->substituteInChain(new_node);
+        delete node;
+        M_follow(new_node);
+    }
+    else
+        M_follow(node);
+}
+
+Node* FoldConstants::M_fold(MethodNode* node) const
+{
+    std::vector<Node*> const& sibs = node->siblings();
+    if (!M_isPure(node->name))
+        return nullptr;
+
+    ConstNode* self = dynamic_cast<ConstNode*>(sibs[0]);
+    if (!self || !M_isFoldable(self->value))
+        return nullptr;
+
+    std::vector<Object> args;
+    if (sibs.size() > 1)
+    {
+        ConstNode* arg = dynamic_cast<ConstNode*>(sibs[1]);
+        if (!arg || arg->next() || !M_isFoldable(arg->value))
+            return nullptr;
+
+        args.push_back(arg->value);
+    }
+
+    // The integer division traps, let it happen at runtime
+    Class::Id int_id = type_class<int>().classid();
+    if ((node->name == std_div || node->name == std_mod) && args.size() == 1 &&
+        self->value.classid() == int_id && args[0].classid() == int_id)
+    {
+        int a = self->value.unwrap<int>();
+        int b = args[0].unwrap<int>();
+        if (b == 0 || (b == -1 && a == INT_MIN))
+            return nullptr;
+    }
+
+    Object value;
+    try
+    {
+        value = self->value.method(Atom(node->name), args);
+    }
+    catch (Exception const&)
+    {
+        // E.g. no overload for these operands, which is a runtime error
+        return nullptr;
+    }
+
+    if (!M_isFoldable(value))
+        return nullptr;
+
+    ConstNode* new_node = new ConstNode(node->startToken());
+    new_node->value = value;
+    return new_node;
+}
+
+Node* FoldConstants::M_simplify(MethodNode* node) const
+{
+    std::vector<Node*> const& sibs = node->siblings();
+
+    if (node->name == std_not && sibs.size() == 1)
+    {
+        MethodNode* inner = dynamic_cast<MethodNode*>(sibs[0]);
+        if (!inner || inner->name != std_not || inner->siblings().size() != 1)
+            return nullptr;
+
+        Node* operand = inner->siblings()[0];
+        if (M_classOf(operand) != type_class<bool>().classid())
+            return nullptr;
+
+        operand->remove();
+        return operand;
+    }
+
+    if (sibs.size() != 2 || sibs[1]->next())
+        return nullptr;
+
+    Node* lhs = sibs[0];
+    Node* rhs = sibs[1];
+
+    Class::Id classid = M_classOf(lhs);
+    bool is_int = classid == type_class<int>().classid();
+    bool is_float = classid == type_class<float>().classid();
+    if ((!is_int && !is_float) || M_classOf(rhs) != classid)
+        return nullptr;
+
+    // -0.0 + 0.0 is 0.0, so only the integer sum is simplified
+    Node* operand = nullptr;
+    if (node->name == std_mul)
+        operand = M_isConst(rhs, 1) ? lhs : M_isConst(lhs, 1) ? rhs : nullptr;
+    else if (node->name == std_div || node->name == std_sub)
+        operand = M_isConst(rhs, node->name == std_div ? 1 : 0) ? lhs : nullptr;
+    else if (node->name == std_add && is_int)
+        operand = M_isConst(rhs, 0) ? lhs : M_isConst(lhs, 0) ? rhs : nullptr;
+
+    if (operand)
+        operand->remove();
+
+    return operand;
+}
+
+Class::Id FoldConstants::M_classOf(Node* node) const
+{
+    if (ConstNode* cst = dynamic_cast<ConstNode*>(node))
+        return cst->value.classid();
+
+    if (ConstRefNode* ref = dynamic_cast<ConstRefNode*>(node))
+    {
+        // Literals are not resolved yet, negative indices are arguments
+        FunDeclNode* fun = nullptr;
+        for (Node* it = node->parent(); it && !fun; it = it->parent())
+            fun = dynamic_cast<FunDeclNode*>(it);
+
+        if (!fun || ref->index >= 0)
+            return Class::AnyId;
+
+        int index = -ref->index - 1;
+        for (auto it = fun->symtab()->begin(); it != fun->symtab()->end(); ++it)
+        {
+            if (it->which() == Symbol::Argument && !index--)
+                return it->data().unwrap<Class::Id>();
+        }
+
+        return Class::AnyId;
+    }
+
+    MethodNode* method = dynamic_cast<MethodNode*>(node);
+    if (!method)
+        return Class::AnyId;
+
+    std::vector<Node*> const& sibs = method->siblings();
+    Class::Id int_id = type_class<int>().classid();
+    Class::Id bool_id = type_class<bool>().classid();
+    Class::Id self = M_classOf(sibs[0]);
+
+    if (sibs.size() == 1)
+    {
+        if (method->name == std_not && self == bool_id)
+            return bool_id;
+        if (method->name == std_neg && self == int_id)
+            return int_id;
+        return Class::AnyId;
+    }
+
+    if (sibs[1]->next() || self != int_id || M_classOf(sibs[1]) != int_id)
+        return Class::AnyId;
+
+    if (method->name == std_add || method->name == std_sub || method->name == std_mul ||
+        method->name == std_div || method->name == std_mod)
+        return int_id;
+
+    if (method->name == std_equals || method->name == std_nequals || method->name == std_lt ||
+        method->name == std_lte || method->name == std_gt || method->name == std_gte)
+        return bool_id;
+
+    return Class::AnyId;
+}
+
+bool FoldConstants::M_isPure(std::string const& name)
+{
+    return name == std_add || name == std_sub || name == std_mul || name == std_div ||
+           name == std_mod || name == std_neg || name == std_not || name == std_and ||
+           name == std_or || name == std_equals || name == std_nequals || name == std_lt ||
+           name == std_lte || name == std_gt || name == std_gte;
+}
+
+bool FoldConstants::M_isFoldable(Object const& value)
+{
+    Class::Id classid = value.classid();
+    return classid == type_class<int>().classid() || classid == type_class<float>().classid() ||
+           classid == type_class<bool>().classid() || classid == type_class<std::string>().classid();
+}
+
+bool FoldConstants::M_isConst(Node* node, int value)
+{
+    ConstNode* cst = dynamic_cast<ConstNode*>(node);
+    if (!cst)
+        return false;
+
+    if (cst->value.classid() == type_class<int>().classid())
+        return cst->value.unwrap<int>() == value;
+    if (cst->value.classid() == type_class<float>().classid())
+        return cst->value.unwrap<float>() == (float) value;
+
+    return false;
+}
@@ -0,0 +1,300 @@
+#include "lang/pass/infer_types.hpp"
+#include "lang/ast/node.hpp"
+#include "lang/ast/node_visitor.hpp"
+#include "lang/symtab.hpp"
+#include "core/type_registry.hpp"
+
+#include "lang/ast/ast.hpp"
+#include "lang/std_names.hpp"
+
+using namespace lang;
+using namespace ast;
+using namespace pass;
+using namespace core;
+
+InferTypes::~InferTypes()
+{}
+
+void InferTypes::visit(IR_ProgNode* node)
+{
+    // Same order as the constants table of the blob
+    Symtab* top = node->symtab()->top();
+    for (auto it = top->begin(); it != top->end(); ++it)
+    {
+        if (it->which() == Symbol::Const)
+            m_constants.push_back(it->data().classid());
+    }
+
+    node->siblings()[0]->accept(this);
+}
+
+void InferTypes::visit(IR_ClassDeclNode* node)
+{
+    node->siblings()[0]->accept(this);
+    M_follow(node);
+}
+
+void InferTypes::visit(IR_FunDeclNode* node)
+{
+    m_labels.clear();
+
+    // The classes at the labels only widen, so this terminates
+    do
+    {
+        m_changed = false;
+        if (!M_simulate(node, false))
+        {
+            M_follow(node);
+            return;
+        }
+    } while (m_changed);
+
+    M_simulate(node, true);
+    M_follow(node);
+}
+
+bool InferTypes::M_simulate(IR_FunDeclNode* fun, bool rewrite)
+{
+    Class::Id int_id = type_class<int>().classid();
+    std::vector<Class::Id> args = M_signature(fun);
+
+    // A fresh frame has nil locals
+    State state;
+    state.reachable = true;
+    state.locals.assign(fun->symtab()->localsCount(), Object::nil().classid());
+
+    for (Node* it = fun->siblings()[0]; it; )
+    {
+        Node* next = it->next();
+
+        if (IR_LabelNode* label = dynamic_cast<IR_LabelNode*>(it))
+        {
+            if (state.reachable && !M_merge(label->name, state))
+                return false;
+
+            auto found = m_labels.find(label->name);
+            if (found != m_labels.end())
+                state = found->second;
+        }
+
+        // Nothing jumps here, yet
+        if (!state.reachable)
+        {
+            it = next;
+            continue;
+        }
+
+        std::vector<Class::Id>& stack = state.stack;
+
+        if (IR_LoadConstNode* load = dynamic_cast<IR_LoadConstNode*>(it))
+        {
+            std::size_t index = load->index < 0 ? (std::size_t) (-load->index - 1) : (std::size_t) load->index;
+            std::vector<Class::Id> const& table = load->index < 0 ? args : m_constants;
+            stack.push_back(index < table.size() ? table[index] : Class::AnyId);
+        }
+        else if (IR_LoadLocalNode* load = dynamic_cast<IR_LoadLocalNode*>(it))
+        {
+            if (load->index < 0 || load->index >= (int) state.locals.size())
+                return false;
+            stack.push_back(state.locals[load->index]);
+        }
+        else if (IR_StorLocalNode* stor = dynamic_cast<IR_StorLocalNode*>(it))
+        {
+            if (stack.empty() || stor->index < 0 || stor->index >= (int) state.locals.size())
+                return false;
+            state.locals[stor->index] = stack.back();
+            stack.pop_back();
+        }
+        else if (dynamic_cast<IR_LoadGlobalNode*>(it))
+            stack.push_back(Class::AnyId);
+        else if (dynamic_cast<IR_LoadMemberNode*>(it))
+        {
+            if (stack.empty())
+                return false;
+            stack.back() = Class::AnyId;
+        }
+        else if (dynamic_cast<IR_StorGlobalNode*>(it) || dynamic_cast<IR_PopNode*>(it))
+        {
+            if (stack.empty())
+                return false;
+            stack.pop_back();
+        }
+        else if (dynamic_cast<IR_StorMemberNode*>(it))
+        {
+            if (stack.size() < 2)
+                return false;
+            stack.resize(stack.size() - 2);
+        }
+        else if (IR_InvokeNode* invoke = dynamic_cast<IR_InvokeNode*>(it))
+        {
+            if ((int) stack.size() < invoke->argc + 1)
+                return false;
+            stack.resize(stack.size() - invoke->argc - 1);
+            stack.push_back(Class::AnyId);
+        }
+        else if (IR_MethodNode* method = dynamic_cast<IR_MethodNode*>(it))
+        {
+            int argc = method->argc;
+            if ((int) stack.size() < argc + 1)
+                return false;
+
+            // Self is on top of its arguments
+            Class::Id self = stack.back();
+            Class::Id arg = argc == 1 ? stack[stack.size() - 2] : Class::AnyId;
+            Class::Id result = M_resultClass(method->name, argc, self, arg);
+
+            if (rewrite && argc == 1 && self == int_id && arg == int_id && result != Class::AnyId)
+            {
+                IR_MethodIntNode* new_node = new IR_MethodIntNode(method->startToken());
+                new_node->name = method->name;
+
+                method->exchangeWith(new_node);
+                delete method;
+            }
+
+            stack.resize(stack.size() - argc - 1);
+            stack.push_back(result);
+        }
+        else if (IR_MethodIntNode* method = dynamic_cast<IR_MethodIntNode*>(it))
+        {
+            if (stack.size() < 2)
+                return false;
+            stack.resize(stack.size() - 2);
+            stack.push_back(M_resultClass(method->name, 1, int_id, int_id));
+        }
+        else if (IR_CallSymbolNode* call = dynamic_cast<IR_CallSymbolNode*>(it))
+        {
+            int argc = call->argc;
+            if ((int) stack.size() < argc + 1)
+                return false;
+
+            if (rewrite)
+            {
+                // The arguments lie below self, the first one deepest
+                std::vector<Class::Id> params = M_signature(call->target);
+                bool typed = (int) params.size() == argc + 1;
+                for (int i = 1; typed && i <= argc; ++i)
+                {
+                    Class::Id arg = stack[stack.size() - argc - 2 + i];
+                    typed = params[i] == Class::AnyId || params[i] == arg;
+                }
+
+                call->typed = typed;
+            }
+
+            stack.resize(stack.size() - argc - 1);
+            stack.push_back(Class::AnyId);
+        }
+        else if (IR_GotoIfTrueNode* jump = dynamic_cast<IR_GotoIfTrueNode*>(it))
+        {
+            if (stack.empty())
+                return false;
+            stack.pop_back();
+
+            if (!M_merge(jump->name, state))
+                return false;
+        }
+        else if (IR_GotoIfFalseNode* jump = dynamic_cast<IR_GotoIfFalseNode*>(it))
+        {
+            if (stack.empty())
+                return false;
+            stack.pop_back();
+
+            if (!M_merge(jump->name, state))
+                return false;
+        }
+        else if (IR_GotoNode* jump = dynamic_cast<IR_GotoNode*>(it))
+        {
+            if (!M_merge(jump->name, state))
+                return false;
+            state.reachable = false;
+        }
+        else if (dynamic_cast<IR_ReturnNode*>(it) || dynamic_cast<IR_LeaveNode*>(it))
+            state.reachable = false;
+        else if (!dynamic_cast<IR_LabelNode*>(it) &&
+                 !dynamic_cast<IR_ImportNode*>(it) && !dynamic_cast<IR_ImportMaskNode*>(it))
+        {
+            // Unknown effect on the stack, nothing can be trusted
+            return false;
+        }
+
+        it = next;
+    }
+
+    return true;
+}
+
+bool InferTypes::M_merge(std::string const& label, State const& state)
+{
+    auto it = m_labels.find(label);
+    if (it == m_labels.end())
+    {
+        m_labels[label] = state;
+        m_changed = true;
+        return true;
+    }
+
+    State& target = it->second;
+    if (target.stack.size() != state.stack.size() || target.locals.size() != state.locals.size())
+        return false;
+
+    for (std::size_t i = 0; i < target.stack.size(); ++i)
+    {
+        if (target.stack[i] != state.stack[i] && target.stack[i] != Class::AnyId)
+        {
+            target.stack[i] = Class::AnyId;
+            m_changed = true;
+        }
+    }
+
+    for (std::size_t i = 0; i < target.locals.size(); ++i)
+    {
+        if (target.locals[i] != state.locals[i] && target.locals[i] != Class::AnyId)
+        {
+            target.locals[i] = Class::AnyId;
+            m_changed = true;
+        }
+    }
+
+    return true;
+}
+
+std::vector<Class::Id> InferTypes::M_signature(IR_FunDeclNode* fun)
+{
+    std::vector<Class::Id> params;
+    for (auto it = fun->symtab()->begin(); it != fun->symtab()->end(); ++it)
+    {
+        if (it->which() == Symbol::Argument)
+            params.push_back(it->data().unwrap<Class::Id>());
+    }
+
+    return params;
+}
+
+Class::Id InferTypes::M_resultClass(std::string const& name, int argc, Class::Id self, Class::Id arg)
+{
+    Class::Id int_id = type_class<int>().classid();
+    Class::Id bool_id = type_class<bool>().classid();
+
+    if (argc == 0)
+    {
+        if (name == std_neg && self == int_id)
+            return int_id;
+        if (name == std_not && self == bool_id)
+            return bool_id;
+        return Class::AnyId;
+    }
+
+    if (argc != 1 || self != int_id || arg != int_id)
+        return Class::AnyId;
+
+    if (name == std_add || name == std_sub || name == std_mul ||
+        name == std_div || name == std_mod)
+        return int_id;
+
+    if (name == std_equals || name == std_nequals || name == std_lt ||
+        name == std_lte || name == std_gt || name == std_gte)
+        return bool_id;
+
+    return Class::AnyId;
+}
@@ -0,0 +1,249 @@
+#include "lang/pass/inline_methods.hpp"
+#include "lang/ast/node.hpp"
+#include "lang/ast/node_visitor.hpp"
+#include "lang/symtab.hpp"
+
+#include "lang/ast/ast.hpp"
+#include "lang/std_names.hpp"
+
+#include <string>
+
+using namespace lang;
+using namespace ast;
+using namespace pass;
+
+InlineMethods::~InlineMethods()
+{}
+
+void InlineMethods::visit(IR_ProgNode* node)
+{
+    if (M_optedOut(node))
+        return;
+
+    // Callees are chosen before anything is inlined, so that the
+    //   result does not depend on the order of the methods
+    for (Node* it = node->siblings()[0]; it; it = it->next())
+    {
+        if (!dynamic_cast<IR_ClassDeclNode*>(it))
+            continue;
+
+        for (Node* method = it->siblings()[0]; method; method = method->next())
+        {
+            IR_FunDeclNode* fun = dynamic_cast<IR_FunDeclNode*>(method);
+            if (fun && M_inlinable(fun))
+                m_inlinable.insert(fun);
+        }
+    }
+
+    node->siblings()[0]->accept(this);
+}
+
+void InlineMethods::visit(IR_ClassDeclNode* node)
+{
+    for (Node* method = node->siblings()[0]; method; method = method->next())
+    {
+        IR_FunDeclNode* fun = dynamic_cast<IR_FunDeclNode*>(method);
+        if (!fun)
+            continue;
+
+        for (Node* it = fun->siblings()[0]; it; )
+        {
+            Node* next = it->next();
+
+            IR_CallSymbolNode* call = dynamic_cast<IR_CallSymbolNode*>(it);
+            if (call && m_inlinable.count(call->target))
+                M_inline(fun, call);
+
+            it = next;
+        }
+    }
+
+    M_follow(node);
+}
+
+bool InlineMethods::M_optedOut(Node* node) const
+{
+    for (Node* it = node; it; it = it->next())
+    {
+        IR_StorGlobalNode* stor = dynamic_cast<IR_StorGlobalNode*>(it);
+        if (stor && stor->name == std_noinline)
+            return true;
+
+        for (auto sib : it->siblings())
+        {
+            if (M_optedOut(sib))
+                return true;
+        }
+    }
+
+    return false;
+}
+
+bool InlineMethods::M_inlinable(IR_FunDeclNode* fun) const
+{
+    std::set<int> stored;
+    std::size_t count = 0;
+
+    for (Node* it = fun->siblings()[0]; it; it = it->next())
+    {
+        if (!it->next())
+            return dynamic_cast<IR_ReturnNode*>(it) != nullptr;
+
+        if (++count > MAX_NODES)
+            return false;
+
+        // A fresh frame has nil locals, inlined locals keep their
+        //   previous value so they must be written first
+        if (IR_LoadLocalNode* load = dynamic_cast<IR_LoadLocalNode*>(it))
+        {
+            if (!stored.count(load->index))
+                return false;
+        }
+        else if (IR_StorLocalNode* stor = dynamic_cast<IR_StorLocalNode*>(it))
+            stored.insert(stor->index);
+        else if (!dynamic_cast<IR_LoadConstNode*>(it) && !dynamic_cast<IR_LoadGlobalNode*>(it) &&
+                 !dynamic_cast<IR_StorGlobalNode*>(it) && !dynamic_cast<IR_LoadMemberNode*>(it) &&
+                 !dynamic_cast<IR_StorMemberNode*>(it) && !dynamic_cast<IR_InvokeNode*>(it) &&
+                 !dynamic_cast<IR_MethodNode*>(it) && !dynamic_cast<IR_MethodIntNode*>(it) &&
+                 !dynamic_cast<IR_PopNode*>(it))
+            return false;
+    }
+
+    return false;
+}
+
+void InlineMethods::M_inline(IR_FunDeclNode* caller, IR_CallSymbolNode* call)
+{
+    IR_FunDeclNode* callee = call->target;
+    Token const& token = call->startToken();
+
+    // The arguments of the callee, then its locals, follow the
+    //   locals of the caller
+    Symtab* symtab = caller->symtab();
+    int base = 0;
+    for (auto it = symtab->begin(); it != symtab->end(); ++it)
+    {
+        if (it->which() != Symbol::Argument)
+            ++base;
+    }
+
+    int nargs = call->argc + 1;
+    int nlocals = (int) callee->symtab()->localsCount();
+    std::string prefix = "@inline" + std::to_string(m_count++);
+    for (int i = 0; i < nargs + nlocals; ++i)
+        symtab->add(Symbol(Symbol::Variable, Symbol::Local, prefix + "." + std::to_string(i)));
+
+    IR_GuardSymbolNode* guard = new IR_GuardSymbolNode(token);
+    guard->name = prefix + ".slow";
+    guard->target = callee;
+
+    // Self is on top of its arguments
+    for (int i = 0; i < nargs; ++i)
+    {
+        IR_StorLocalNode* stor = new IR_StorLocalNode(token);
+        stor->index = base + (i ? nargs - i : 0);
+        guard->chain(stor);
+    }
+
+    for (Node* it = callee->siblings()[0]; it->next(); it = it->next())
+        guard->chain(M_copy(it, base, base + nargs));
+
+    IR_GotoNode* leave = new IR_GotoNode(token);
+    leave->name = prefix + ".end";
+    guard->chain(leave);
+
+    IR_LabelNode* slow = new IR_LabelNode(token);
+    slow->name = guard->name;
+    guard->chain(slow);
+
+    IR_MethodNode* method = new IR_MethodNode(token);
+    method->name = call->name;
+    method->argc = call->argc;
+    guard->chain(method);
+
+    IR_LabelNode* end = new IR_LabelNode(token);
+    end->name = leave->name;
+    guard->chain(end);
+
+    call->exchangeWith(guard);
+    delete call;
+}
+
+Node* InlineMethods::M_copy(Node* node, int args_base, int locals_base)
+{
+    Token const& token = node->startToken();
+
+    if (IR_LoadConstNode* load = dynamic_cast<IR_LoadConstNode*>(node))
+    {
+        if (load->index >= 0)
+        {
+            IR_LoadConstNode* copy = new IR_LoadConstNode(token);
+            copy->index = load->index;
+            return copy;
+        }
+
+        IR_LoadLocalNode* copy = new IR_LoadLocalNode(token);
+        copy->index = args_base - load->index - 1;
+        return copy;
+    }
+    else if (IR_LoadLocalNode* load = dynamic_cast<IR_LoadLocalNode*>(node))
+    {
+        IR_LoadLocalNode* copy = new IR_LoadLocalNode(token);
+        copy->index = locals_base + load->index;
+        return copy;
+    }
+    else if (IR_StorLocalNode* stor = dynamic_cast<IR_StorLocalNode*>(node))
+    {
+        IR_StorLocalNode* copy = new IR_StorLocalNode(token);
+        copy->index = locals_base + stor->index;
+        return copy;
+    }
+    else if (IR_LoadGlobalNode* load = dynamic_cast<IR_LoadGlobalNode*>(node))
+    {
+        IR_LoadGlobalNode* copy = new IR_LoadGlobalNode(token);
+        copy->name = load->name;
+        return copy;
+    }
+    else if (IR_StorGlobalNode* stor = dynamic_cast<IR_StorGlobalNode*>(node))
+    {
+        IR_StorGlobalNode* copy = new IR_StorGlobalNode(token);
+        copy->name = stor->name;
+        return copy;
+    }
+    else if (IR_LoadMemberNode* load = dynamic_cast<IR_LoadMemberNode*>(node))
+    {
+        IR_LoadMemberNode* copy = new IR_LoadMemberNode(token);
+        copy->name = load->name;
+        return copy;
+    }
+    else if (IR_StorMemberNode* stor = dynamic_cast<IR_StorMemberNode*>(node))
+    {
+        IR_StorMemberNode* copy = new IR_StorMemberNode(token);
+        copy->name = stor->name;
+        return copy;
+    }
+    else if (IR_InvokeNode* invoke = dynamic_cast<IR_InvokeNode*>(node))
+    {
+        IR_InvokeNode* copy = new IR_InvokeNode(token);
+        copy->argc = invoke->argc;
+        return copy;
+    }
+    else if (IR_MethodNode* method = dynamic_cast<IR_MethodNode*>(node))
+    {
+        IR_MethodNode* copy = new IR_MethodNode(token);
+        copy->name = method->name;
+        copy->argc = method->argc;
+        return copy;
+    }
+    else if (IR_MethodIntNode* method = dynamic_cast<IR_MethodIntNode*>(node))
+    {
+        IR_MethodIntNode* copy = new IR_MethodIntNode(token);
+        copy->name = method->name;
+        return copy;
+    }
+    else if (dynamic_cast<IR_PopNode*>(node))
+        return new IR_PopNode(token);
+
+    M_error(node, "internal error: unexpected node in an inlined method");
+    return nullptr;
+}
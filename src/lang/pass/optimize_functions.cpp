@@ -0,0 +1,878 @@
+#include "lang/pass/optimize_functions.hpp"
+#include "lang/ast/node.hpp"
+#include "lang/ast/node_visitor.hpp"
+#include "lang/cfg/graph.hpp"
+#include "lang/symtab.hpp"
+#include "core/type_registry.hpp"
+
+#include "lang/ast/ast.hpp"
+#include "lang/std_names.hpp"
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <string>
+#include <tuple>
+
+using namespace lang;
+using namespace ast;
+using namespace pass;
+using namespace cfg;
+using namespace core;
+
+namespace
+{
+    //! Value on the operand stack while a block is simulated
+    struct StackValue
+    {
+        //! Only pure values are computed by a known range of nodes
+        bool pure;
+        std::size_t start;
+        std::size_t end;
+        //! Whether the value is the same on every iteration of a loop
+        bool invariant;
+        //! Value number, -1 if unknown
+        int number;
+    };
+
+    StackValue impure()
+    { return StackValue { false, 0, 0, false, -1 }; }
+
+    StackValue pure(std::size_t index, bool invariant, int number)
+    { return StackValue { true, index, index + 1, invariant, number }; }
+
+    StackValue pop(std::vector<StackValue>& stack)
+    {
+        // The values pushed by the previous blocks are unknown
+        if (stack.empty())
+            return impure();
+
+        StackValue value = stack.back();
+        stack.pop_back();
+        return value;
+    }
+
+    //! Result of the integer operation at `index', `top' is self
+    StackValue combine(StackValue const& below, StackValue const& top, std::size_t index)
+    {
+        StackValue value = impure();
+        value.pure = below.pure && top.pure && below.end == top.start && top.end == index;
+        value.start = below.start;
+        value.end = index + 1;
+        value.invariant = value.pure && below.invariant && top.invariant;
+        return value;
+    }
+
+    //! Number of local slots used by a function
+    std::size_t locals_count(Graph const& graph)
+    {
+        std::size_t count = graph.function()->symtab()->localsCount();
+        for (auto const& block : graph.blocks())
+        {
+            for (auto node : block.nodes)
+            {
+                if (IR_LoadLocalNode* load = dynamic_cast<IR_LoadLocalNode*>(node))
+                    count = std::max(count, (std::size_t) load->index + 1);
+                else if (IR_StorLocalNode* stor = dynamic_cast<IR_StorLocalNode*>(node))
+                    count = std::max(count, (std::size_t) stor->index + 1);
+            }
+        }
+
+        return count;
+    }
+}
+
+OptimizeFunctions::~OptimizeFunctions()
+{}
+
+void OptimizeFunctions::visit(IR_ProgNode* node)
+{
+    // Same order as the constants table of the blob
+    Symtab* top = node->symtab()->top();
+    for (auto it = top->begin(); it != top->end(); ++it)
+    {
+        if (it->which() == Symbol::Const)
+            m_constants.push_back(it->data().classid());
+    }
+
+    node->siblings()[0]->accept(this);
+}
+
+void OptimizeFunctions::visit(IR_ClassDeclNode* node)
+{
+    node->siblings()[0]->accept(this);
+    M_follow(node);
+}
+
+void OptimizeFunctions::visit(IR_FunDeclNode* node)
+{
+    {
+        Graph graph(node);
+
+        graph.removeUnreachable();
+        M_hoistInvariants(graph);
+        M_numberValues(graph);
+        M_propagateCopies(graph);
+        while (M_removeDeadStores(graph))
+            ;
+        M_allocateLocals(graph);
+
+        graph.lower();
+    }
+
+    M_follow(node);
+}
+
+void OptimizeFunctions::M_hoistInvariants(Graph& graph)
+{
+    std::vector<Block>& blocks = graph.blocks();
+    std::vector<std::vector<bool>> dom = graph.dominators();
+
+    // Natural loops by header, an edge to a dominator closes a loop
+    std::map<std::size_t, std::set<std::size_t>> loops;
+    for (std::size_t b = 0; b < blocks.size(); ++b)
+    {
+        for (auto header : blocks[b].succs)
+        {
+            if (!dom[b][header])
+                continue;
+
+            std::set<std::size_t>& body = loops[header];
+            body.insert(header);
+
+            std::vector<std::size_t> work(1, b);
+            while (!work.empty())
+            {
+                std::size_t it = work.back();
+                work.pop_back();
+
+                if (body.insert(it).second)
+                    work.insert(work.end(), blocks[it].preds.begin(), blocks[it].preds.end());
+            }
+        }
+    }
+
+    // Outer loops come first, what they hoist leaves the inner ones
+    for (auto const& loop : loops)
+    {
+        std::size_t header = loop.first;
+        std::set<std::size_t> const& body = loop.second;
+
+        // The code is hoisted at the end of the block falling into the
+        //   loop, which must be the only way in
+        std::vector<std::size_t> entries;
+        for (auto pred : blocks[header].preds)
+        {
+            if (!body.count(pred))
+                entries.push_back(pred);
+        }
+
+        if (entries.size() != 1 || entries[0] + 1 != header)
+            continue;
+
+        Block& pre = blocks[entries[0]];
+        if (pre.nodes.empty() || Graph::jumpTarget(pre.nodes.back()) || Graph::endsFlow(pre.nodes.back()))
+            continue;
+
+        std::set<int> stored;
+        for (auto b : body)
+        {
+            for (auto node : blocks[b].nodes)
+            {
+                if (IR_StorLocalNode* stor = dynamic_cast<IR_StorLocalNode*>(node))
+                    stored.insert(stor->index);
+            }
+        }
+
+        for (auto b : body)
+        {
+            std::vector<Node*>& nodes = blocks[b].nodes;
+            std::vector<StackValue> stack;
+            std::vector<Range> ranges;
+
+            for (std::size_t i = 0; i < nodes.size(); ++i)
+            {
+                Node* node = nodes[i];
+
+                if (dynamic_cast<IR_LoadConstNode*>(node))
+                    stack.push_back(pure(i, true, -1));
+                else if (IR_LoadLocalNode* load = dynamic_cast<IR_LoadLocalNode*>(node))
+                    stack.push_back(pure(i, !stored.count(load->index), -1));
+                else if (IR_MethodIntNode* method = dynamic_cast<IR_MethodIntNode*>(node))
+                {
+                    StackValue top = pop(stack);
+                    StackValue value = combine(pop(stack), top, i);
+
+                    // A division by zero must not be raised before the loop
+                    value.invariant = value.invariant && method->name != std_div && method->name != std_mod;
+                    if (value.invariant)
+                        ranges.push_back(Range { value.start, value.end, -1 });
+
+                    stack.push_back(value);
+                }
+                else
+                {
+                    int pops, pushes;
+                    if (!Graph::stackEffect(node, pops, pushes))
+                        break;
+
+                    while (pops-- > 0)
+                        pop(stack);
+                    while (pushes-- > 0)
+                        stack.push_back(impure());
+                }
+            }
+
+            ranges = M_outermost(ranges);
+            for (auto& range : ranges)
+            {
+                range.local = M_newLocal(graph.function());
+
+                for (std::size_t i = range.start; i < range.end; ++i)
+                    pre.nodes.push_back(M_copy(nodes[i]));
+
+                IR_StorLocalNode* stor = new IR_StorLocalNode(nodes[range.end - 1]->startToken());
+                stor->index = range.local;
+                pre.nodes.push_back(stor);
+            }
+
+            M_replaceRanges(graph, b, ranges);
+        }
+    }
+}
+
+void OptimizeFunctions::M_numberValues(Graph& graph)
+{
+    std::vector<Block>& blocks = graph.blocks();
+
+    // Operations by value numbers of their operands, constants and
+    //   arguments by index (the name is empty)
+    std::map<std::tuple<std::string, int, int>, int> numbers;
+    int count = 0;
+
+    auto number = [&](std::string const& name, int lhs, int rhs)
+    {
+        auto key = std::make_tuple(name, lhs, rhs);
+        auto it = numbers.find(key);
+        if (it == numbers.end())
+            it = numbers.insert(std::make_pair(key, count++)).first;
+        return it->second;
+    };
+
+    // Value number held by each local at the end of the blocks, a block
+    //   with a single predecessor starts from the end of it
+    std::vector<std::map<int, int>> exits(blocks.size());
+    std::vector<bool> done(blocks.size(), false);
+
+    for (auto b : graph.reversePostOrder())
+    {
+        std::map<int, int> locals;
+        if (blocks[b].preds.size() == 1 && done[blocks[b].preds[0]])
+            locals = exits[blocks[b].preds[0]];
+
+        std::vector<Node*>& nodes = blocks[b].nodes;
+        std::vector<StackValue> stack;
+        std::vector<Range> ranges;
+
+        for (std::size_t i = 0; i < nodes.size(); ++i)
+        {
+            Node* node = nodes[i];
+
+            if (IR_LoadConstNode* load = dynamic_cast<IR_LoadConstNode*>(node))
+                stack.push_back(pure(i, false, number("", load->index, 0)));
+            else if (IR_LoadLocalNode* load = dynamic_cast<IR_LoadLocalNode*>(node))
+            {
+                auto it = locals.find(load->index);
+                if (it == locals.end())
+                    it = locals.insert(std::make_pair(load->index, count++)).first;
+                stack.push_back(pure(i, false, it->second));
+            }
+            else if (IR_StorLocalNode* stor = dynamic_cast<IR_StorLocalNode*>(node))
+            {
+                StackValue value = pop(stack);
+                locals[stor->index] = value.number >= 0 ? value.number : count++;
+            }
+            else if (IR_MethodIntNode* method = dynamic_cast<IR_MethodIntNode*>(node))
+            {
+                StackValue top = pop(stack);
+                StackValue below = pop(stack);
+                StackValue value = combine(below, top, i);
+
+                if (below.number >= 0 && top.number >= 0)
+                    value.number = number(method->name, below.number, top.number);
+                else
+                    value.number = count++;
+
+                if (value.pure)
+                {
+                    for (auto const& held : locals)
+                    {
+                        if (held.second == value.number)
+                        {
+                            ranges.push_back(Range { value.start, value.end, held.first });
+                            break;
+                        }
+                    }
+                }
+
+                stack.push_back(value);
+            }
+            else
+            {
+                int pops, pushes;
+                if (!Graph::stackEffect(node, pops, pushes))
+                {
+                    locals.clear();
+                    break;
+                }
+
+                while (pops-- > 0)
+                    pop(stack);
+                while (pushes-- > 0)
+                    stack.push_back(impure());
+            }
+        }
+
+        exits[b] = locals;
+        done[b] = true;
+
+        M_replaceRanges(graph, b, M_outermost(ranges));
+    }
+}
+
+void OptimizeFunctions::M_propagateCopies(Graph& graph)
+{
+    std::vector<Block>& blocks = graph.blocks();
+
+    // Source of the copy held by a local: a constant (or an argument)
+    //   or another local
+    typedef std::map<int, std::pair<bool, int>> Copies;
+
+    auto transfer = [&](std::size_t b, Copies copies, bool rewrite)
+    {
+        std::vector<Node*>& nodes = blocks[b].nodes;
+        for (std::size_t i = 0; i < nodes.size(); ++i)
+        {
+            if (IR_LoadLocalNode* load = dynamic_cast<IR_LoadLocalNode*>(nodes[i]))
+            {
+                auto it = copies.find(load->index);
+                if (!rewrite || it == copies.end())
+                    continue;
+
+                if (it->second.first)
+                {
+                    IR_LoadConstNode* source = new IR_LoadConstNode(load->startToken());
+                    source->index = it->second.second;
+                    graph.replace(b, i, source);
+                }
+                else
+                {
+                    IR_LoadLocalNode* source = new IR_LoadLocalNode(load->startToken());
+                    source->index = it->second.second;
+                    graph.replace(b, i, source);
+                }
+            }
+            else if (IR_StorLocalNode* stor = dynamic_cast<IR_StorLocalNode*>(nodes[i]))
+            {
+                int local = stor->index;
+                for (auto it = copies.begin(); it != copies.end(); )
+                {
+                    if (it->first == local || (!it->second.first && it->second.second == local))
+                        it = copies.erase(it);
+                    else
+                        ++it;
+                }
+
+                Node* prev = i ? nodes[i - 1] : nullptr;
+                if (IR_LoadLocalNode* load = dynamic_cast<IR_LoadLocalNode*>(prev))
+                {
+                    if (load->index == local)
+                        continue;
+
+                    auto source = copies.find(load->index);
+                    copies[local] = source != copies.end() ? source->second : std::make_pair(false, load->index);
+                }
+                else if (IR_LoadConstNode* load = dynamic_cast<IR_LoadConstNode*>(prev))
+                {
+                    if (M_isImmutable(load->index))
+                        copies[local] = std::make_pair(true, load->index);
+                }
+            }
+        }
+
+        return copies;
+    };
+
+    // The copies available on entry of a block are the ones available
+    //   at the end of all its predecessors, the entry starts with none
+    std::vector<Copies> out(blocks.size());
+    std::vector<bool> known(blocks.size(), false);
+
+    auto in = [&](std::size_t b)
+    {
+        Copies copies;
+        if (!b)
+            return copies;
+
+        bool first = true;
+        for (auto pred : blocks[b].preds)
+        {
+            if (!known[pred])
+                continue;
+
+            if (first)
+                copies = out[pred];
+            else
+            {
+                for (auto it = copies.begin(); it != copies.end(); )
+                {
+                    auto other = out[pred].find(it->first);
+                    if (other == out[pred].end() || other->second != it->second)
+                        it = copies.erase(it);
+                    else
+                        ++it;
+                }
+            }
+            first = false;
+        }
+
+        return copies;
+    };
+
+    std::vector<std::size_t> order = graph.reversePostOrder();
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        for (auto b : order)
+        {
+            Copies copies = transfer(b, in(b), false);
+            if (!known[b] || copies != out[b])
+            {
+                out[b] = copies;
+                known[b] = true;
+                changed = true;
+            }
+        }
+    }
+
+    for (auto b : order)
+        transfer(b, in(b), true);
+}
+
+bool OptimizeFunctions::M_removeDeadStores(Graph& graph)
+{
+    std::vector<Block>& blocks = graph.blocks();
+    std::size_t nlocals = locals_count(graph);
+    std::vector<LocalSet> live_out = M_liveOut(graph, nlocals);
+
+    bool changed = false;
+    for (std::size_t b = 0; b < blocks.size(); ++b)
+    {
+        LocalSet live = live_out[b];
+        std::vector<Node*>& nodes = blocks[b].nodes;
+
+        for (std::size_t i = nodes.size(); i-- > 0; )
+        {
+            if (IR_LoadLocalNode* load = dynamic_cast<IR_LoadLocalNode*>(nodes[i]))
+                live[load->index] = true;
+            else if (IR_StorLocalNode* stor = dynamic_cast<IR_StorLocalNode*>(nodes[i]))
+            {
+                if (live[stor->index])
+                {
+                    live[stor->index] = false;
+                    continue;
+                }
+
+                // The value is dropped, and so is its load if it has no effect
+                Node* prev = i ? nodes[i - 1] : nullptr;
+                if (dynamic_cast<IR_LoadLocalNode*>(prev) || dynamic_cast<IR_LoadConstNode*>(prev))
+                {
+                    graph.erase(prev);
+                    graph.erase(stor);
+                    nodes.erase(nodes.begin() + i - 1, nodes.begin() + i + 1);
+                    --i;
+                }
+                else
+                    graph.replace(b, i, new IR_PopNode(stor->startToken()));
+
+                changed = true;
+            }
+        }
+    }
+
+    return changed;
+}
+
+void OptimizeFunctions::M_allocateLocals(Graph& graph)
+{
+    std::vector<Block>& blocks = graph.blocks();
+    std::size_t nlocals = locals_count(graph);
+    if (!nlocals)
+        return;
+
+    // Definitions: the stores, then the nil value of each local on entry
+    std::vector<IR_StorLocalNode*> stores;
+    std::map<Node*, std::size_t> def_of;
+    for (auto const& block : blocks)
+    {
+        for (auto node : block.nodes)
+        {
+            if (IR_StorLocalNode* stor = dynamic_cast<IR_StorLocalNode*>(node))
+            {
+                def_of[node] = stores.size();
+                stores.push_back(stor);
+            }
+        }
+    }
+
+    std::size_t ndefs = stores.size() + nlocals;
+    std::vector<std::vector<std::size_t>> local_defs(nlocals);
+    for (std::size_t d = 0; d < stores.size(); ++d)
+        local_defs[stores[d]->index].push_back(d);
+    for (std::size_t l = 0; l < nlocals; ++l)
+        local_defs[l].push_back(stores.size() + l);
+
+    auto define = [&](Node* node, std::vector<bool>& reach)
+    {
+        if (IR_StorLocalNode* stor = dynamic_cast<IR_StorLocalNode*>(node))
+        {
+            for (auto d : local_defs[stor->index])
+                reach[d] = false;
+            reach[def_of[node]] = true;
+        }
+    };
+
+    // Reaching definitions
+    std::vector<std::size_t> order = graph.reversePostOrder();
+    std::vector<std::vector<bool>> reach_in(blocks.size(), std::vector<bool>(ndefs, false));
+    std::vector<std::vector<bool>> reach_out = reach_in;
+
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        for (auto b : order)
+        {
+            std::vector<bool> reach(ndefs, false);
+            if (!b)
+                std::fill(reach.begin() + stores.size(), reach.end(), true);
+            for (auto pred : blocks[b].preds)
+            {
+                for (std::size_t d = 0; d < ndefs; ++d)
+                    reach[d] = reach[d] || reach_out[pred][d];
+            }
+            reach_in[b] = reach;
+
+            for (auto node : blocks[b].nodes)
+                define(node, reach);
+
+            if (reach != reach_out[b])
+            {
+                reach_out[b] = reach;
+                changed = true;
+            }
+        }
+    }
+
+    // Definitions reaching a common load belong to the same web
+    std::vector<std::size_t> parent(ndefs);
+    for (std::size_t d = 0; d < ndefs; ++d)
+        parent[d] = d;
+
+    auto find = [&](std::size_t d)
+    {
+        while (parent[d] != d)
+            d = parent[d] = parent[parent[d]];
+        return d;
+    };
+
+    std::map<Node*, std::size_t> use_def;
+    for (auto b : order)
+    {
+        std::vector<bool> reach = reach_in[b];
+        for (auto node : blocks[b].nodes)
+        {
+            if (IR_LoadLocalNode* load = dynamic_cast<IR_LoadLocalNode*>(node))
+            {
+                std::size_t first = stores.size() + load->index;
+                bool found = false;
+                for (auto d : local_defs[load->index])
+                {
+                    if (!reach[d])
+                        continue;
+
+                    if (!found)
+                        first = d;
+                    else
+                        parent[find(d)] = find(first);
+                    found = true;
+                }
+
+                use_def[node] = first;
+            }
+
+            define(node, reach);
+        }
+    }
+
+    std::vector<std::size_t> web_of(ndefs);
+    std::map<std::size_t, std::size_t> roots;
+    for (std::size_t d = 0; d < ndefs; ++d)
+    {
+        auto it = roots.insert(std::make_pair(find(d), roots.size())).first;
+        web_of[d] = it->second;
+    }
+    std::size_t nwebs = roots.size();
+
+    auto web = [&](Node* node) -> std::size_t
+    {
+        if (dynamic_cast<IR_StorLocalNode*>(node))
+            return web_of[def_of[node]];
+        return web_of[use_def[node]];
+    };
+
+    auto is_local = [](Node* node)
+    { return dynamic_cast<IR_LoadLocalNode*>(node) || dynamic_cast<IR_StorLocalNode*>(node); };
+
+    // Liveness of the webs, then the webs live when another is stored
+    std::vector<std::vector<bool>> live_in(blocks.size(), std::vector<bool>(nwebs, false));
+    std::vector<std::vector<bool>> live_out = live_in;
+
+    changed = true;
+    while (changed)
+    {
+        changed = false;
+        for (auto it = order.rbegin(); it != order.rend(); ++it)
+        {
+            std::vector<bool> live(nwebs, false);
+            for (auto succ : blocks[*it].succs)
+            {
+                for (std::size_t w = 0; w < nwebs; ++w)
+                    live[w] = live[w] || live_in[succ][w];
+            }
+            live_out[*it] = live;
+
+            std::vector<Node*> const& nodes = blocks[*it].nodes;
+            for (auto node = nodes.rbegin(); node != nodes.rend(); ++node)
+            {
+                if (is_local(*node))
+                    live[web(*node)] = dynamic_cast<IR_LoadLocalNode*>(*node) != nullptr;
+            }
+
+            if (live != live_in[*it])
+            {
+                live_in[*it] = live;
+                changed = true;
+            }
+        }
+    }
+
+    std::vector<std::set<std::size_t>> interferes(nwebs);
+    auto interfere = [&](std::size_t w, std::vector<bool> const& live)
+    {
+        for (std::size_t v = 0; v < nwebs; ++v)
+        {
+            if (live[v] && v != w)
+            {
+                interferes[w].insert(v);
+                interferes[v].insert(w);
+            }
+        }
+    };
+
+    for (auto b : order)
+    {
+        std::vector<bool> live = live_out[b];
+        std::vector<Node*> const& nodes = blocks[b].nodes;
+        for (auto node = nodes.rbegin(); node != nodes.rend(); ++node)
+        {
+            if (!is_local(*node))
+                continue;
+
+            std::size_t w = web(*node);
+            if (dynamic_cast<IR_StorLocalNode*>(*node))
+            {
+                interfere(w, live);
+                live[w] = false;
+            }
+            else
+                live[w] = true;
+        }
+    }
+
+    // The webs live on entry hold the nil value of their slot
+    for (std::size_t w = 0; w < nwebs; ++w)
+    {
+        if (!order.empty() && live_in[0][w])
+            interfere(w, live_in[0]);
+    }
+
+    // Webs get the first slot free of the ones they interfere with,
+    //   in order of appearance
+    std::vector<int> color(nwebs, -1);
+    int ncolors = 0;
+    for (auto const& block : blocks)
+    {
+        for (auto node : block.nodes)
+        {
+            if (!is_local(node) || color[web(node)] >= 0)
+                continue;
+
+            std::size_t w = web(node);
+            std::vector<bool> used(ncolors + 1, false);
+            for (auto v : interferes[w])
+            {
+                if (color[v] >= 0)
+                    used[color[v]] = true;
+            }
+
+            int c = 0;
+            while (used[c])
+                ++c;
+
+            color[w] = c;
+            ncolors = std::max(ncolors, c + 1);
+        }
+    }
+
+    if ((std::size_t) ncolors > nlocals)
+        return;
+
+    for (auto const& block : blocks)
+    {
+        for (auto node : block.nodes)
+        {
+            if (IR_LoadLocalNode* load = dynamic_cast<IR_LoadLocalNode*>(node))
+                load->index = color[web(node)];
+            else if (IR_StorLocalNode* stor = dynamic_cast<IR_StorLocalNode*>(node))
+                stor->index = color[web(node)];
+        }
+    }
+
+    graph.function()->symtab()->truncateLocals(ncolors);
+}
+
+std::vector<OptimizeFunctions::Range> OptimizeFunctions::M_outermost(std::vector<Range> const& ranges) const
+{
+    std::vector<Range> result;
+    for (auto it = ranges.rbegin(); it != ranges.rend(); ++it)
+    {
+        if (!result.empty() && result.back().start <= it->start && it->end <= result.back().end)
+            continue;
+        result.push_back(*it);
+    }
+
+    std::reverse(result.begin(), result.end());
+    return result;
+}
+
+void OptimizeFunctions::M_replaceRanges(Graph& graph, std::size_t block, std::vector<Range> const& ranges)
+{
+    std::vector<Node*>& nodes = graph.blocks()[block].nodes;
+    std::vector<Node*> result;
+
+    std::size_t next = 0;
+    for (auto const& range : ranges)
+    {
+        result.insert(result.end(), nodes.begin() + next, nodes.begin() + range.start);
+
+        IR_LoadLocalNode* load = new IR_LoadLocalNode(nodes[range.end - 1]->startToken());
+        load->index = range.local;
+        result.push_back(load);
+
+        for (std::size_t i = range.start; i < range.end; ++i)
+            graph.erase(nodes[i]);
+        next = range.end;
+    }
+
+    result.insert(result.end(), nodes.begin() + next, nodes.end());
+    nodes.swap(result);
+}
+
+std::vector<OptimizeFunctions::LocalSet> OptimizeFunctions::M_liveOut(Graph const& graph, std::size_t nlocals) const
+{
+    std::vector<Block> const& blocks = graph.blocks();
+    std::vector<LocalSet> live_in(blocks.size(), LocalSet(nlocals, false));
+    std::vector<LocalSet> live_out = live_in;
+
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        for (std::size_t b = blocks.size(); b-- > 0; )
+        {
+            LocalSet live(nlocals, false);
+            for (auto succ : blocks[b].succs)
+            {
+                for (std::size_t l = 0; l < nlocals; ++l)
+                    live[l] = live[l] || live_in[succ][l];
+            }
+            live_out[b] = live;
+
+            for (auto node = blocks[b].nodes.rbegin(); node != blocks[b].nodes.rend(); ++node)
+            {
+                if (IR_LoadLocalNode* load = dynamic_cast<IR_LoadLocalNode*>(*node))
+                    live[load->index] = true;
+                else if (IR_StorLocalNode* stor = dynamic_cast<IR_StorLocalNode*>(*node))
+                    live[stor->index] = false;
+            }
+
+            if (live != live_in[b])
+            {
+                live_in[b] = live;
+                changed = true;
+            }
+        }
+    }
+
+    return live_out;
+}
+
+int OptimizeFunctions::M_newLocal(IR_FunDeclNode* fun)
+{
+    Symtab* symtab = fun->symtab();
+    int index = (int) symtab->localsCount();
+    symtab->add(Symbol(Symbol::Variable, Symbol::Local, "@licm" + std::to_string(m_count++)));
+    return index;
+}
+
+bool OptimizeFunctions::M_isImmutable(int const_index) const
+{
+    // Arguments are never stored to
+    if (const_index < 0)
+        return true;
+
+    if ((std::size_t) const_index >= m_constants.size())
+        return false;
+
+    Class::Id classid = m_constants[const_index];
+    return classid == type_class<int>().classid() || classid == type_class<float>().classid() ||
+           classid == type_class<bool>().classid();
+}
+
+Node* OptimizeFunctions::M_copy(Node* node)
+{
+    Token const& token = node->startToken();
+
+    if (IR_LoadConstNode* load = dynamic_cast<IR_LoadConstNode*>(node))
+    {
+        IR_LoadConstNode* copy = new IR_LoadConstNode(token);
+        copy->index = load->index;
+        return copy;
+    }
+    else if (IR_LoadLocalNode* load = dynamic_cast<IR_LoadLocalNode*>(node))
+    {
+        IR_LoadLocalNode* copy = new IR_LoadLocalNode(token);
+        copy->index = load->index;
+        return copy;
+    }
+    else if (IR_MethodIntNode* method = dynamic_cast<IR_MethodIntNode*>(node))
+    {
+        IR_MethodIntNode* copy = new IR_MethodIntNode(token);
+        copy->name = method->name;
+        return copy;
+    }
+
+    return nullptr;
+}
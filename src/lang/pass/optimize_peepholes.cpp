@@ -0,0 +1,248 @@
+#include "lang/pass/optimize_peepholes.hpp"
+#include "lang/ast/node.hpp"
+#include "lang/ast/node_visitor.hpp"
+#include "lang/cfg/graph.hpp"
+
+#include "lang/ast/ast.hpp"
+
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace lang;
+using namespace ast;
+using namespace pass;
+using namespace cfg;
+
+namespace
+{
+    //! Target of the jumps which may be threaded, guards always branch
+    //!   to a dynamic call so they are left alone
+    std::string* jump_name(Node* node)
+    {
+        if (IR_GotoNode* jump = dynamic_cast<IR_GotoNode*>(node))
+            return &jump->name;
+        if (IR_GotoIfTrueNode* jump = dynamic_cast<IR_GotoIfTrueNode*>(node))
+            return &jump->name;
+        if (IR_GotoIfFalseNode* jump = dynamic_cast<IR_GotoIfFalseNode*>(node))
+            return &jump->name;
+
+        return nullptr;
+    }
+
+    std::size_t count_instructions(Graph const& graph)
+    {
+        std::size_t count = 0;
+        for (auto const& block : graph.blocks())
+        {
+            for (auto node : block.nodes)
+            {
+                if (!dynamic_cast<IR_LabelNode*>(node))
+                    ++count;
+            }
+        }
+
+        return count;
+    }
+}
+
+OptimizePeepholes::~OptimizePeepholes()
+{}
+
+void OptimizePeepholes::visit(IR_FunDeclNode* node)
+{
+    {
+        Graph graph(node);
+
+        // A label only ever starts a block
+        m_labels.clear();
+        std::vector<Block> const& blocks = graph.blocks();
+        for (std::size_t b = 0; b < blocks.size(); ++b)
+        {
+            if (IR_LabelNode* label = dynamic_cast<IR_LabelNode*>(blocks[b].nodes[0]))
+                m_labels[label->name] = b;
+        }
+
+        // Removing blocks brings jumps next to their target, and
+        //   threading leaves blocks nothing jumps to
+        bool changed = true;
+        while (changed)
+        {
+            changed = M_threadJumps(graph);
+            graph.link();
+
+            std::size_t count = count_instructions(graph);
+            if (graph.removeUnreachable())
+            {
+                m_hits[UNREACHABLE] += count - count_instructions(graph);
+                changed = true;
+            }
+        }
+
+        std::map<int, std::size_t> loads;
+        for (auto const& block : blocks)
+        {
+            for (auto it : block.nodes)
+            {
+                if (IR_LoadLocalNode* load = dynamic_cast<IR_LoadLocalNode*>(it))
+                    ++loads[load->index];
+            }
+        }
+
+        for (std::size_t b = 0; b < blocks.size(); ++b)
+            M_rewriteBlock(graph, b, loads);
+    }
+
+    M_follow(node);
+}
+
+std::size_t OptimizePeepholes::hits(Rule rule) const
+{ return m_hits[rule]; }
+
+char const* OptimizePeepholes::ruleName(Rule rule)
+{
+    static char const* names[RULES_COUNT] = {
+        "thread_jump",
+        "jump_to_exit",
+        "jump_to_next",
+        "unreachable",
+        "pop_load",
+        "store_load"
+    };
+
+    return names[rule];
+}
+
+bool OptimizePeepholes::M_threadJumps(Graph& graph)
+{
+    std::vector<Block>& blocks = graph.blocks();
+    bool changed = false;
+
+    for (std::size_t b = 0; b < blocks.size(); ++b)
+    {
+        if (blocks[b].nodes.empty())
+            continue;
+
+        Node* jump = blocks[b].nodes.back();
+        std::string* name = jump_name(jump);
+        if (!name)
+            continue;
+
+        // Follow the chain of jumps, up to a loop of them
+        std::set<std::string> seen;
+        seen.insert(*name);
+
+        Node* dest = M_destination(graph, *name);
+        while (IR_GotoNode* next = dynamic_cast<IR_GotoNode*>(dest))
+        {
+            if (!seen.insert(next->name).second)
+                break;
+
+            *name = next->name;
+            dest = M_destination(graph, *name);
+            ++m_hits[THREAD_JUMP];
+            changed = true;
+        }
+
+        std::size_t index = blocks[b].nodes.size() - 1;
+        if (M_fallsInto(graph, b, *name))
+        {
+            if (dynamic_cast<IR_GotoNode*>(jump))
+            {
+                graph.erase(jump);
+                blocks[b].nodes.pop_back();
+            }
+            else
+                graph.replace(b, index, new IR_PopNode(jump->startToken()));
+
+            ++m_hits[JUMP_TO_NEXT];
+            changed = true;
+        }
+        else if (dynamic_cast<IR_GotoNode*>(jump))
+        {
+            // The stack is the same at the jump and at its target
+            if (dynamic_cast<IR_ReturnNode*>(dest))
+                graph.replace(b, index, new IR_ReturnNode(jump->startToken()));
+            else if (dynamic_cast<IR_LeaveNode*>(dest))
+                graph.replace(b, index, new IR_LeaveNode(jump->startToken()));
+            else
+                continue;
+
+            ++m_hits[JUMP_TO_EXIT];
+            changed = true;
+        }
+    }
+
+    return changed;
+}
+
+void OptimizePeepholes::M_rewriteBlock(Graph& graph, std::size_t block, std::map<int, std::size_t> const& loads)
+{
+    std::vector<Node*>& nodes = graph.blocks()[block].nodes;
+    std::vector<Node*> result;
+
+    for (auto node : nodes)
+    {
+        Node* prev = result.empty() ? nullptr : result.back();
+
+        bool pop_load = dynamic_cast<IR_PopNode*>(node) &&
+            (dynamic_cast<IR_LoadConstNode*>(prev) || dynamic_cast<IR_LoadLocalNode*>(prev));
+
+        // The value is not thawed by the store anymore, it would have
+        //   been anyway by anything which may mutate it
+        IR_StorLocalNode* stor = dynamic_cast<IR_StorLocalNode*>(prev);
+        IR_LoadLocalNode* load = dynamic_cast<IR_LoadLocalNode*>(node);
+        bool store_load = stor && load && stor->index == load->index && loads.at(load->index) == 1;
+
+        if (pop_load || store_load)
+        {
+            graph.erase(prev);
+            graph.erase(node);
+            result.pop_back();
+
+            ++m_hits[pop_load ? POP_LOAD : STORE_LOAD];
+            continue;
+        }
+
+        result.push_back(node);
+    }
+
+    nodes.swap(result);
+}
+
+Node* OptimizePeepholes::M_destination(Graph const& graph, std::string const& label) const
+{
+    auto it = m_labels.find(label);
+    if (it == m_labels.end())
+        return nullptr;
+
+    std::vector<Block> const& blocks = graph.blocks();
+    for (std::size_t b = it->second; b < blocks.size(); ++b)
+    {
+        for (auto node : blocks[b].nodes)
+        {
+            if (!dynamic_cast<IR_LabelNode*>(node))
+                return node;
+        }
+    }
+
+    return nullptr;
+}
+
+bool OptimizePeepholes::M_fallsInto(Graph const& graph, std::size_t block, std::string const& label) const
+{
+    std::vector<Block> const& blocks = graph.blocks();
+    for (std::size_t b = block + 1; b < blocks.size(); ++b)
+    {
+        for (auto node : blocks[b].nodes)
+        {
+            IR_LabelNode* it = dynamic_cast<IR_LabelNode*>(node);
+            if (!it)
+                return false;
+            if (it->name == label)
+                return true;
+        }
+    }
+
+    return false;
+}
@@ -440,6 +440,30 @@ void PrettyPrint::visit(IR_MethodNode* node)
     M_follow(node);
 }
 
+void PrettyPrint::visit(IR_MethodIntNode* node)
+{
+    M_indent();
+    m_os << "(IR_MethodInt: " << node->name << ")";
+
+    M_follow(node);
+}
+
+void PrettyPrint::visit(IR_CallSymbolNode* node)
+{
+    M_indent();
+    m_os << "(IR_CallSymbol: " << node->name << ", " << node->argc << (node->typed ? ", typed" : "") << ")";
+
+    M_follow(node);
+}
+
+void PrettyPrint::visit(IR_GuardSymbolNode* node)
+{
+    M_indent();
+    m_os << "(IR_GuardSymbol: " << node->target->name << ", " << node->name << ")";
+
+    M_follow(node);
+}
+
 void PrettyPrint::visit(IR_ReturnNode* node)
 {
     M_indent();
@@ -87,6 +87,19 @@ std::size_t Symtab::argumentsCount() const
     return count;
 }
 
+void Symtab::truncateLocals(std::size_t count)
+{
+    std::size_t index = 0;
+    for (auto it = m_symbols.begin(); it != m_symbols.end(); )
+    {
+        if (it->binding() == Symbol::Local &&
+            it->which() != Symbol::Argument && index++ >= count)
+            it = m_symbols.erase(it);
+        else
+            ++it;
+    }
+}
+
 Symtab::const_iterator Symtab::M_find(std::string const& name, FindResult* res) const
 {
     std::size_t index = 0;
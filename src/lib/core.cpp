@@ -56,14 +56,17 @@ void Core::record()
         return Callable(std::function<Object(std::vector<Object>)>(wrapper), true);
     };
 
+    // The callbacks may mutate the list, these iterate over their own copy
     this_module.global("map") = [](std::vector<Object> list, Object function)
     {
-        for (auto it = list.begin(); it != list.end(); ++it)
-            *it = function(*it);
-        return list;
+        std::vector<Object> other;
+        other.reserve(list.size());
+        for (auto const& elem : list)
+            other.push_back(function(elem));
+        return other;
     };
 
-    this_module.global("filter") = [](std::vector<Object> const& list, Object function)
+    this_module.global("filter") = [](std::vector<Object> list, Object function)
     {
         std::vector<Object> other;
         other.reserve(list.size());
@@ -80,13 +83,11 @@ void Core::record()
         if (!list.size())
             return Object::nil();
 
-        while (list.size() != 1)
-        {
-            list[0] = function(list[0], list[1]);
-            list.erase(list.begin()+1);
-        }
+        Object acc = list[0];
+        for (auto it = list.begin() + 1; it != list.end(); ++it)
+            acc = function(acc, *it);
 
-        return list[0];
+        return acc;
     };
 
     this_module.global("proxy") = [](Object f, Object proxy)
@@ -254,7 +255,7 @@ void Core::record()
     {
         Class c("core", "string");
         c["string"]      = [](std::string const& a) { return a; };
-        c[std_add]       = [](std::string self, std::string const& b) { self += b; return self; };
+        c[std_add]       = [](std::string const& a, std::string const& b) { return a + b; };
         c[std_equals]    = [](std::string const& a, std::string const& b) { return a == b; };
         c[std_lt]        = [](std::string const& a, std::string const& b) { return a < b; };
         c["get"]         = [](std::string const& a, int i) { return a.at(i); };
@@ -333,20 +334,24 @@ void Core::record()
         {
             return (int) self.size();
         };
-        c["prepend"] = [](std::vector<Object>& self, Object obj)
+        // These return a copy of the list, which only shares its storage
+        //   until one of them is modified
+        c["prepend"] = [](Object self, Object obj)
         {
-            self.insert(self.begin(), obj);
-            return self;
+            std::vector<Object>& list = self.unwrap<std::vector<Object>>();
+            list.insert(list.begin(), obj);
+            return self.copy();
         };
-        c["append"] = [](std::vector<Object>& self, Object obj)
+        c["append"] = [](Object self, Object obj)
         {
-            self.push_back(obj);
-            return self;
+            self.unwrap<std::vector<Object>>().push_back(obj);
+            return self.copy();
         };
-        c["extend"] = [](std::vector<Object>& self, std::vector<Object> const& list)
+        c["extend"] = [](Object self, std::vector<Object> const& other)
         {
-            std::copy(list.begin(), list.end(), std::back_inserter(self));
-            return self;
+            std::vector<Object>& list = self.unwrap<std::vector<Object>>();
+            std::copy(other.begin(), other.end(), std::back_inserter(list));
+            return self.copy();
         };
         c["swap"] = [](std::vector<Object>& self, int i, int j)
         {
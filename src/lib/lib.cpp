@@ -1,12 +1,23 @@
 #include "lib/lib.hpp"
+#include "core/object.hpp"
+#include "vm/aot.hpp"
 
 namespace lib
 {
     void recordAll()
     {
+        // First phase : record all builtin classes, objects created
+        //   meanwhile may not have their type associated yet
         Core::record();
         Io::record();
         Lang::record();
         Dict::record();
+
+        // Modules compiled ahead of time are recorded as builtins too
+        vm::aot::recordAll();
+
+        // Second phase : every builtin type is now associated, bind
+        //   the pending objects once and for all
+        core::Object::bindPending();
     }
 }
@@ -0,0 +1,171 @@
+/*  This file is part of Axolotl.
+ *
+ * Axolotl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Axolotl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Axolotl.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "vm/aot.hpp"
+#include "vm/engine.hpp"
+#include "lang/std_names.hpp"
+#include "lang/std_atoms.hpp"
+
+using namespace vm;
+using namespace aot;
+using namespace core;
+
+static std::vector<RecordFunction>& records()
+{
+    // Filled during static initialization, the order of which is unknown
+    static std::vector<RecordFunction> records;
+    return records;
+}
+
+// Constant-initialized, so it is set before any unit is added
+static bool all_recorded = false;
+
+Callback::Callback(Signature const& signature, Function const& fun)
+    : m_signature(signature)
+    , m_fun(fun)
+{}
+
+Object Callback::invoke(std::vector<Object> args)
+{
+    // Same as the arguments of script functions
+    for (auto& arg : args)
+        arg = arg.thawed();
+
+    return m_fun(args);
+}
+
+Signature Callback::signature() const
+{ return m_signature; }
+
+bool aot::add(RecordFunction record)
+{
+    // The unit was initialized after the builtins were recorded
+    if (all_recorded)
+        record();
+    else
+        records().push_back(record);
+
+    return true;
+}
+
+void aot::recordAll()
+{
+    for (auto record : records())
+        record();
+
+    records().clear();
+    all_recorded = true;
+}
+
+Object aot::function(Signature::TypeList const& arguments, Callback::Function const& fun)
+{ return Callable(Callable::NativeMetaType(new Callback(Signature(arguments), fun))); }
+
+Object aot::invoke(Object fun, std::vector<Object> const& args)
+{
+    std::vector<Object> argv = args;
+
+    if (fun.invokable() && !fun.callable())
+        argv.insert(argv.begin(), fun);
+
+    while (fun.invokable() && !fun.callable())
+        fun = fun.findPolymorphic(lang::std_call_atom, argv);
+
+    if (!fun.callable())
+    {
+        throw SignatureError(fun, "", argv);
+    }
+
+    Callable call = fun.unwrap<Callable>();
+
+    if (!call.signature().match(argv))
+    {
+        throw SignatureError(fun, "", argv);
+    }
+
+    return call.invoke(argv);
+}
+
+Object aot::method(Object self, Atom const& name, std::vector<Object> const& args)
+{
+    if (!self.has(name))
+    {
+        throw NoMemberError(self, name.name());
+    }
+
+    std::vector<Object> argv;
+    argv.reserve(args.size() + 1);
+    argv.push_back(self);
+    argv.insert(argv.end(), args.begin(), args.end());
+
+    Object fun = self.findPolymorphic(name, argv);
+    if (fun.isNil())
+    {
+        throw SignatureError(self, name.name(), argv);
+    }
+
+    return invoke(fun, argv);
+}
+
+Object aot::loadMember(Object self, Atom const& name)
+{ return self.member(name); }
+
+void aot::storMember(Object self, Atom const& name, Object value)
+{
+    if (self.frozen())
+        self = self.copy();
+    self.member(name) = value.thawed();
+}
+
+bool aot::truth(Object const& cond)
+{
+    if (!cond.meta().is<bool>())
+    {
+        throw ClassError(cond, type_class<bool>());
+    }
+
+    return cond.unwrap<bool>();
+}
+
+static void import_module(Unit& unit, std::string const& name, std::string const* mask)
+{
+    // Imports go through the engine's table, like the IMPORT instruction
+    Engine* engine = unit.module.engine();
+    ImportTable* table = engine ? engine->importTable() : unit.module.importTable();
+
+    Module imported;
+
+    if (!table->exists(name))
+    {
+        imported = mask ? table->importMask(unit.imports, name, *mask) : table->import(unit.imports, name);
+        imported.setEngine(engine);
+    }
+    else
+    {
+        // Compiled modules get the names of their imports when they are
+        //   parsed, compiled ahead of time ones only get them here
+        imported = table->module(name);
+        imported.exportTo(unit.imports, mask ? *mask : "", name);
+    }
+
+    if (!imported.initCalled())
+        imported.init();
+}
+
+void aot::import(Unit& unit, std::string const& name)
+{ import_module(unit, name, nullptr); }
+
+void aot::importMask(Unit& unit, std::string const& name, std::string const& mask)
+{ import_module(unit, name, &mask); }
@@ -0,0 +1,304 @@
+/*  This file is part of Axolotl.
+ *
+ * Axolotl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Axolotl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Axolotl.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "vm/bytecode_cache.hpp"
+#include "vm/import_table.hpp"
+#include "bits/mapped_buffer.hpp"
+#include "lang/compiler.hpp"
+
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <unistd.h>
+
+using namespace vm;
+using namespace bits;
+
+std::map<std::string, uint64_t> ByteCodeCache::m_sources;
+std::map<std::string, ByteCodeCache::Dependencies> ByteCodeCache::m_dependencies;
+
+static void write_u32(std::ostream& out, uint32_t value)
+{ out.write((char const*) &value, sizeof(value)); }
+
+static void write_u64(std::ostream& out, uint64_t value)
+{ out.write((char const*) &value, sizeof(value)); }
+
+static void write_string(std::ostream& out, std::string const& str)
+{
+    write_u32(out, (uint32_t) str.size());
+    out.write(str.data(), str.size());
+}
+
+static bool read_u64(uint8_t const*& in, uint8_t const* end, uint64_t& value)
+{
+    if ((std::size_t) (end - in) < sizeof(value))
+        return false;
+
+    std::memcpy(&value, in, sizeof(value));
+    in += sizeof(value);
+    return true;
+}
+
+static bool read_string(uint8_t const*& in, uint8_t const* end, std::string& str)
+{
+    uint32_t size;
+    if ((std::size_t) (end - in) < sizeof(size))
+        return false;
+
+    std::memcpy(&size, in, sizeof(size));
+    in += sizeof(size);
+    if ((std::size_t) (end - in) < size)
+        return false;
+
+    str.assign((char const*) in, size);
+    in += size;
+    return true;
+}
+
+bool ByteCodeCache::load(std::string const& name, std::istream& source, Module& module)
+{
+    if (!enabled())
+        return false;
+
+    // The source is hashed on every import, which is still far cheaper
+    //   than compiling it
+    std::string text((std::istreambuf_iterator<char>(source)), std::istreambuf_iterator<char>());
+    source.clear();
+    source.seekg(0);
+
+    uint64_t hash = M_hash(text);
+    m_sources[name] = hash;
+
+    // The file is mapped once, the blob is used in place and the
+    //   checksum covers exactly the bytes which are loaded
+    MappedBuffer file;
+    if (!file.open(M_file(name)) || file.size() < sizeof(cache_hdr))
+        return false;
+
+    uint8_t const* raw = file.view(0, file.size());
+    uint8_t const* end = raw + file.size();
+
+    cache_hdr hdr;
+    std::memcpy(&hdr, raw, sizeof(hdr));
+
+    if (hdr.c_magic != CACHE_MAGIC ||
+        hdr.c_blob_version != BLOB_VERSION ||
+        hdr.c_compiler_version != lang::COMPILER_VERSION ||
+        hdr.c_source_hash != hash)
+        return false;
+
+    // The whole body is checked for corruption, the blob included
+    uint8_t const* body = raw + sizeof(hdr);
+    std::size_t body_size = end - body;
+    if (body_size < hdr.c_blob_size || M_hash(body, body_size) != hdr.c_body_hash)
+        return false;
+
+    uint8_t const* pos = body;
+    uint8_t const* prefix_end = end - hdr.c_blob_size;
+
+    std::vector<ImportTable::Request> requests(hdr.c_nrequests);
+    for (auto& request : requests)
+    {
+        if (!read_string(pos, prefix_end, request.name) ||
+            !read_string(pos, prefix_end, request.mask) ||
+            !read_string(pos, prefix_end, request.alias))
+            return false;
+    }
+
+    // Dependencies are checked before anything is imported
+    Dependencies dependencies;
+    for (uint32_t i = 0; i < hdr.c_ndeps; ++i)
+    {
+        std::string dep;
+        uint64_t dep_hash;
+        if (!read_string(pos, prefix_end, dep) || !read_u64(pos, prefix_end, dep_hash))
+            return false;
+
+        uint64_t current;
+        if (!M_sourceHash(dep, current) || current != dep_hash)
+            return false;
+
+        dependencies.push_back(std::make_pair(dep, dep_hash));
+    }
+
+    // The blob shares the mapping of the file
+    Blob blob(file.sub(prefix_end - raw, hdr.c_blob_size));
+    if (!blob.check())
+        return false;
+
+    // Same imports as the parser, in the same order
+    Module loaded(name);
+    ImportTable* table = loaded.importTable();
+    for (auto const& request : requests)
+    {
+        if (request.mask.size())
+            table->importMask(loaded, request.name, request.mask);
+        else if (request.alias != request.name)
+            table->importAs(loaded, request.name, request.alias);
+        else
+            table->import(loaded, request.name);
+    }
+
+    loaded.setBlob(blob);
+
+    dependencies.insert(dependencies.begin(), std::make_pair(name, hash));
+    m_dependencies[name] = dependencies;
+
+    module = loaded;
+    return true;
+}
+
+void ByteCodeCache::store(std::string const& name, Module& module)
+{
+    if (!enabled())
+        return;
+
+    auto source = m_sources.find(name);
+    ImportTable* table = module.importTable();
+    if (source == m_sources.end() || !table)
+        return;
+
+    // Dependencies of the imported user modules are dependencies
+    //   of this module too
+    Dependencies dependencies;
+    dependencies.push_back(std::make_pair(name, source->second));
+
+    for (auto const& request : table->requests())
+    {
+        auto it = m_dependencies.find(request.name);
+        if (it == m_dependencies.end())
+            continue;
+
+        for (auto const& dep : it->second)
+        {
+            bool found = false;
+            for (auto const& known : dependencies)
+                found = found || known.first == dep.first;
+
+            if (!found)
+                dependencies.push_back(dep);
+        }
+    }
+
+    m_dependencies[name] = dependencies;
+
+    // Concurrent processes may write the same module, the cache file is
+    //   replaced atomically
+    std::string file = M_file(name);
+    std::string tmp = file + "." + std::to_string(getpid()) + ".tmp";
+
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out)
+            return;
+
+        std::ostringstream body;
+        for (auto const& request : table->requests())
+        {
+            write_string(body, request.name);
+            write_string(body, request.mask);
+            write_string(body, request.alias);
+        }
+
+        for (std::size_t i = 1; i < dependencies.size(); ++i)
+        {
+            write_string(body, dependencies[i].first);
+            write_u64(body, dependencies[i].second);
+        }
+
+        std::ostringstream blob;
+        if (!module.blob().write(blob))
+            return;
+        body << blob.str();
+
+        cache_hdr hdr;
+        hdr.c_magic = CACHE_MAGIC;
+        hdr.c_blob_version = BLOB_VERSION;
+        hdr.c_compiler_version = lang::COMPILER_VERSION;
+        hdr.c_source_hash = source->second;
+        hdr.c_nrequests = (uint32_t) table->requests().size();
+        hdr.c_ndeps = (uint32_t) dependencies.size() - 1;
+        hdr.c_blob_size = (uint32_t) blob.str().size();
+        hdr.c_body_hash = M_hash(body.str());
+        out.write((char const*) &hdr, sizeof(hdr));
+
+        out << body.str();
+
+        if (!out)
+        {
+            out.close();
+            std::remove(tmp.c_str());
+            return;
+        }
+    }
+
+    if (std::rename(tmp.c_str(), file.c_str()))
+        std::remove(tmp.c_str());
+}
+
+bool ByteCodeCache::enabled()
+{
+    static int enabled = -1;
+    if (enabled < 0)
+    {
+        char const* env = std::getenv("AXOLOTL_CACHE");
+        enabled = !(env && std::string(env) == "0");
+    }
+    return enabled;
+}
+
+uint64_t ByteCodeCache::M_hash(std::string const& data)
+{
+    return M_hash((uint8_t const*) data.data(), data.size());
+}
+
+uint64_t ByteCodeCache::M_hash(uint8_t const* data, std::size_t size)
+{
+    // 64-bit FNV-1a, stable across builds unlike std::hash
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        hash ^= data[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+bool ByteCodeCache::M_sourceHash(std::string const& name, uint64_t& hash)
+{
+    auto it = m_sources.find(name);
+    if (it != m_sources.end())
+    {
+        hash = it->second;
+        return true;
+    }
+
+    std::ifstream in(name + ".xl", std::ios::binary);
+    if (!in)
+        return false;
+
+    std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    hash = M_hash(text);
+    m_sources[name] = hash;
+    return true;
+}
+
+std::string ByteCodeCache::M_file(std::string const& name)
+{ return name + ".xlc"; }
@@ -17,12 +17,15 @@
 #include "bits/bits.hpp"
 #include "vm/engine.hpp"
 #include "vm/function.hpp"
+#include "vm/jit.hpp"
 #include "lang/lexer.hpp"
 #include "lang/parser_base.hpp"
 #include "lang/std_names.hpp"
+#include "lang/std_atoms.hpp"
 #include "util/ansi.hpp"
 
 #include <memory>
+#include <algorithm>
 #include <sstream>
 #include <fstream>
 #include <stdexcept>
@@ -33,10 +36,37 @@ using namespace vm;
 using namespace bits;
 using namespace core;
 
+// Quickened form of a method called on two integers
+static Opcode quickened_int_method(Atom const& name)
+{
+    static const std::unordered_map<Atom, Opcode> opcodes =
+    {
+        { lang::std_add_atom, ADD_INT },
+        { lang::std_sub_atom, SUB_INT },
+        { lang::std_mul_atom, MUL_INT },
+        { lang::std_div_atom, DIV_INT },
+        { lang::std_mod_atom, MOD_INT },
+        { lang::std_equals_atom, EQ_INT },
+        { lang::std_nequals_atom, NE_INT },
+        { lang::std_lt_atom, LT_INT },
+        { lang::std_lte_atom, LE_INT },
+        { lang::std_gt_atom, GT_INT },
+        { lang::std_gte_atom, GE_INT }
+    };
+
+    auto it = opcodes.find(name);
+    return it != opcodes.end() ? it->second : INVALID;
+}
+
 Engine::Engine(Module const& main_module)
     : m_main_module(main_module)
     , m_text(nullptr)
+    , m_code(nullptr)
+    , m_code_size(0)
+    , m_quick_text(nullptr)
     , m_module(nullptr)
+    , m_jit(nullptr)
+    , m_profile(nullptr)
 {
     m_import_table = m_main_module.detachImportTable();
     m_import_table->setEngine(this);
@@ -48,8 +78,11 @@ Engine::Engine(Module const& main_module)
 
     m_argc = 0;
     m_locals_count = 0;
-    m_debug.has = false;
     m_pc = -1;
+    m_ir_pc = -1;
+
+    if (Jit::enabled())
+        m_jit = new Jit(this);
 }
 
 Engine::~Engine()
@@ -62,6 +95,9 @@ Engine::~Engine()
 
     if (m_module)
         delete m_module;
+
+    if (m_jit)
+        delete m_jit;
 }
 
 Object Engine::execute(Function const& fun, std::vector<Object> const& args)
@@ -70,7 +106,7 @@ Object Engine::execute(Function const& fun, std::vector<Object> const& args)
 
     // Setup arguments
     for (int i = 0; i < (int) args.size(); ++i)
-        M_push(args[i]);
+        M_push(args[i].thawed());
 
     // Push a dummy stack frame, when we will
     //   reach it execution will stop
@@ -92,23 +128,28 @@ Object Engine::execute(Function const& fun, std::vector<Object> const& args)
 ImportTable* Engine::importTable() const
 { return m_import_table; }
 
+void Engine::release(Module::Impl const* module)
+{ m_quick.erase(module); }
+
 void Engine::M_initOpcodes()
 {
+    // Opcodes are numbered in definition order, so this
+    //   table is indexed by opcode
     #define DEF_MASK(name, value)
-    #define DEF_OPCODE(name, nargs) m_opcodes_nargs[name] = nargs;
+    #define DEF_OPCODE(name, nargs) m_opcodes_nargs.push_back(nargs);
     #include "bits/opcodes.def"
     #undef DEF_OPCODE
     #undef DEF_MASK
 
     int nargs_max = 0;
-    for (auto it : m_opcodes_nargs)
-        if (it.second > nargs_max)
-            nargs_max = it.second;
+    for (auto nargs : m_opcodes_nargs)
+        if (nargs > nargs_max)
+            nargs_max = nargs;
     m_operands.reserve(nargs_max);
 }
 
 bool Engine::M_checkOpcode(Opcode opcode) const
-{ return m_opcodes_nargs.find(opcode) != m_opcodes_nargs.end(); }
+{ return opcode >= 0 && opcode < (int) m_opcodes_nargs.size(); }
 
 Object& Engine::M_top()
 {
@@ -186,62 +227,68 @@ void Engine::M_changeModule(Module const& module)
         throw InternalError("vm::Engine::M_changeModule: module has no text");
         // throw std::runtime_error("vm::Engine::M_changeModule: module has no text");
     }
-
-    blob_debug_header* debug_header = module.blob().debugHeader();
-    if (debug_header)
+    // The engine runs its own copy of the code so it can quicken it
+    QuickText& quick = m_quick[module.m_impl];
+    if (quick.code.empty() && m_text->size())
     {
-        if (!module.blob().string(debug_header->d_file, m_debug.file))
-        {
-            throw InternalError("vm::Engine::M_changeModule: file name in debug header invalid");
-            // throw std::runtime_error("vm::Engine::M_changeModule: file name in debug header invalid");
-        }
+        uint8_t const* raw = m_text->view(0, m_text->size());
+        quick.code.assign(raw, raw + m_text->size());
     }
 
+    m_quick_text = &quick;
+    m_code_size = (int) quick.code.size();
+    m_code = m_code_size ? quick.code.data() : nullptr;
+
     if (m_module)
         delete m_module;
     m_module = new Module(module);
 }
 
-uint32_t Engine::M_fetch()
+uint8_t Engine::M_fetch()
 {
-    if (!m_text)
+    if (!m_code)
     {
         throw InternalError("vm::Engine::M_fetch: no text");
         // throw std::runtime_error("vm::Engine::M_fetch: no text");
     }
-    if (m_pc < 0 || m_pc >= (int) (m_text->size() / sizeof(uint32_t)))
+    if (m_pc < 0 || m_pc >= m_code_size)
     {
         throw InternalError("vm::Engine::M_fetch: invalid PC");
         // throw std::runtime_error("vm::Engine::M_fetch: invalid PC");
     }
 
-    return *((uint32_t*) m_text->raw(sizeof(uint32_t) * m_pc++, sizeof(uint32_t)));
+    return m_code[m_pc++];
 }
 
-void Engine::M_decode()
+int32_t Engine::M_fetchOperand()
 {
-    // Get the opcode
-    m_ir = (Opcode) M_fetch();
+    if (!m_code)
+    {
+        throw InternalError("vm::Engine::M_fetchOperand: no text");
+    }
+    if (m_pc < 0 || m_pc >= m_code_size)
+    {
+        throw InternalError("vm::Engine::M_fetchOperand: invalid PC");
+    }
 
-    if (m_ir & DEBUG_MASK)
+    // Operands are signed LEB128 values
+    std::size_t pos = m_pc;
+    int32_t value;
+    if (!sleb128_decode(m_code, pos, m_code + m_code_size, value))
     {
-        m_ir = (Opcode) (m_ir & (~DEBUG_MASK));
-        uint32_t idx = M_fetch();
+        throw InternalError("vm::Engine::M_fetchOperand: truncated operand");
+    }
 
-        blob_debug_entry* entry = m_module->blob().debugEntry(idx);
-        if (!entry)
-        {
-            throw InternalError("vm::Engine::M_decode: invalid debug entry index");
-            // M_error("M_decode: invalid debug entry index");
-        }
+    m_pc = (int) pos;
+    return value;
+}
 
-        m_debug.has = true;
-        m_debug.line = entry->de_line;
-        m_debug.col = entry->de_col;
-        m_debug.extent = entry->de_extent;
-    }
-    else
-        m_debug.has = false;
+void Engine::M_decode()
+{
+    // Get the opcode, its address is kept to find
+    //   its debug information if needed
+    m_ir_pc = m_pc;
+    m_ir = (Opcode) M_fetch();
 
     if (!M_checkOpcode(m_ir))
     {
@@ -252,15 +299,38 @@ void Engine::M_decode()
     // Get the operands
     m_operands.clear();
     for (int i = 0; i < m_opcodes_nargs[m_ir]; ++i)
-        m_operands.push_back(M_fetch());
+        m_operands.push_back(M_fetchOperand());
 }
 
 bool Engine::M_execute()
 {
+    // Hot functions run natively until they leave the function
+    int status;
+    if (m_profile && m_profile->code && m_jit->run(m_profile, m_pc, status))
+        return status != Jit::STOP;
+
     try
     {
         M_decode();
+    }
+    catch (Exception const& error)
+    {
+        M_error(error.what());
+        return false;
+    }
+    catch (std::exception const& error)
+    {
+        M_error(error.what());
+        return false;
+    }
 
+    return M_run();
+}
+
+bool Engine::M_run()
+{
+    try
+    {
         switch (m_ir)
         {
             case NOP:
@@ -289,7 +359,7 @@ bool Engine::M_execute()
                 if (m_ir == LOAD_LOCAL)
                     M_push(local);
                 else // if (m_ir == STOR_LOCAL)
-                    local = M_pop();
+                    local = M_pop().thawed();
 
                 break;
             }
@@ -298,10 +368,11 @@ bool Engine::M_execute()
             {
                 int index = m_operands[0];
 
-                // Load a constant from the consts table
+                // Load a constant from the consts table, constants are
+                //   frozen so they are shared until stored somewhere
                 if (index >= 0)
                 {
-                    M_push(m_module->constant(index).copy());
+                    M_push(m_module->constant(index));
                 }
                 // Load an argument
                 else
@@ -331,12 +402,7 @@ bool Engine::M_execute()
             case STOR_GLOBAL:
             {
                 // Get and check the operand
-                std::string name;
-                if (!m_module->blob().string(m_operands[0], name))
-                {
-                    throw InternalError("vm::Engine::M_execute: invalid string index");
-                    // M_error("M_execute: invalid string index");
-                }
+                Atom name = m_module->atom(m_operands[0]);
 
                 // Get the global
                 Object& global = m_module->global(name);
@@ -344,7 +410,7 @@ bool Engine::M_execute()
                 if (m_ir == LOAD_GLOBAL)
                     M_push(global);
                 else // if (m_ir == STOR_GLOBAL)
-                    global = M_pop();
+                    global = M_pop().thawed();
 
                 break;
             }
@@ -353,23 +419,18 @@ bool Engine::M_execute()
             case STOR_MEMBER:
             {
                 // Get and check the operand
-                std::string name;
-                if (!m_module->blob().string(m_operands[0], name))
-                {
-                    throw InternalError("vm::Engine::M_execute: invalid string index");
-                    // M_error("M_execute: invalid string index");
-                }
+                Atom name = m_module->atom(m_operands[0]);
 
                 // Get the object
                 Object self = M_pop();
 
                 if (m_ir == LOAD_MEMBER)
-                {
                     M_push(((Object) self).member(name));
-                }
                 else // if (m_ir == STOR_MEMBER)
                 {
-                    self.member(name) = M_pop();
+                    if (self.frozen())
+                        self = self.copy();
+                    self.member(name) = M_pop().thawed();
                 }
 
                 break;
@@ -392,47 +453,119 @@ bool Engine::M_execute()
 
             case METHOD:
             {
-                std::string name;
-                if (!m_module->blob().string(m_operands[0], name))
+                int argc = m_operands[1];
+                if (argc < 0)
                 {
-                    throw InternalError("vm::Engine::M_execute: invalid string index");
-                    // M_error("M_execute: invalid string index");
+                    throw InternalError("vm::Engine::M_execute: invalid operand");
+                    // M_error("M_execute: invalid operand");
                 }
 
+                Atom name = m_module->atom(m_operands[0]);
+
+                int top = M_stackIndex();
+                if (argc == 1 && M_stackAt(top).meta().is<int>() && M_stackAt(top - 1).meta().is<int>())
+                    M_observe(quickened_int_method(name));
+
+                M_method(name, argc);
+                break;
+            }
+
+            case CALL_SYMBOL:
+            case CALL_SYMBOL_TYPED:
+            {
+                blob_symbol const* symbol = m_module->blob().symbol(m_operands[0]);
                 int argc = m_operands[1];
-                if (argc < 0)
+                if (!symbol || argc < 0)
                 {
                     throw InternalError("vm::Engine::M_execute: invalid operand");
-                    // M_error("M_execute: invalid operand");
                 }
 
-                Object self = M_pop();
-                if (!self.has(name))
+                if (!M_symbolMatches(m_operands[0], symbol, argc, m_ir == CALL_SYMBOL_TYPED))
+                {
+                    M_method(m_module->atom(symbol->s_name), argc);
+                    break;
+                }
+
+                // Self is on top of its arguments, the callee expects it first
+                int base = M_stackIndex() - argc;
+                std::rotate(m_stack.begin() + base, m_stack.end() - 1, m_stack.end());
+                for (int i = base; i <= base + argc; ++i)
                 {
-                    throw NoMemberError(self, name);
-                    // M_error("M_execute: method '" + name + "' does not exists for class '" + self.classname() + "'");
+                    if (m_stack[i].frozen())
+                        m_stack[i] = m_stack[i].thawed();
                 }
 
-                // Insert the 'self' object on the stack
-                std::vector<Object> argv(argc + 1, Object::nil());
-                argv[0] = self;
-                for (int i = 0; i < argc; ++i)
-                    argv[argc - i] = M_pop();
+                M_enter();
+                M_branchToSymbol(*m_module, symbol);
+                m_argc = argc + 1;
+
+                break;
+            }
 
-                Object fun = self.findPolymorphic(name, argv);
-                if (fun.isNil())
+            case GUARD_SYMBOL:
+            {
+                blob_symbol const* symbol = m_module->blob().symbol(m_operands[0]);
+                if (!symbol)
                 {
-                    throw SignatureError(self, name, argv);
+                    throw InternalError("vm::Engine::M_execute: invalid operand");
                 }
 
-                for (auto arg : argv)
-                    M_push(arg);
+                // The inlined call takes as many arguments as the method, self aside
+                int argc = -1;
+                m_module->blob().foreachSignatureArgument(symbol->s_signature, [&](blob_long) { ++argc; });
 
-                M_invoke(fun, argc + 1);
+                if (argc < 0 || !M_symbolMatches(m_operands[0], symbol, argc))
+                    m_pc = m_operands[1];
 
                 break;
             }
 
+            case ADD_INT:
+            case SUB_INT:
+            case MUL_INT:
+            case DIV_INT:
+            case MOD_INT:
+            case EQ_INT:
+            case NE_INT:
+            case LT_INT:
+            case LE_INT:
+            case GT_INT:
+            case GE_INT:
+            {
+                // Quickened METHOD, self is on top of its argument
+                int index = M_stackIndex();
+                Object const& self = M_stackAt(index);
+                Object const& other = M_stackAt(index - 1);
+                if (!self.meta().is<int>() || !other.meta().is<int>())
+                    return M_deoptimize(METHOD);
+
+                int a = self.unwrap<int>();
+                int b = other.unwrap<int>();
+                if ((m_ir == DIV_INT || m_ir == MOD_INT) && b == 0)
+                    return M_deoptimize(METHOD);
+
+                Object ret = Object::nil();
+                switch (m_ir)
+                {
+                    case ADD_INT: ret = a + b;  break;
+                    case SUB_INT: ret = a - b;  break;
+                    case MUL_INT: ret = a * b;  break;
+                    case DIV_INT: ret = a / b;  break;
+                    case MOD_INT: ret = a % b;  break;
+                    case EQ_INT:  ret = a == b; break;
+                    case NE_INT:  ret = a != b; break;
+                    case LT_INT:  ret = a < b;  break;
+                    case LE_INT:  ret = a <= b; break;
+                    case GT_INT:  ret = a > b;  break;
+                    case GE_INT:  ret = a >= b; break;
+                    default:                    break;
+                }
+
+                M_shrinkStack(2);
+                M_push(ret);
+                break;
+            }
+
             case RETURN:
             case LEAVE:
             {
@@ -460,6 +593,10 @@ bool Engine::M_execute()
 
                 m_pc = base + m_operands[0];
 
+                // Loops make a function hot as well
+                if (m_jit && m_profile && m_pc <= m_ir_pc)
+                    m_jit->backEdge(m_profile);
+
                 break;
             }
 
@@ -596,8 +733,8 @@ StackFrame Engine::M_makeFrame(bool dummy) const
     frame.locals_start = m_locals_start;
     frame.locals_count = m_locals_count;
     frame.argc = m_argc;
-    if (m_debug.has)
-        frame.debug = m_debug;
+    frame.call_pc = m_ir_pc;
+    frame.profile = m_profile;
 
     return frame;
 }
@@ -609,6 +746,7 @@ bool Engine::M_setFrame(StackFrame const& frame)
     m_locals_start = frame.locals_start;
     m_locals_count = frame.locals_count;
     m_argc = frame.argc;
+    m_profile = frame.profile;
 
     return frame.dummy;
 }
@@ -624,7 +762,7 @@ void Engine::M_invoke(Object fun, int argc)
         argv.insert(argv.begin(), fun);
 
     while (fun.invokable() && !fun.callable())
-        fun = fun.findPolymorphic(lang::std_call, argv);
+        fun = fun.findPolymorphic(lang::std_call_atom, argv);
 
     if (!fun.callable())
     {
@@ -648,7 +786,7 @@ void Engine::M_invoke(Object fun, int argc)
     else
     {
         for (auto arg : argv)
-            M_push(arg);
+            M_push(arg.thawed());
 
         M_enter();
         M_branchToFunction(call.meta().as<Function>());
@@ -656,6 +794,61 @@ void Engine::M_invoke(Object fun, int argc)
     }
 }
 
+void Engine::M_method(Atom const& name, int argc)
+{
+    Object self = M_pop();
+    if (!self.has(name))
+    {
+        throw NoMemberError(self, name.name());
+        // M_error("M_execute: method '" + name + "' does not exists for class '" + self.classname() + "'");
+    }
+
+    // Insert the 'self' object on the stack
+    std::vector<Object> argv(argc + 1, Object::nil());
+    argv[0] = self;
+    for (int i = 0; i < argc; ++i)
+        argv[argc - i] = M_pop();
+
+    Object fun = self.findPolymorphic(name, argv);
+    if (fun.isNil())
+    {
+        throw SignatureError(self, name.name(), argv);
+    }
+
+    for (auto arg : argv)
+        M_push(arg);
+
+    M_invoke(fun, argc + 1);
+}
+
+bool Engine::M_symbolMatches(blob_idx symidx, blob_symbol const* symbol, int argc, bool typed) const
+{
+    // The call is the one dynamic dispatch would make when self is an
+    //   unaltered instance of the class declaring the method, and the
+    //   arguments match the method's signature
+    int top = M_stackIndex();
+    if (top < argc)
+        return false;
+
+    Object const& self = m_stack[top];
+    if (self.isNil() || self.overridden() || self.classid() != m_module->methodClass(symidx))
+        return false;
+
+    int i = 0;
+    bool match = true;
+    bool valid = m_module->blob().foreachSignatureArgument(symbol->s_signature, [&](blob_long classid)
+    {
+        if (i > argc)
+            match = false;
+        else if (!typed && classid != Class::AnyId && i > 0 &&
+                 m_stack[top - argc + i - 1].classid() != (Class::Id) classid)
+            match = false;
+        ++i;
+    });
+
+    return valid && match && i == argc + 1;
+}
+
 void Engine::M_enter(bool dummy)
 {
     M_push(M_makeFrame(dummy));
@@ -683,23 +876,144 @@ bool Engine::M_leave()
 }
 
 void Engine::M_branchToFunction(Function const& fun)
+{ M_branchToSymbol(fun.module(), fun.symbol()); }
+
+void Engine::M_branchToSymbol(Module const& module, blob_symbol const* symbol)
 {
-    M_changeModule(fun.module());
-    m_pc = fun.symbol()->s_addr;
+    M_changeModule(module);
+    m_pc = symbol->s_addr;
     m_locals_start = M_stackIndex() + 1;
-    m_locals_count = fun.symbol()->s_nlocals;
+    m_locals_count = symbol->s_nlocals;
     M_growStack(m_locals_count);
+
+    if (m_jit)
+    {
+        m_profile = m_jit->profile(module, symbol);
+        m_jit->call(m_profile);
+    }
+}
+
+void Engine::M_observe(Opcode quickened)
+{
+    if (quickened == INVALID || !m_quick_text)
+        return;
+
+    auto it = m_quick_text->sites.find(m_ir_pc);
+    if (it == m_quick_text->sites.end())
+        it = m_quick_text->sites.insert(std::make_pair(m_ir_pc, QuickSite { quickened, 0, 0 })).first;
+
+    QuickSite& site = it->second;
+    if (site.deopts >= QUICKEN_MAX_DEOPTS)
+        return;
+
+    // Only consecutive observations count
+    if (site.opcode != quickened)
+    {
+        site.opcode = quickened;
+        site.hits = 0;
+    }
+
+    if (++site.hits >= QUICKEN_HITS)
+        m_code[m_ir_pc] = quickened;
+}
+
+bool Engine::M_deoptimize(Opcode generic)
+{
+    // The generic instruction has the same operands and the same
+    //   address, so the debug information still applies to it
+    QuickSite& site = m_quick_text->sites[m_ir_pc];
+    site.hits = 0;
+    ++site.deopts;
+
+    m_code[m_ir_pc] = generic;
+    m_ir = generic;
+
+    return M_run();
+}
+
+Engine::DebugInfo Engine::M_debugInfo(Module const& module, int pc) const
+{
+    DebugInfo info;
+    info.has = false;
+
+    if (pc < 0)
+        return info;
+
+    blob_debug_header const* header = module.blob().debugHeader();
+    blob_debug_entry entry;
+    if (!header || !module.blob().debugEntry(pc, entry))
+        return info;
+
+    if (!module.blob().string(header->d_file, info.file))
+        return info;
+
+    info.has = true;
+    info.line = entry.de_line;
+    info.col = entry.de_col;
+    info.extent = entry.de_extent;
+    return info;
+}
+
+Engine::DebugInfo Engine::M_inlinedAt(Module const& module, int pc) const
+{
+    DebugInfo info;
+    info.has = false;
+
+    std::shared_ptr<Buffer> text = module.blob().text();
+    if (!text || pc < 0 || pc >= (int) text->size())
+        return info;
+
+    // Start of the function, the closest symbol before the instruction
+    std::size_t start = 0;
+    module.blob().foreachSymbol([&](blob_idx, blob_symbol const* symbol)
+    {
+        if (symbol->s_addr <= (blob_off) pc && symbol->s_addr > start)
+            start = symbol->s_addr;
+    });
+
+    // An inlined method lies between its guard and the dynamic call
+    //   the guard branches to, the guard has the token of the call
+    uint8_t const* code = text->view(0, text->size());
+    uint8_t const* end = code + text->size();
+    for (std::size_t addr = start; addr < (std::size_t) pc; )
+    {
+        std::size_t pos = addr;
+        Opcode opcode = (Opcode) code[pos++];
+
+        std::vector<int> operands;
+        for (int i = 0; i < opcode_nargs(opcode); ++i)
+        {
+            int32_t operand;
+            if (!sleb128_decode(code, pos, end, operand))
+                return info;
+            operands.push_back((int) operand);
+        }
+
+        if (opcode == GUARD_SYMBOL && pc < operands[1])
+            info = M_debugInfo(module, (int) addr);
+
+        addr = pos;
+    }
+
+    return info;
 }
 
 void Engine::M_error(std::string const& msg) const
 {
     std::ostringstream ss;
 
+    // Debug information is only looked up here, from the
+    //   address of the faulty instruction
+    DebugInfo debug;
+    debug.has = false;
+    if (m_module)
+        debug = M_debugInfo(*m_module, m_ir_pc);
+
     std::string prefix = "";
-    if (m_debug.has)
+    if (debug.has)
     {
         std::ostringstream ss;
-        ss << util::ansi::bold << m_debug.file << ":" << m_debug.line << ":" << m_debug.col << ": ";
+        ss << util::ansi::bold << debug.file << ":" << debug.line << ":" << debug.col << ": ";
         ss << util::ansi::clear;
         prefix = ss.str();
     }
@@ -708,19 +1022,19 @@ void Engine::M_error(std::string const& msg) const
     ss << "runtime error: " << util::ansi::clear;
     ss << msg << std::endl;
 
-    if (m_debug.has)
+    if (debug.has)
     {
-        std::ifstream is(m_debug.file);
+        std::ifstream is(debug.file);
         if (is)
         {
             std::size_t pos;
-            std::string line = lang::Lexer::snippet(is, m_debug.line, m_debug.col, pos);
+            std::string line = lang::Lexer::snippet(is, debug.line, debug.col, pos);
 
             if (line.size())
             {
                 std::string fmt = lang::ParserBase::emph_color;
                 line.insert(pos, fmt);
-                std::size_t end = std::min(line.size()-1, pos + fmt.size() + m_debug.extent);
+                std::size_t end = std::min(line.size()-1, pos + fmt.size() + debug.extent);
                 line.insert(end, util::ansi::clear);
             }
 
@@ -731,7 +1045,7 @@ void Engine::M_error(std::string const& msg) const
                 ss << " ";
             ss << lang::ParserBase::emph_color << "^";
 
-            for (int i = 0; i < ((int) m_debug.extent) - 1; ++i)
+            for (int i = 0; i < ((int) debug.extent) - 1; ++i)
                 ss << "~";
             ss << util::ansi::clear << std::endl;
         }
@@ -740,57 +1054,73 @@ void Engine::M_error(std::string const& msg) const
     ss << prefix << util::ansi::bold << lang::ParserBase::note_color;
     ss << "backtrace: " << util::ansi::clear << std::endl;
 
-    for (int i = m_backtrace.size() - 1; i >= 0; --i)
+    // Line of a function of the backtrace, at the instruction of `info'
+    auto print_frame = [&](Module const& module, int pc, DebugInfo const& info)
     {
         std::ostringstream ss2;
 
-        Object obj = M_stackAt(m_backtrace[i]);
+        ss2 << util::ansi::bold << module.name() << ".";
 
-        if (!obj.meta().is<StackFrame>())
-            ss2 << "< " << util::ansi::bold << lang::ParserBase::error_color << "bogus" << util::ansi::clear << " >" << std::endl;
-        else
+        bits::Disassembler dis(module.blob());
+        std::string name;
+        int offset;
+        if (dis.functionAt(pc, name, offset))
         {
-            StackFrame frame = obj.unwrap<StackFrame>();
-
-            ss2 << util::ansi::bold << frame.module.name() << ".";
+            ss2 << name << util::ansi::clear << " + " << offset;
+        }
+        else
+            ss2 << "???" << util::ansi::clear;
 
-            bits::Disassembler dis(frame.module.blob());
-            std::string name;
-            int offset;
-            if (dis.functionAt(frame.pc, name, offset))
+        if (info.has)
+        {
+            std::ifstream is(info.file);
+            if (is)
             {
-                ss2 << name << util::ansi::clear << " + " << offset;
-            }
-            else
-                ss2 << "???" << util::ansi::clear;
+                std::string previous = ss2.str();
+                ss2.str("");
 
-            if (frame.debug.is<DebugInfo>())
-            {
-                DebugInfo info = frame.debug.as<DebugInfo>();
+                ss2 << std::setw(56) << std::left << previous << std::right << " ";
 
-                std::ifstream is(info.file);
-                if (is)
-                {
-                    std::string previous = ss2.str();
-                    ss2.str("");
-
-                    ss2 << std::setw(56) << std::left << previous << std::right << " ";
-
-                    std::size_t pos;
-                    std::string line = lang::Lexer::snippet(is, info.line, info.col, pos);
-                    std::string fmt = lang::ParserBase::emph_color;
-                    line.insert(pos, fmt);
-                    std::size_t end = std::min(line.size()-1, pos + fmt.size() + info.extent);
-                    line.insert(end, util::ansi::clear);
-                    ss2 << "        " << util::ansi::bold << info.file << ":" << info.line << ":" << info.col << ": ";
-                    ss2 << util::ansi::clear << line << std::endl;
-                }
+                std::size_t pos;
+                std::string line = lang::Lexer::snippet(is, info.line, info.col, pos);
+                std::string fmt = lang::ParserBase::emph_color;
+                line.insert(pos, fmt);
+                std::size_t end = std::min(line.size()-1, pos + fmt.size() + info.extent);
+                line.insert(end, util::ansi::clear);
+                ss2 << "        " << util::ansi::bold << info.file << ":" << info.line << ":" << info.col << ": ";
+                ss2 << util::ansi::clear << line << std::endl;
             }
-            else
-                ss2 << std::endl;
         }
+        else
+            ss2 << std::endl;
 
         ss << ss2.str();
+    };
+
+    // Inlined methods have no frame, their caller is shown at the call
+    if (m_module)
+    {
+        DebugInfo site = M_inlinedAt(*m_module, m_ir_pc);
+        if (site.has)
+            print_frame(*m_module, m_ir_pc, site);
+    }
+
+    for (int i = m_backtrace.size() - 1; i >= 0; --i)
+    {
+        Object obj = M_stackAt(m_backtrace[i]);
+
+        if (!obj.meta().is<StackFrame>())
+        {
+            ss << "< " << util::ansi::bold << lang::ParserBase::error_color << "bogus" << util::ansi::clear << " >" << std::endl;
+            continue;
+        }
+
+        StackFrame frame = obj.unwrap<StackFrame>();
+        print_frame(frame.module, frame.pc, M_debugInfo(frame.module, frame.call_pc));
+
+        DebugInfo site = M_inlinedAt(frame.module, frame.call_pc);
+        if (site.has)
+            print_frame(frame.module, frame.pc, site);
     }
 
     std::cerr << ss.str();
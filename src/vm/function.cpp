@@ -25,7 +25,7 @@ using namespace vm;
 using namespace bits;
 using namespace core;
 
-Function::Function(Module const& module, bits::blob_symbol* symbol)
+Function::Function(Module const& module, bits::blob_symbol const* symbol)
     : m_module(module)
     , m_symbol(symbol)
 {
@@ -51,7 +51,7 @@ core::Signature const& Function::signature() const
 Module const& Function::module() const
 { return m_module; }
 
-bits::blob_symbol* Function::symbol() const
+bits::blob_symbol const* Function::symbol() const
 { return m_symbol; }
 
 void Function::M_createSignature()
@@ -16,6 +16,7 @@
 
 #include "vm/import_table.hpp"
 #include "vm/engine.hpp"
+#include "vm/bytecode_cache.hpp"
 #include "lang/std_names.hpp"
 #include "lang/lang.hpp"
 #include "core/exception.hpp"
@@ -83,6 +84,9 @@ Module const& ImportTable::module(std::string const& name) const
     return m_table.find(name)->second.module;
 }
 
+std::vector<ImportTable::Request> const& ImportTable::requests() const
+{ return m_requests; }
+
 void ImportTable::setEngine(Engine* engine)
 {
     for (auto& import : m_table)
@@ -104,6 +108,9 @@ Module ImportTable::M_import(Module& to, std::string const& name, std::string co
 
     import.module.exportTo(to, mask, alias, extra);
 
+    Request request = { name, mask, alias };
+    m_requests.push_back(request);
+
     return import.module;
 }
 
@@ -136,7 +143,14 @@ ImportTable::Import ImportTable::M_open(std::string const& name, std::string con
 
     Import import;
     import.alias = alias;
-    import.module = Compiler(name, ss).compile();
+
+    // Compiled modules are cached next to their source
+    if (!ByteCodeCache::load(name, ss, import.module))
+    {
+        import.module = Compiler(name, ss).compile();
+        ByteCodeCache::store(name, import.module);
+    }
+
     m_table[name] = import;
 
     return m_table[name];
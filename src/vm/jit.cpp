@@ -0,0 +1,1340 @@
+/*  This file is part of Axolotl.
+ *
+ * Axolotl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Axolotl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Axolotl.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "vm/jit.hpp"
+#include "vm/engine.hpp"
+#include "bits/opcodes.hpp"
+#include "bits/leb128.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#if defined(__x86_64__) && defined(__linux__)
+#define AXOLOTL_JIT_X86_64
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+using namespace vm;
+using namespace bits;
+using namespace core;
+
+namespace
+{
+    enum Reg
+    {
+        RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI,
+        R8, R9, R10, R11, R12, R13, R14, R15
+    };
+
+    // Condition codes
+    enum Cond
+    {
+        CC_E = 0x4,
+        CC_NE = 0x5,
+        CC_AE = 0x3,
+        CC_BE = 0x6,
+        CC_B = 0x2,
+        CC_S = 0x8,
+        CC_L = 0xC,
+        CC_GE = 0xD,
+        CC_LE = 0xE,
+        CC_G = 0xF
+    };
+
+    // Minimal x86-64 machine code emitter
+    class Emitter
+    {
+    public:
+        void byte(uint8_t b)
+        { m_out.push_back(b); }
+
+        void bytes(std::initializer_list<uint8_t> bs)
+        { m_out.insert(m_out.end(), bs); }
+
+        void imm32(int32_t imm)
+        {
+            for (int i = 0; i < 4; ++i)
+                byte((uint32_t) imm >> (8 * i));
+        }
+
+        void imm64(uint64_t imm)
+        {
+            for (int i = 0; i < 8; ++i)
+                byte(imm >> (8 * i));
+        }
+
+        //! Emit a rel32 field to be patched later, return its position
+        std::size_t rel32()
+        {
+            std::size_t at = pos();
+            imm32(0);
+            return at;
+        }
+
+        void patch(std::size_t at, std::size_t target)
+        {
+            int32_t rel = (int32_t) target - (int32_t) (at + 4);
+            for (int i = 0; i < 4; ++i)
+                m_out[at + i] = (uint32_t) rel >> (8 * i);
+        }
+
+        std::size_t pos() const
+        { return m_out.size(); }
+
+        std::vector<uint8_t> const& code() const
+        { return m_out; }
+
+        void truncate(std::size_t size)
+        { m_out.resize(size); }
+
+        //! `op reg, [base + disp]', `reg' is the opcode extension for
+        //!   the /digit forms
+        void mem(bool wide, std::initializer_list<uint8_t> op, int reg, int base, int32_t disp)
+        {
+            M_rex(wide, reg, base);
+            bytes(op);
+            byte(0x80 | (reg & 7) << 3 | (base & 7));
+            if ((base & 7) == RSP)
+                byte(0x24);
+            imm32(disp);
+        }
+
+        //! `op rm, reg' with both operands in registers
+        void reg(bool wide, std::initializer_list<uint8_t> op, int reg, int rm)
+        {
+            M_rex(wide, reg, rm);
+            bytes(op);
+            byte(0xC0 | (reg & 7) << 3 | (rm & 7));
+        }
+
+        void movImm(int reg, uint64_t imm)
+        {
+            M_rex(true, 0, reg);
+            byte(0xB8 + (reg & 7));
+            imm64(imm);
+        }
+
+        void call(uint64_t function)
+        {
+            movImm(RAX, function);
+            reg(false, { 0xFF }, 2, RAX);
+        }
+
+        std::size_t jmp()
+        {
+            byte(0xE9);
+            return rel32();
+        }
+
+        std::size_t jcc(int cond)
+        {
+            bytes({ 0x0F, (uint8_t) (0x80 | cond) });
+            return rel32();
+        }
+
+    private:
+        void M_rex(bool wide, int reg, int rm)
+        {
+            uint8_t rex = 0x40 | (wide ? 8 : 0) | (reg & 8 ? 4 : 0) | (rm & 8 ? 1 : 0);
+            if (rex != 0x40)
+                byte(rex);
+        }
+
+    private:
+        std::vector<uint8_t> m_out;
+    };
+
+    // Helpers return values, native code continues on 0
+    enum
+    {
+        STEP_NEXT = 0,
+        STEP_BRANCH = 3
+    };
+
+    struct Instruction
+    {
+        int pc;
+        int next_pc;
+        Opcode opcode;
+        int operands[2];
+    };
+
+    struct Helpers
+    {
+        uint64_t step;
+        uint64_t drop;
+        uint64_t push_int;
+        uint64_t push_bool;
+        uint64_t store_int;
+    };
+
+    // Kinds of instruction consuming the value of an unboxed region
+    enum Exit
+    {
+        //! Stored in a local
+        EXIT_STORE,
+        //! Tested by a conditional jump
+        EXIT_BRANCH,
+        //! Anything else, the value is boxed and pushed
+        EXIT_PUSH
+    };
+
+    // Integer expression evaluated in registers, from instruction `first'
+    //   to instruction `last' (the last operation)
+    struct Region
+    {
+        std::size_t first;
+        std::size_t last;
+        Exit exit;
+    };
+
+    // Registers holding the values of a region
+    const int VALUE_REGS[] = { R8, R9, R10, R11, R14, R15 };
+    constexpr std::size_t MAX_VALUES = sizeof(VALUE_REGS) / sizeof(VALUE_REGS[0]);
+
+    // Objects are two words, the weak flag then the instance, stacks are
+    //   vectors of objects (both are checked by Jit::M_layout)
+    constexpr int32_t OBJECT_SIZE = 16;
+    constexpr int32_t OBJECT_WEAK = 0;
+    constexpr int32_t OBJECT_IMPL = 8;
+    constexpr int32_t VECTOR_BEGIN = 0;
+    constexpr int32_t VECTOR_END = 8;
+    constexpr int32_t VECTOR_CAPACITY = 16;
+
+    // Translates one function, rbx holds the engine and r12 its stack
+    //   while native code runs
+    class Translator
+    {
+    public:
+        Translator(JitLayout const& layout, Helpers const& helpers, Emitter& em)
+            : m_layout(layout)
+            , m_helpers(helpers)
+            , m_em(em)
+            , m_constants(nullptr)
+            , m_slow(nullptr)
+            , m_jumps(nullptr)
+        {}
+
+        //! Emit the native version of an instruction, jumps to its slow
+        //!   path are recorded in `slow' and branches in `jumps'
+        //! \return false if the instruction has no native version
+        bool emit(Instruction const& insn, Instruction const* next, int start, int end,
+                  std::vector<std::size_t>& slow, std::vector<std::pair<std::size_t, int>>& jumps)
+        {
+            m_slow = &slow;
+            m_jumps = &jumps;
+
+            switch (insn.opcode)
+            {
+                case NOP:
+                    return true;
+
+                case POP:
+                    M_needStack(1);
+                    M_popTop();
+                    M_drop();
+                    return true;
+
+                case LOAD_LOCAL:
+                case LOAD_CONST:
+                    if (!M_isLeaf(insn))
+                        return false;
+
+                    M_needRoom();
+                    M_leafAddress(insn);
+
+                    // Decoded constants are frozen
+                    if (insn.opcode == LOAD_CONST && insn.operands[0] >= 0)
+                    {
+                        m_em.mem(true, { 0x8B }, RDX, RSI, OBJECT_IMPL);            // mov rdx, [rsi + 8]
+                        m_em.mem(false, { 0x80 }, 7, RDX, m_layout.frozen);         // cmp byte [rdx + frozen], 0
+                        m_em.byte(0);
+                        M_slow(CC_E);
+                    }
+
+                    M_pushCopy();
+                    return true;
+
+                case STOR_LOCAL:
+                    if (insn.operands[0] < 0)
+                        return false;
+
+                    M_checkLocal(insn.operands[0]);
+                    M_needStack(1);
+
+                    // Frozen values are copied before being stored
+                    m_em.mem(true, { 0x8B }, RDX, RAX, -OBJECT_SIZE + OBJECT_IMPL); // mov rdx, [rax - 8]
+                    m_em.mem(false, { 0x80 }, 7, RDX, m_layout.frozen);             // cmp byte [rdx + frozen], 0
+                    m_em.byte(0);
+                    M_slow(CC_NE);
+
+                    M_localAddress(RSI, insn.operands[0]);
+                    m_em.reg(true, { 0x81 }, 5, RAX);                               // sub rax, OBJECT_SIZE
+                    m_em.imm32(OBJECT_SIZE);
+                    m_em.mem(true, { 0x89 }, RAX, R12, VECTOR_END);                 // mov [r12 + end], rax
+
+                    // The value is moved, the previous one is dropped
+                    m_em.mem(true, { 0x8B }, RCX, RSI, OBJECT_WEAK);                // mov rcx, [rsi]
+                    m_em.mem(true, { 0x8B }, RDI, RSI, OBJECT_IMPL);                // mov rdi, [rsi + 8]
+                    m_em.mem(true, { 0x8B }, RDX, RAX, OBJECT_WEAK);                // mov rdx, [rax]
+                    m_em.mem(true, { 0x89 }, RDX, RSI, OBJECT_WEAK);                // mov [rsi], rdx
+                    m_em.mem(true, { 0x8B }, RDX, RAX, OBJECT_IMPL);                // mov rdx, [rax + 8]
+                    m_em.mem(true, { 0x89 }, RDX, RSI, OBJECT_IMPL);                // mov [rsi + 8], rdx
+                    M_drop();
+                    return true;
+
+                case JMP:
+                case JMPR:
+                {
+                    int target = M_target(insn);
+                    if (target < start || target >= end)
+                        return false;
+
+                    m_jumps->push_back(std::make_pair(m_em.jmp(), target));
+                    return true;
+                }
+
+                case JMP_IF_FALSE:
+                case JMP_IF_TRUE:
+                case JMPR_IF_FALSE:
+                case JMPR_IF_TRUE:
+                {
+                    int target = M_target(insn);
+                    if (target < start || target >= end)
+                        return false;
+
+                    M_needStack(1);
+                    M_checkTag(RAX, -OBJECT_SIZE, m_layout.bool_tag);
+                    m_em.mem(false, { 0x0F, 0xB6 }, R13, RDX, m_layout.bool_value); // movzx r13d, byte [rdx + value]
+                    M_popTop();
+                    M_drop();
+                    M_branch(insn, target);
+                    return true;
+                }
+
+                case ADD_INT:
+                case SUB_INT:
+                case MUL_INT:
+                case DIV_INT:
+                case MOD_INT:
+                case EQ_INT:
+                case NE_INT:
+                case LT_INT:
+                case LE_INT:
+                case GT_INT:
+                case GE_INT:
+                {
+                    // Self is on top of the other operand
+                    M_needStack(2);
+                    M_checkTag(RAX, -OBJECT_SIZE, m_layout.int_tag);
+                    m_em.mem(false, { 0x8B }, R8, RDX, m_layout.int_value);         // mov r8d, [rdx + value]
+                    M_checkTag(RAX, -2 * OBJECT_SIZE, m_layout.int_tag);
+                    m_em.mem(false, { 0x8B }, R9, RDX, m_layout.int_value);         // mov r9d, [rdx + value]
+
+                    bool compare = M_intOperation(insn.opcode);
+
+                    M_popTop();
+                    M_drop();
+                    M_popTop();
+                    M_drop();
+
+                    // A comparison followed by a conditional jump branches
+                    //   directly, the boolean is never built
+                    if (compare && next && M_isConditional(next->opcode) && next->next_pc < end)
+                    {
+                        int target = M_target(*next);
+                        if (target >= start && target < end)
+                        {
+                            M_branch(*next, target);
+                            m_jumps->push_back(std::make_pair(m_em.jmp(), next->next_pc));
+                            return true;
+                        }
+                    }
+
+                    m_em.reg(true, { 0x89 }, RBX, RDI);                              // mov rdi, rbx
+                    m_em.reg(false, { 0x89 }, R13, RSI);                             // mov esi, r13d
+                    m_em.call(compare ? m_helpers.push_bool : m_helpers.push_int);
+                    return true;
+                }
+
+                default:
+                    return false;
+            }
+        }
+
+        //! Find the integer expression starting at instruction `i', guided by
+        //!   the quickened operations. Its leaves are locals and constants,
+        //!   which have no side effect, so a failed guard anywhere in it can
+        //!   go back to the first instruction.
+        //! \return false if there is none
+        bool findRegion(std::vector<Instruction> const& insns, std::size_t i, int start, int end,
+                        Region& region) const
+        {
+            // Whether each value is a boolean
+            std::vector<bool> values;
+            std::vector<bool> values_at_last;
+            std::size_t last = insns.size();
+
+            for (std::size_t k = i; k < insns.size(); ++k)
+            {
+                Opcode opcode = insns[k].opcode;
+                if (M_isLeaf(insns[k]))
+                {
+                    if (values.size() == MAX_VALUES)
+                        break;
+
+                    values.push_back(false);
+                    continue;
+                }
+
+                if (opcode < ADD_INT || opcode > GE_INT || values.size() < 2 ||
+                    values[values.size() - 1] || values[values.size() - 2])
+                    break;
+
+                values.pop_back();
+                values.back() = opcode >= EQ_INT;
+
+                last = k;
+                values_at_last = values;
+            }
+
+            // Values left below the result would have to be pushed
+            if (last + 1 >= insns.size() || values_at_last.size() != 1)
+                return false;
+
+            Instruction const& consumer = insns[last + 1];
+            int target = M_target(consumer);
+            bool boolean = values_at_last[0];
+
+            region.first = i;
+            region.last = last;
+            region.exit = EXIT_PUSH;
+
+            if (!boolean && consumer.opcode == STOR_LOCAL && consumer.operands[0] >= 0 && consumer.next_pc < end)
+                region.exit = EXIT_STORE;
+            else if (boolean && M_isConditional(consumer.opcode) && target >= start && target < end &&
+                     consumer.next_pc < end)
+                region.exit = EXIT_BRANCH;
+
+            return true;
+        }
+
+        //! Emit the unboxed version of a region, failed guards are recorded
+        //!   in `bail' and branches in `jumps'
+        void region(std::vector<Instruction> const& insns, Region const& region,
+                     std::vector<std::size_t>& bail, std::vector<std::pair<std::size_t, int>>& jumps)
+        {
+            m_slow = &bail;
+            m_jumps = &jumps;
+
+            std::size_t depth = 0;
+            for (std::size_t k = region.first; k <= region.last; ++k)
+            {
+                Instruction const& insn = insns[k];
+                if (M_isLeaf(insn))
+                {
+                    M_leafAddress(insn);
+                    M_checkTag(RSI, 0, m_layout.int_tag);
+                    m_em.mem(false, { 0x8B }, VALUE_REGS[depth], RDX, m_layout.int_value); // mov value, [rdx + value]
+                    ++depth;
+                    continue;
+                }
+
+                // Self is on top of the other operand, which gets the result
+                M_unboxedOperation(insn.opcode, VALUE_REGS[depth - 1], VALUE_REGS[depth - 2]);
+                --depth;
+            }
+
+            Instruction const& consumer = insns[region.last + 1];
+            int value = VALUE_REGS[0];
+            switch (region.exit)
+            {
+                case EXIT_STORE:
+                    M_checkLocal(consumer.operands[0]);
+                    m_em.reg(true, { 0x89 }, RBX, RDI);                 // mov rdi, rbx
+                    m_em.byte(0xBE);                                    // mov esi, index
+                    m_em.imm32(consumer.operands[0]);
+                    m_em.reg(false, { 0x89 }, value, RDX);              // mov edx, value
+                    m_em.call(m_helpers.store_int);
+                    jumps.push_back(std::make_pair(m_em.jmp(), consumer.next_pc));
+                    break;
+
+                case EXIT_BRANCH:
+                {
+                    bool if_true = consumer.opcode == JMP_IF_TRUE || consumer.opcode == JMPR_IF_TRUE;
+                    m_em.reg(false, { 0x85 }, value, value);            // test value, value
+                    jumps.push_back(std::make_pair(m_em.jcc(if_true ? CC_NE : CC_E), M_target(consumer)));
+                    jumps.push_back(std::make_pair(m_em.jmp(), consumer.next_pc));
+                    break;
+                }
+
+                case EXIT_PUSH:
+                {
+                    bool boolean = insns[region.last].opcode >= EQ_INT;
+                    m_em.reg(true, { 0x89 }, RBX, RDI);                 // mov rdi, rbx
+                    m_em.reg(false, { 0x89 }, value, RSI);              // mov esi, value
+                    m_em.call(boolean ? m_helpers.push_bool : m_helpers.push_int);
+                    jumps.push_back(std::make_pair(m_em.jmp(), consumer.pc));
+                    break;
+                }
+            }
+        }
+
+        //! Emit the call to the engine executing an instruction
+        void step(Instruction const& insn, std::size_t exit, int start, int end,
+                  std::vector<std::pair<std::size_t, int>>& jumps)
+        {
+            m_em.reg(true, { 0x89 }, RBX, RDI);     // mov rdi, rbx
+            m_em.byte(0xBE);                        // mov esi, opcode
+            m_em.imm32(insn.opcode);
+            m_em.byte(0xBA);                        // mov edx, operand #0
+            m_em.imm32(insn.operands[0]);
+            m_em.byte(0xB9);                        // mov ecx, operand #1
+            m_em.imm32(insn.operands[1]);
+            m_em.bytes({ 0x41, 0xB8 });             // mov r8d, pc
+            m_em.imm32(insn.pc);
+            m_em.bytes({ 0x41, 0xB9 });             // mov r9d, next pc
+            m_em.imm32(insn.next_pc);
+            m_em.call(m_helpers.step);
+
+            int target = M_target(insn);
+            if ((M_isConditional(insn.opcode) || insn.opcode == GUARD_SYMBOL) && target >= start && target < end)
+            {
+                m_em.bytes({ 0x83, 0xF8, STEP_BRANCH }); // cmp eax, STEP_BRANCH
+                jumps.push_back(std::make_pair(m_em.jcc(CC_E), target));
+            }
+
+            m_em.reg(false, { 0x85 }, RAX, RAX);    // test eax, eax
+            m_em.patch(m_em.jcc(CC_NE), exit);
+        }
+
+        void setConstants(std::vector<core::Object> const* constants)
+        { m_constants = constants; }
+
+    private:
+        static bool M_isConditional(Opcode opcode)
+        {
+            return opcode == JMP_IF_FALSE || opcode == JMP_IF_TRUE ||
+                opcode == JMPR_IF_FALSE || opcode == JMPR_IF_TRUE;
+        }
+
+        static int M_target(Instruction const& insn)
+        {
+            switch (insn.opcode)
+            {
+                case GUARD_SYMBOL:
+                    return insn.operands[1];
+                case JMPR:
+                case JMPR_IF_FALSE:
+                case JMPR_IF_TRUE:
+                    return insn.next_pc + insn.operands[0];
+                case JMP:
+                case JMP_IF_FALSE:
+                case JMP_IF_TRUE:
+                    return insn.operands[0];
+                default:
+                    return -1;
+            }
+        }
+
+        bool M_isLeaf(Instruction const& insn) const
+        {
+            int index = insn.operands[0];
+            switch (insn.opcode)
+            {
+                case LOAD_LOCAL:
+                    return index >= 0;
+                case LOAD_CONST:
+                    return index >= 0 ? m_constants && index < INT32_MAX / OBJECT_SIZE : index >= -INT32_MAX + 2;
+                default:
+                    return false;
+            }
+        }
+
+        //! rsi = address of the object loaded by a leaf
+        void M_leafAddress(Instruction const& insn)
+        {
+            int index = insn.operands[0];
+            if (insn.opcode == LOAD_LOCAL)
+            {
+                M_checkLocal(index);
+                M_localAddress(RSI, index);
+            }
+            else if (index >= 0)
+            {
+                // Constants which were not decoded yet are nil
+                m_em.movImm(RSI, reinterpret_cast<uint64_t>(m_constants));
+                m_em.mem(true, { 0x8B }, RDX, RSI, VECTOR_END);         // mov rdx, [rsi + end]
+                m_em.mem(true, { 0x8B }, RSI, RSI, VECTOR_BEGIN);       // mov rsi, [rsi]
+                m_em.reg(true, { 0x81 }, 0, RSI);                       // add rsi, index * OBJECT_SIZE
+                m_em.imm32(index * OBJECT_SIZE);
+                m_em.reg(true, { 0x39 }, RDX, RSI);                     // cmp rsi, rdx
+                M_slow(CC_AE);
+            }
+            else
+                M_argumentAddress(index);
+        }
+
+        //! rsi = address of an argument, see Engine::M_run
+        void M_argumentAddress(int index)
+        {
+            m_em.mem(true, { 0x63 }, RSI, RBX, m_layout.locals_start);  // movsxd rsi, [rbx + locals_start]
+            m_em.mem(true, { 0x63 }, RDX, RBX, m_layout.argc);          // movsxd rdx, [rbx + argc]
+            m_em.reg(true, { 0x29 }, RDX, RSI);                         // sub rsi, rdx
+            m_em.reg(true, { 0x81 }, 0, RSI);                           // add rsi, -index - 2
+            m_em.imm32(-index - 2);
+            M_slow(CC_S);
+            m_em.reg(true, { 0xC1 }, 4, RSI);                           // shl rsi, 4
+            m_em.byte(4);
+            m_em.mem(true, { 0x03 }, RSI, R12, VECTOR_BEGIN);           // add rsi, [r12]
+        }
+
+        //! other = self op other
+        void M_unboxedOperation(Opcode opcode, int self, int other)
+        {
+            int cond = -1;
+            switch (opcode)
+            {
+                case ADD_INT:
+                    m_em.reg(false, { 0x01 }, self, other);             // add other, self
+                    return;
+                case MUL_INT:
+                    m_em.reg(false, { 0x0F, 0xAF }, other, self);       // imul other, self
+                    return;
+                case SUB_INT:
+                    m_em.reg(false, { 0x89 }, self, RAX);               // mov eax, self
+                    m_em.reg(false, { 0x29 }, other, RAX);              // sub eax, other
+                    m_em.reg(false, { 0x89 }, RAX, other);              // mov other, eax
+                    return;
+                case DIV_INT:
+                case MOD_INT:
+                    m_em.reg(false, { 0x85 }, other, other);            // test other, other
+                    M_slow(CC_E);
+                    m_em.reg(false, { 0x89 }, self, RAX);               // mov eax, self
+                    m_em.byte(0x99);                                    // cdq
+                    m_em.reg(false, { 0xF7 }, 7, other);                // idiv other
+                    m_em.reg(false, { 0x89 }, opcode == DIV_INT ? RAX : RDX, other); // mov other, eax/edx
+                    return;
+                case EQ_INT: cond = CC_E;  break;
+                case NE_INT: cond = CC_NE; break;
+                case LT_INT: cond = CC_L;  break;
+                case LE_INT: cond = CC_LE; break;
+                case GT_INT: cond = CC_G;  break;
+                case GE_INT: cond = CC_GE; break;
+                default:
+                    break;
+            }
+
+            m_em.reg(false, { 0x39 }, other, self);                     // cmp self, other
+            m_em.bytes({ 0x0F, (uint8_t) (0x90 | cond), 0xC0 });        // setcc al
+            m_em.reg(false, { 0x0F, 0xB6 }, other, RAX);                // movzx other, al
+        }
+
+        void M_slow(int cond)
+        { m_slow->push_back(m_em.jcc(cond)); }
+
+        //! Branch on r13d as the conditional jump `insn' does
+        void M_branch(Instruction const& insn, int target)
+        {
+            bool if_true = insn.opcode == JMP_IF_TRUE || insn.opcode == JMPR_IF_TRUE;
+            m_em.reg(false, { 0x85 }, R13, R13);                    // test r13d, r13d
+            m_jumps->push_back(std::make_pair(m_em.jcc(if_true ? CC_NE : CC_E), target));
+        }
+
+        //! rax = end of the stack, which holds at least `count' objects
+        void M_needStack(int count)
+        {
+            m_em.mem(true, { 0x8B }, RAX, R12, VECTOR_END);        // mov rax, [r12 + end]
+            m_em.reg(true, { 0x89 }, RAX, RCX);                     // mov rcx, rax
+            m_em.mem(true, { 0x2B }, RCX, R12, VECTOR_BEGIN);      // sub rcx, [r12]
+            m_em.reg(true, { 0x81 }, 7, RCX);                       // cmp rcx, count * OBJECT_SIZE
+            m_em.imm32(count * OBJECT_SIZE);
+            M_slow(CC_B);
+        }
+
+        //! rax = end of the stack, which can grow without reallocation
+        void M_needRoom()
+        {
+            m_em.mem(true, { 0x8B }, RAX, R12, VECTOR_END);        // mov rax, [r12 + end]
+            m_em.mem(true, { 0x3B }, RAX, R12, VECTOR_CAPACITY);   // cmp rax, [r12 + capacity]
+            M_slow(CC_AE);
+        }
+
+        void M_checkLocal(int index)
+        {
+            m_em.mem(false, { 0x81 }, 7, RBX, m_layout.locals_count); // cmp dword [rbx + locals_count], index
+            m_em.imm32(index);
+            M_slow(CC_LE);
+        }
+
+        //! reg = address of local #index
+        void M_localAddress(int reg, int index)
+        {
+            m_em.mem(true, { 0x63 }, reg, RBX, m_layout.locals_start); // movsxd reg, [rbx + locals_start]
+            m_em.reg(true, { 0x81 }, 0, reg);                           // add reg, index
+            m_em.imm32(index);
+            m_em.reg(true, { 0xC1 }, 4, reg);                           // shl reg, 4
+            m_em.byte(4);
+            m_em.mem(true, { 0x03 }, reg, R12, VECTOR_BEGIN);          // add reg, [r12]
+        }
+
+        //! Check the type of the object at [base + offset] against a vtable,
+        //!   rdx = its value
+        void M_checkTag(int base, int32_t offset, uint64_t tag)
+        {
+            m_em.mem(true, { 0x8B }, RDI, base, offset + OBJECT_IMPL); // mov rdi, [base + offset + 8]
+            m_em.mem(true, { 0x8B }, RDX, RDI, m_layout.data);         // mov rdx, [rdi + data]
+            m_em.reg(true, { 0x85 }, RDX, RDX);                         // test rdx, rdx
+            M_slow(CC_E);
+            m_em.movImm(RSI, tag);                                      // mov rsi, tag
+            m_em.mem(true, { 0x39 }, RSI, RDX, 0);                      // cmp [rdx], rsi
+            M_slow(CC_NE);
+        }
+
+        //! Push a copy of the object at rsi, rax = end of the stack
+        void M_pushCopy()
+        {
+            m_em.mem(true, { 0x8B }, RCX, RSI, OBJECT_WEAK);            // mov rcx, [rsi]
+            m_em.mem(true, { 0x8B }, RDX, RSI, OBJECT_IMPL);            // mov rdx, [rsi + 8]
+            m_em.mem(true, { 0x89 }, RCX, RAX, OBJECT_WEAK);            // mov [rax], rcx
+            m_em.mem(true, { 0x89 }, RDX, RAX, OBJECT_IMPL);            // mov [rax + 8], rdx
+            m_em.reg(false, { 0x84 }, RCX, RCX);                        // test cl, cl
+            std::size_t weak = m_em.jcc(CC_NE);
+            m_em.mem(false, { 0x83 }, 0, RDX, m_layout.refcount);       // add dword [rdx + refcount], 1
+            m_em.byte(1);
+            m_em.patch(weak, m_em.pos());
+            m_em.mem(true, { 0x83 }, 0, R12, VECTOR_END);               // add qword [r12 + end], OBJECT_SIZE
+            m_em.byte(OBJECT_SIZE);
+        }
+
+        //! Pop the top of the stack, rcx = its weak flag and rdi = its instance
+        void M_popTop()
+        {
+            m_em.mem(true, { 0x8B }, RAX, R12, VECTOR_END);             // mov rax, [r12 + end]
+            m_em.reg(true, { 0x81 }, 5, RAX);                           // sub rax, OBJECT_SIZE
+            m_em.imm32(OBJECT_SIZE);
+            m_em.mem(true, { 0x89 }, RAX, R12, VECTOR_END);             // mov [r12 + end], rax
+            m_em.mem(true, { 0x8B }, RCX, RAX, OBJECT_WEAK);            // mov rcx, [rax]
+            m_em.mem(true, { 0x8B }, RDI, RAX, OBJECT_IMPL);            // mov rdi, [rax + 8]
+        }
+
+        //! Release the reference in rcx (weak flag) and rdi (instance)
+        void M_drop()
+        {
+            m_em.reg(false, { 0x84 }, RCX, RCX);                        // test cl, cl
+            std::size_t weak = m_em.jcc(CC_NE);
+            m_em.mem(false, { 0x83 }, 7, RDI, m_layout.refcount);       // cmp dword [rdi + refcount], 1
+            m_em.byte(1);
+            std::size_t shared = m_em.jcc(CC_NE);
+            m_em.call(m_helpers.drop);
+            std::size_t dropped = m_em.jmp();
+            m_em.patch(shared, m_em.pos());
+            m_em.mem(false, { 0x83 }, 5, RDI, m_layout.refcount);       // sub dword [rdi + refcount], 1
+            m_em.byte(1);
+            m_em.patch(weak, m_em.pos());
+            m_em.patch(dropped, m_em.pos());
+        }
+
+        //! r13d = r8d op r9d
+        //! \return true if the result is a boolean
+        bool M_intOperation(Opcode opcode)
+        {
+            int cond = -1;
+            switch (opcode)
+            {
+                case ADD_INT:
+                    m_em.reg(false, { 0x89 }, R8, R13);                 // mov r13d, r8d
+                    m_em.reg(false, { 0x01 }, R9, R13);                 // add r13d, r9d
+                    return false;
+                case SUB_INT:
+                    m_em.reg(false, { 0x89 }, R8, R13);                 // mov r13d, r8d
+                    m_em.reg(false, { 0x29 }, R9, R13);                 // sub r13d, r9d
+                    return false;
+                case MUL_INT:
+                    m_em.reg(false, { 0x89 }, R8, R13);                 // mov r13d, r8d
+                    m_em.reg(false, { 0x0F, 0xAF }, R13, R9);           // imul r13d, r9d
+                    return false;
+                case DIV_INT:
+                case MOD_INT:
+                    // Division by zero deoptimizes, see Engine::M_run
+                    m_em.reg(false, { 0x85 }, R9, R9);                  // test r9d, r9d
+                    M_slow(CC_E);
+                    m_em.reg(false, { 0x89 }, R8, RAX);                 // mov eax, r8d
+                    m_em.byte(0x99);                                    // cdq
+                    m_em.reg(false, { 0xF7 }, 7, R9);                   // idiv r9d
+                    m_em.reg(false, { 0x89 }, opcode == DIV_INT ? RAX : RDX, R13); // mov r13d, eax/edx
+                    return false;
+                case EQ_INT: cond = CC_E;  break;
+                case NE_INT: cond = CC_NE; break;
+                case LT_INT: cond = CC_L;  break;
+                case LE_INT: cond = CC_LE; break;
+                case GT_INT: cond = CC_G;  break;
+                case GE_INT: cond = CC_GE; break;
+                default:
+                    break;
+            }
+
+            m_em.reg(false, { 0x39 }, R9, R8);                          // cmp r8d, r9d
+            m_em.bytes({ 0x0F, (uint8_t) (0x90 | cond), 0xC0 });        // setcc al
+            m_em.reg(false, { 0x0F, 0xB6 }, R13, RAX);                  // movzx r13d, al
+            return true;
+        }
+
+    private:
+        JitLayout const& m_layout;
+        Helpers const& m_helpers;
+        Emitter& m_em;
+        std::vector<core::Object> const* m_constants;
+        std::vector<std::size_t>* m_slow;
+        std::vector<std::pair<std::size_t, int>>* m_jumps;
+    };
+}
+
+Jit::Jit(Engine* engine)
+    : m_engine(engine)
+    , m_layout(M_layout(engine))
+    , m_perf_map(nullptr)
+    , m_ready(false)
+    , m_stop(false)
+{
+    // perf(1) looks for JIT symbols in this file
+    if (std::getenv("AXOLOTL_PERF_MAP"))
+    {
+        std::string name = "/tmp/perf-" + std::to_string(getpid()) + ".map";
+        m_perf_map = std::fopen(name.c_str(), "a");
+    }
+}
+
+Jit::~Jit()
+{
+    if (m_thread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_wakeup.notify_one();
+        m_thread.join();
+    }
+
+    // Compiled but never installed
+    for (auto& job : m_results)
+        M_release(job.code);
+
+    for (auto& it : m_profiles)
+        M_release(it.second.code);
+
+    if (m_perf_map)
+        std::fclose(m_perf_map);
+}
+
+bool Jit::enabled()
+{
+#ifdef AXOLOTL_JIT_X86_64
+    static int enabled = -1;
+    if (enabled < 0)
+    {
+        char const* env = std::getenv("AXOLOTL_JIT");
+        enabled = !(env && std::string(env) == "0");
+    }
+    return enabled;
+#else
+    return false;
+#endif
+}
+
+JitProfile* Jit::profile(Module const& module, blob_symbol const* symbol)
+{
+    auto it = m_profiles.find(symbol);
+    if (it != m_profiles.end())
+        return &it->second;
+
+    JitProfile& profile = m_profiles[symbol];
+    profile.module = module;
+    profile.symbol = symbol;
+    profile.calls = 0;
+    profile.backedges = 0;
+    profile.failed = false;
+    profile.queued = false;
+    profile.code = nullptr;
+    return &profile;
+}
+
+void Jit::call(JitProfile* profile)
+{
+    M_install();
+
+    if (profile->code || profile->failed || profile->queued)
+        return;
+
+    if (++profile->calls >= HOT_CALLS)
+        M_request(profile);
+}
+
+void Jit::backEdge(JitProfile* profile)
+{
+    M_install();
+
+    if (profile->code || profile->failed || profile->queued)
+        return;
+
+    if (++profile->backedges >= HOT_BACKEDGES)
+        M_request(profile);
+}
+
+bool Jit::run(JitProfile* profile, int pc, int& status)
+{
+    JitCode* code = profile->code;
+    if (!code)
+        return false;
+
+    int rel = pc - code->start;
+    if (rel < 0 || rel >= (int) code->entries.size() || code->entries[rel] < 0)
+        return false;
+
+    typedef int (*Entry)(Engine*, uint8_t*);
+    int ret = ((Entry) code->base)(m_engine, code->base + code->entries[rel]);
+
+    status = ret == STOP ? STOP : CONTINUE;
+    return true;
+}
+
+void Jit::M_request(JitProfile* profile)
+{
+    Blob const& blob = profile->module.blob();
+    std::shared_ptr<Buffer> text = blob.text();
+    if (!text || !text->size())
+    {
+        profile->failed = true;
+        return;
+    }
+
+    // The function ends where the next one begins
+    int start = profile->symbol->s_addr;
+    int end = (int) text->size();
+    blob.foreachSymbol([&](blob_idx, blob_symbol const* sym)
+    {
+        if ((int) sym->s_addr > start && (int) sym->s_addr < end)
+            end = (int) sym->s_addr;
+    });
+
+    if (start < 0 || start >= end)
+    {
+        profile->failed = true;
+        return;
+    }
+
+    // Snapshot the engine's copy, which may already be quickened and
+    //   keeps being rewritten while the compiler thread works
+    uint8_t const* raw = text->view(0, text->size());
+    auto quick = m_engine->m_quick.find(profile->module.m_impl);
+    if (quick != m_engine->m_quick.end() && quick->second.code.size() == text->size())
+        raw = quick->second.code.data();
+
+    JitJob job;
+    job.profile = profile;
+    job.start = start;
+    job.constants = &profile->module.m_impl->constants;
+    job.code = nullptr;
+    job.text.assign(raw + start, raw + end);
+
+    profile->queued = true;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_requests.push_back(std::move(job));
+
+        if (!m_thread.joinable())
+            m_thread = std::thread(&Jit::M_worker, this);
+    }
+    m_wakeup.notify_one();
+}
+
+void Jit::M_install()
+{
+    if (!m_ready.load(std::memory_order_acquire))
+        return;
+
+    std::deque<JitJob> results;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        results.swap(m_results);
+        m_ready.store(false, std::memory_order_relaxed);
+    }
+
+    // Called between two instructions, no native code of these functions
+    //   is running yet
+    for (auto& job : results)
+    {
+        JitProfile* profile = job.profile;
+        profile->queued = false;
+        profile->code = job.code;
+        profile->failed = !job.code;
+
+        if (job.code)
+            M_perfMap(profile);
+    }
+}
+
+void Jit::M_worker()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    for (;;)
+    {
+        m_wakeup.wait(lock, [this] { return m_stop || !m_requests.empty(); });
+        if (m_stop)
+            break;
+
+        JitJob job = std::move(m_requests.front());
+        m_requests.pop_front();
+
+        lock.unlock();
+        job.code = M_compile(job);
+        lock.lock();
+
+        m_results.push_back(std::move(job));
+        m_ready.store(true, std::memory_order_release);
+    }
+}
+
+void Jit::M_release(JitCode* code)
+{
+    if (!code)
+        return;
+
+#ifdef AXOLOTL_JIT_X86_64
+    munmap(code->base, code->size);
+#endif
+    delete code;
+}
+
+JitCode* Jit::M_compile(JitJob const& job) const
+{
+#ifdef AXOLOTL_JIT_X86_64
+    if (!m_layout.valid)
+        return nullptr;
+
+    int start = job.start;
+    int end = start + (int) job.text.size();
+
+    uint8_t const* raw = job.text.data();
+    uint8_t const* raw_end = raw + job.text.size();
+
+    // Decode the whole function
+    std::vector<Instruction> instructions;
+    for (int pc = start; pc < end; )
+    {
+        Instruction insn;
+        std::size_t pos = pc - start;
+
+        insn.pc = pc;
+        insn.opcode = (Opcode) raw[pos++];
+        insn.operands[0] = insn.operands[1] = 0;
+
+        int nargs = opcode_nargs(insn.opcode);
+        if (nargs < 0 || nargs > 2)
+            return nullptr;
+
+        for (int i = 0; i < nargs; ++i)
+        {
+            if (!sleb128_decode(raw, pos, raw_end, insn.operands[i]))
+                return nullptr;
+        }
+
+        insn.next_pc = pc = start + (int) pos;
+        instructions.push_back(insn);
+    }
+
+    Helpers helpers;
+    helpers.step = reinterpret_cast<uint64_t>(&Jit::M_step);
+    helpers.drop = reinterpret_cast<uint64_t>(&Jit::M_drop);
+    helpers.push_int = reinterpret_cast<uint64_t>(&Jit::M_pushInt);
+    helpers.push_bool = reinterpret_cast<uint64_t>(&Jit::M_pushBool);
+    helpers.store_int = reinterpret_cast<uint64_t>(&Jit::M_storeInt);
+
+    Emitter em;
+    Translator translator(m_layout, helpers, em);
+    translator.setConstants(job.constants);
+
+    std::vector<std::pair<std::size_t, int>> jumps;
+    JitCode* code = new JitCode();
+    code->start = start;
+    code->entries.assign(end - start, -1);
+
+    // Entry stub : int entry(Engine* engine, uint8_t* at), the stack
+    //   stays aligned for the calls to the helpers
+    em.byte(0x53);                      // push rbx
+    em.bytes({ 0x41, 0x54 });           // push r12
+    em.bytes({ 0x41, 0x55 });           // push r13
+    em.bytes({ 0x41, 0x56 });           // push r14
+    em.bytes({ 0x41, 0x57 });           // push r15
+    em.bytes({ 0x48, 0x89, 0xFB });     // mov rbx, rdi
+    em.mem(true, { 0x8D }, R12, RBX, m_layout.stack); // lea r12, [rbx + stack]
+    em.bytes({ 0xFF, 0xE6 });           // jmp rsi
+
+    // Exit stub, status is in eax
+    std::size_t exit = em.pos();
+    em.bytes({ 0x41, 0x5F });           // pop r15
+    em.bytes({ 0x41, 0x5E });           // pop r14
+    em.bytes({ 0x41, 0x5D });           // pop r13
+    em.bytes({ 0x41, 0x5C });           // pop r12
+    em.byte(0x5B);                      // pop rbx
+    em.byte(0xC3);                      // ret
+
+    // Instructions are executed by the engine when they have no native
+    //   version, or when a guard of the native version fails (out of line)
+    std::vector<std::vector<std::size_t>> slow(instructions.size());
+    std::size_t region_end = 0;
+    for (std::size_t i = 0; i < instructions.size(); ++i)
+    {
+        Instruction const& insn = instructions[i];
+        Instruction const* next = i + 1 < instructions.size() ? &instructions[i + 1] : nullptr;
+        code->entries[insn.pc - start] = (int) em.pos();
+
+        // Integer expressions run unboxed, they fall back to the boxed
+        //   version of their instructions (which follows) if a guard fails.
+        //   Jumps into the middle of a region land in the boxed version.
+        Region region;
+        if (i >= region_end && translator.findRegion(instructions, i, start, end, region))
+        {
+            std::vector<std::size_t> bail;
+            translator.region(instructions, region, bail, jumps);
+            for (auto from : bail)
+                em.patch(from, em.pos());
+
+            region_end = region.last + 1;
+        }
+
+        std::size_t at = em.pos();
+        std::vector<std::pair<std::size_t, int>> branches;
+        if (translator.emit(insn, next, start, end, slow[i], branches))
+        {
+            jumps.insert(jumps.end(), branches.begin(), branches.end());
+            continue;
+        }
+
+        // Drop what may have been emitted before the translation gave up
+        em.truncate(at);
+        slow[i].clear();
+        translator.step(insn, exit, start, end, jumps);
+    }
+
+    // Falling off the function, let the interpreter complain
+    std::size_t fall_off = em.pos();
+    em.byte(0xB8);                      // mov eax, CONTINUE
+    em.imm32(CONTINUE);
+    em.patch(em.jmp(), exit);
+
+    for (std::size_t i = 0; i < instructions.size(); ++i)
+    {
+        if (slow[i].empty())
+            continue;
+
+        for (auto from : slow[i])
+            em.patch(from, em.pos());
+
+        Instruction const& insn = instructions[i];
+        translator.step(insn, exit, start, end, jumps);
+        if (insn.next_pc < end)
+            jumps.push_back(std::make_pair(em.jmp(), insn.next_pc));
+        else
+            em.patch(em.jmp(), fall_off);
+    }
+
+    for (auto const& jump : jumps)
+    {
+        if (code->entries[jump.second - start] < 0)
+        {
+            delete code;
+            return nullptr;
+        }
+
+        em.patch(jump.first, code->entries[jump.second - start]);
+    }
+
+    // Map the code in executable pages
+    code->size = em.pos();
+    void* base = mmap(nullptr, code->size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED)
+    {
+        delete code;
+        return nullptr;
+    }
+
+    std::memcpy(base, em.code().data(), code->size);
+    if (mprotect(base, code->size, PROT_READ | PROT_EXEC))
+    {
+        munmap(base, code->size);
+        delete code;
+        return nullptr;
+    }
+
+    code->base = (uint8_t*) base;
+    return code;
+#else
+    return nullptr;
+#endif
+}
+
+JitLayout Jit::M_layout(Engine* engine)
+{
+    JitLayout layout;
+    std::memset(&layout, 0, sizeof(layout));
+
+    auto offset = [](void const* field, void const* base)
+    { return (int32_t) ((uint8_t const*) field - (uint8_t const*) base); };
+
+    layout.stack = offset(&engine->m_stack, engine);
+    layout.locals_start = offset(&engine->m_locals_start, engine);
+    layout.locals_count = offset(&engine->m_locals_count, engine);
+    layout.argc = offset(&engine->m_argc, engine);
+
+    Object one(1);
+    Object two(2);
+    Object yes(true);
+
+    Object::Impl* impl = one.m_impl;
+    layout.data = offset(&impl->meta.m_data, impl);
+    layout.refcount = offset(&impl->refcount, impl);
+    layout.frozen = offset(&impl->frozen, impl);
+    layout.int_class = one.classid();
+    layout.int_members = impl->members.size();
+
+    Some::Base* int_data = impl->meta.m_data;
+    Some::Base* bool_data = yes.m_impl->meta.m_data;
+    if (!int_data || !bool_data || !two.m_impl->meta.m_data)
+        return layout;
+
+    // Values are tagged by the vtable of their holder
+    layout.int_tag = *(uint64_t const*) int_data;
+    layout.bool_tag = *(uint64_t const*) bool_data;
+
+    auto int_holder = static_cast<Some::Data<int>*>(int_data);
+    auto bool_holder = static_cast<Some::Data<bool>*>(bool_data);
+    layout.int_value = offset(&int_holder->get(), int_data);
+    layout.bool_value = offset(&bool_holder->get(), bool_data);
+
+    // The translator relies on these shapes
+    std::vector<Object> stack;
+    stack.reserve(4);
+    stack.push_back(one);
+    void* const* words = (void* const*) &stack;
+
+    layout.valid =
+        sizeof(Object) == OBJECT_SIZE &&
+        offset(&one.m_weak, &one) == OBJECT_WEAK &&
+        offset(&one.m_impl, &one) == OBJECT_IMPL &&
+        sizeof(one.m_weak) == 1 &&
+        sizeof(impl->frozen) == 1 &&
+        sizeof(impl->refcount) == 4 &&
+        sizeof(stack) == 3 * sizeof(void*) &&
+        words[VECTOR_BEGIN / 8] == stack.data() &&
+        words[VECTOR_END / 8] == stack.data() + 1 &&
+        words[VECTOR_CAPACITY / 8] == stack.data() + 4 &&
+        (void*) int_holder == (void*) int_data &&
+        (void*) bool_holder == (void*) bool_data &&
+        layout.int_tag == *(uint64_t const*) two.m_impl->meta.m_data &&
+        layout.int_tag != layout.bool_tag;
+
+    return layout;
+}
+
+void Jit::M_perfMap(JitProfile* profile)
+{
+    if (!m_perf_map)
+        return;
+
+    std::string name = profile->module.blob().string(profile->symbol->s_name);
+    std::fprintf(m_perf_map, "%lx %lx axolotl:%s.%s\n",
+                 (unsigned long) profile->code->base, (unsigned long) profile->code->size,
+                 profile->module.name().c_str(), name.c_str());
+    std::fflush(m_perf_map);
+}
+
+int Jit::M_step(Engine* engine, int opcode, int op0, int op1, int pc, int next_pc)
+{
+    engine->m_ir = (Opcode) opcode;
+    engine->m_ir_pc = pc;
+    engine->m_pc = next_pc;
+
+    int nargs = engine->m_opcodes_nargs[opcode];
+    engine->m_operands.clear();
+    if (nargs > 0)
+        engine->m_operands.push_back(op0);
+    if (nargs > 1)
+        engine->m_operands.push_back(op1);
+
+    if (!engine->M_run())
+        return STOP;
+
+    if (engine->m_pc == next_pc)
+        return STEP_NEXT;
+
+    switch (opcode)
+    {
+        case JMP_IF_FALSE:
+        case JMP_IF_TRUE:
+        case JMPR_IF_FALSE:
+        case JMPR_IF_TRUE:
+        case GUARD_SYMBOL:
+            return STEP_BRANCH;
+
+        default:
+            return CONTINUE;
+    }
+}
+
+void Jit::M_drop(Object::Impl* impl)
+{
+    // Native code left the last reference on the instance, the object
+    //   handing it over collects it when it goes out of scope
+    Object last = Object::nil();
+    last.M_decref();
+    last.m_weak = false;
+    last.m_impl = impl;
+}
+
+void Jit::M_storeInt(Engine* engine, int index, int value)
+{
+    Object& local = engine->m_stack[engine->m_locals_start + index];
+    Object::Impl* impl = local.m_impl;
+    JitLayout const& layout = engine->m_jit->m_layout;
+
+    // An integer only this local refers to is updated in place, nothing
+    //   can tell it from a new one (weak references to it would dangle)
+    if (!local.m_weak && impl->refcount == 1 && !impl->frozen && !impl->overridden &&
+        impl->meta.m_data && impl->meta.m_data->refcount == 1 && impl->meta.is<int>() &&
+        impl->the_class.classid() == layout.int_class && impl->members.size() == layout.int_members)
+    {
+        static_cast<Some::Data<int>*>(impl->meta.m_data)->get() = value;
+        return;
+    }
+
+    local = Object(value);
+}
+
+void Jit::M_pushInt(Engine* engine, int value)
+{
+    engine->M_push(Object(value));
+}
+
+void Jit::M_pushBool(Engine* engine, int value)
+{
+    engine->M_push(Object((bool) value));
+}
@@ -19,9 +19,11 @@
 #include "vm/engine.hpp"
 #include "vm/import_table.hpp"
 #include "lang/std_names.hpp"
+#include "lang/std_atoms.hpp"
 #include "lang/lang.hpp"
 
 #include <fstream>
+#include <cstring>
 
 using namespace vm;
 using namespace bits;
@@ -38,6 +40,7 @@ Module::Module(Blob const& blob, ImportTable* import_table)
     m_impl->refcount = 1;
     m_impl->blob = blob;
     m_impl->name = m_impl->blob.moduleName();
+    m_impl->blob_constants = 0;
     m_impl->engine = nullptr;
     m_impl->init_called = false;
 
@@ -52,6 +55,7 @@ Module::Module(std::string const& name, ImportTable* import_table)
 {
     m_impl->refcount = 1;
     m_impl->name = name;
+    m_impl->blob_constants = 0;
     m_impl->engine = nullptr;
     m_impl->init_called = false;
 
@@ -90,17 +94,22 @@ std::string const& Module::name() const
     return m_impl->name;
 }
 
-Object& Module::global(std::string const& name)
+Object& Module::global(Atom const& name)
 {
     if (!m_impl)
     {
         throw core::InternalError("vm::Module::global: access to empty module");
     }
     
+    auto it = m_impl->globals.find(name);
+    if (it != m_impl->globals.end())
+        return it->second;
+
+    M_materialize(name);
     return m_impl->globals[name];
 }
 
-Object Module::global(std::string const& name) const
+Object Module::global(Atom const& name) const
 {
     if (!m_impl)
     {
@@ -110,11 +119,70 @@ Object Module::global(std::string const& name) const
     auto it = m_impl->globals.find(name);
     if (it == m_impl->globals.end())
     {
-        throw NoGlobalError(*this, name);
+        if (!M_materialize(name))
+        {
+            throw NoGlobalError(*this, name.name());
+        }
+
+        it = m_impl->globals.find(name);
     }
     return it->second;
 }
 
+Atom Module::atom(blob_off offset) const
+{
+    if (!m_impl)
+    {
+        throw core::InternalError("vm::Module::atom: access to empty module");
+    }
+
+    auto it = m_impl->atoms.find(offset);
+    if (it != m_impl->atoms.end())
+        return it->second;
+
+    std::string str;
+    if (!m_impl->blob.string(offset, str))
+    {
+        throw core::InternalError("vm::Module::atom: invalid string index");
+    }
+
+    Atom atom(str);
+    m_impl->atoms[offset] = atom;
+    return atom;
+}
+
+Class::Id Module::methodClass(blob_idx symidx) const
+{
+    if (!m_impl)
+    {
+        throw core::InternalError("vm::Module::methodClass: access to empty module");
+    }
+
+    if (m_impl->method_classes.empty())
+    {
+        m_impl->blob.foreachTypeSpec([&](blob_idx tsidx, blob_typespec const* tspec)
+        {
+            std::string type_name;
+            if (!m_impl->blob.string(tspec->ts_name, type_name))
+            {
+                throw core::InternalError("vm::Module::methodClass: invalid type specification");
+            }
+
+            Class::Id classid = Class::hashId(m_impl->name, type_name);
+            m_impl->blob.foreachTypeSpecSymbol(tsidx, [&](blob_idx idx)
+            {
+                if (idx >= m_impl->method_classes.size())
+                    m_impl->method_classes.resize(idx + 1, 0);
+                m_impl->method_classes[idx] = classid;
+            });
+        });
+    }
+
+    if (symidx >= m_impl->method_classes.size())
+        return 0;
+    return m_impl->method_classes[symidx];
+}
+
 int Module::addConstant(Object value)
 {
     if (!m_impl)
@@ -122,7 +190,13 @@ int Module::addConstant(Object value)
         throw core::InternalError("vm::Module::addConstant: access to empty module");
     }
     
+    // Constants are shared by every LOAD_CONST, the engine
+    //   thaws them before they can be mutated
+    if (!value.isNil())
+        value.freeze();
+
     m_impl->constants.push_back(value);
+    m_impl->constants_loaded.push_back(true);
     return (int) m_impl->constants.size() - 1;
 }
 
@@ -138,6 +212,22 @@ Object Module::constant(int index) const
         throw core::InternalError("vm::Module::global: constant access out of bounds");
     }
 
+    if (!m_impl->constants_loaded[index])
+    {
+        blob_constant const* cst = m_impl->blob.constant((blob_idx) (index - m_impl->blob_constants));
+        if (!cst)
+        {
+            throw core::InternalError("vm::Module::constant: invalid constant");
+        }
+
+        Object value = M_makeConstant(cst);
+        if (!value.isNil())
+            value.freeze();
+
+        m_impl->constants[index] = value;
+        m_impl->constants_loaded[index] = true;
+    }
+
     return m_impl->constants[index];
 }
 
@@ -149,8 +239,11 @@ void Module::setBlob(Blob const& blob)
     }
     
     m_impl->blob = blob;
-    m_impl->blob.setModuleName(m_impl->name);
+    m_impl->atoms.clear();
+    m_impl->method_classes.clear();
 
+    // Nothing is built here: functions, classes and constants are
+    //   materialized the first time they are accessed
     M_processSymbols();
     M_processTypeSpecs();
     M_processConstants();
@@ -225,15 +318,12 @@ void Module::exportTo(Module& to, std::string const& mask, std::string const& al
         throw core::InternalError("vm::Module::exportTo: can't export module to itself");
     }
 
-    for (auto& it : m_impl->globals)
+    auto external_name = [&](std::string const& sym_name, std::string& ext_name)
     {
-        std::string sym_name = it.first;
-        std::string ext_name;
-
         if (sym_name.size() && sym_name[0] == '_')
-            continue;
+            return false;
 
-        if (it.first == std_main)
+        if (sym_name == std_main)
             ext_name = alias + "." + sym_name;
         else
         {
@@ -244,23 +334,65 @@ void Module::exportTo(Module& to, std::string const& mask, std::string const& al
             else
             {
                 if (sym_name != mask)
-                    continue;
+                    return false;
 
                 ext_name = sym_name;
             }
         }
 
-        // Don't check for clashes
-        to.global(ext_name) = it.second;
-        //FIXME: WTF?
-        to.global("@" + m_impl->name + "." + sym_name) = it.second;
+        return true;
+    };
 
+    auto exported = [&](std::string const& ext_name, std::string const& sym_name)
+    {
         if (!extra.isNil())
         {
             extra(ext_name);
             //FIXME: WTF?
             extra("@" + m_impl->name + "." + sym_name);
         }
+    };
+
+    for (auto& it : m_impl->globals)
+    {
+        std::string const& sym_name = it.first.name();
+        std::string ext_name;
+        if (!external_name(sym_name, ext_name))
+            continue;
+
+        // Don't check for clashes
+        Atom ext_atom(ext_name);
+        to.m_impl->lazy_globals.erase(ext_atom);
+        to.global(ext_atom) = it.second;
+        //FIXME: WTF?
+        Atom private_atom("@" + m_impl->name + "." + sym_name);
+        to.m_impl->lazy_globals.erase(private_atom);
+        to.global(private_atom) = it.second;
+
+        exported(ext_name, sym_name);
+    }
+
+    // Globals which were not materialized yet stay lazy in the
+    //   importing module, they are built by (and shared with) this one
+    Module self = *this;
+    for (auto& it : m_impl->lazy_globals)
+    {
+        std::string const& sym_name = it.first.name();
+        std::string ext_name;
+        if (!external_name(sym_name, ext_name))
+            continue;
+
+        LazyGlobal resolve = it.second;
+        LazyGlobal stub = [self, resolve]() { return resolve(); };
+
+        Atom ext_atom(ext_name);
+        to.m_impl->globals.erase(ext_atom);
+        to.m_impl->lazy_globals[ext_atom] = stub;
+        Atom private_atom("@" + m_impl->name + "." + sym_name);
+        to.m_impl->globals.erase(private_atom);
+        to.m_impl->lazy_globals[private_atom] = stub;
+
+        exported(ext_name, sym_name);
     }
 }
 
@@ -283,13 +415,21 @@ void Module::init()
     
     if (!initCalled())
     {
-        auto it = m_impl->globals.find(std_main);
-        if (it != m_impl->globals.end())
-            it->second();
+        auto it = m_impl->globals.find(std_main_atom);
+        if (it != m_impl->globals.end() || M_materialize(std_main_atom))
+            m_impl->globals[std_main_atom]();
         m_impl->init_called = true;
     }
 }
 
+Module Module::M_fromImpl(Impl* impl)
+{
+    Module module;
+    module.m_impl = impl;
+    module.M_incref();
+    return module;
+}
+
 void Module::M_incref()
 {
     if (m_impl)
@@ -305,6 +445,8 @@ void Module::M_decref()
     {
         // std::cout << "[" << m_impl << "]-- " << m_impl->refcount << std::endl;
 
+        if (m_impl->engine)
+            m_impl->engine->release(m_impl);
         if (m_impl->import_table)
             delete m_impl->import_table;
         delete m_impl;
@@ -314,69 +456,146 @@ void Module::M_decref()
 
 void Module::M_processSymbols()
 {
-    m_impl->blob.foreachSymbol([&](blob_idx, blob_symbol* sym)
+    Impl* impl = m_impl;
+
+    m_impl->blob.foreachSymbol([&](blob_idx, blob_symbol const* sym)
     {
         if (sym->s_bind == BLOB_SYMB_GLOBAL)
         {
-            std::string name;
-            if (!m_impl->blob.string(sym->s_name, name))
-            {
-                throw core::InternalError("vm::Module::M_processSymbols: invalid symbol");
-            }
+            Atom name = atom(sym->s_name);
 
-            if (m_impl->globals.find(name) != m_impl->globals.end())
+            if (m_impl->globals.find(name) != m_impl->globals.end() ||
+                m_impl->lazy_globals.find(name) != m_impl->lazy_globals.end())
             {
-                throw core::InternalError("vm::Module::M_processSymbols: symbol \'" + name + "' redefined");
+                throw core::InternalError("vm::Module::M_processSymbols: symbol \'" + name.name() + "' redefined");
             }
 
-            m_impl->globals[name] = M_makeFunction(sym);
+            // The cell is shared with the modules this global is exported to
+            std::shared_ptr<Object> cell = std::make_shared<Object>();
+            m_impl->lazy_globals[name] = [impl, sym, cell]()
+            {
+                if (cell->isNil())
+                    *cell = M_fromImpl(impl).M_makeFunction(sym);
+                return *cell;
+            };
         }
     });
 }
 
 void Module::M_processTypeSpecs()
 {
-    m_impl->blob.foreachTypeSpec([&](blob_idx tidx, blob_typespec* tspec)
+    Impl* impl = m_impl;
+
+    m_impl->blob.foreachTypeSpec([&](blob_idx tidx, blob_typespec const* tspec)
     {
-        std::string type_name;
-        if (!m_impl->blob.string(tspec->ts_name, type_name))
+        Atom type_name = atom(tspec->ts_name);
+
+        std::shared_ptr<Object> cell = std::make_shared<Object>();
+        m_impl->globals.erase(type_name);
+        m_impl->lazy_globals[type_name] = [impl, tidx, cell]()
         {
-            throw core::InternalError("vm::Module::M_processTypeSpecs: invalid type specification");
-        }
+            if (cell->isNil())
+                *cell = M_fromImpl(impl).M_makeClass(tidx);
+            return *cell;
+        };
+    });
+}
 
-        Class c(m_impl->name, type_name, true);
+void Module::M_processConstants()
+{
+    // Constants are decoded by Module::constant
+    m_impl->blob_constants = m_impl->constants.size();
+    m_impl->constants.resize(m_impl->blob_constants + m_impl->blob.constantCount());
+    m_impl->constants_loaded.resize(m_impl->constants.size(), false);
+}
 
-        m_impl->blob.foreachTypeSpecSymbol(tidx, [&](blob_idx symidx)
-        {
-            blob_symbol* sym = m_impl->blob.symbol(symidx);
+bool Module::M_materialize(Atom const& name) const
+{
+    auto it = m_impl->lazy_globals.find(name);
+    if (it == m_impl->lazy_globals.end())
+        return false;
 
-            std::string name;
-            if (!sym || !m_impl->blob.string(sym->s_name, name) ||
-                sym->s_type != BLOB_SYMT_METHOD)
-            {
-                throw core::InternalError("vm::Module::M_processTypeSpecs: invalid symbol");
-            }
+    // The entry is removed first, as building it may access other globals
+    LazyGlobal resolve = it->second;
+    m_impl->lazy_globals.erase(it);
 
-            c.addMember(name, M_makeFunction(sym));
-        });
-        
-        m_impl->globals[type_name] = c;
-    });
+    m_impl->globals[name] = resolve();
+    return true;
 }
 
-void Module::M_processConstants()
+Object Module::M_makeFunction(blob_symbol const* symbol) const
+{ return Callable(Function(*this, symbol)); }
+
+Object Module::M_makeClass(blob_idx tsidx) const
 {
-    m_impl->blob.foreachConstant([&](blob_idx, blob_constant* cst)
+    blob_typespec const* tspec = m_impl->blob.typeSpec(tsidx);
+
+    std::string type_name;
+    if (!tspec || !m_impl->blob.string(tspec->ts_name, type_name))
+    {
+        throw core::InternalError("vm::Module::M_makeClass: invalid type specification");
+    }
+
+    Class c(m_impl->name, type_name, true);
+
+    m_impl->blob.foreachTypeSpecSymbol(tsidx, [&](blob_idx symidx)
     {
-        std::string serialized;
-        if (!m_impl->blob.string(cst->c_serialized, serialized))
+        blob_symbol const* sym = m_impl->blob.symbol(symidx);
+
+        if (!sym || sym->s_type != BLOB_SYMT_METHOD)
         {
-            throw core::InternalError("vm::Module::M_processConstants: invalid constant");
+            throw core::InternalError("vm::Module::M_makeClass: invalid symbol");
         }
-        
-        addConstant(class_from_classid(cst->c_classid).unserialize(serialized));
+
+        c.addMember(atom(sym->s_name), M_makeFunction(sym));
     });
+
+    return c;
 }
 
-Object Module::M_makeFunction(blob_symbol* symbol) const
-{ return Callable(Function(*this, symbol)); }
+Object Module::M_makeConstant(blob_constant const* cst) const
+{
+    switch (cst->c_kind)
+    {
+        case BLOB_CST_INT:
+            return (int) (int64_t) cst->c_value;
+
+        case BLOB_CST_ULONG:
+            return (std::size_t) cst->c_value;
+
+        case BLOB_CST_FLOAT:
+        {
+            uint32_t bits = (uint32_t) cst->c_value;
+            float value;
+            std::memcpy(&value, &bits, sizeof(float));
+            return value;
+        }
+
+        case BLOB_CST_BOOL:
+            return cst->c_value != 0;
+
+        case BLOB_CST_CHAR:
+            return (char) cst->c_value;
+
+        case BLOB_CST_STRING:
+        case BLOB_CST_SERIALIZED:
+        {
+            std::string str;
+            if (!m_impl->blob.string((blob_off) cst->c_value, str))
+            {
+                throw core::InternalError("vm::Module::M_makeConstant: invalid constant");
+            }
+
+            if (cst->c_kind == BLOB_CST_STRING)
+                return str;
+
+            return class_from_classid(cst->c_classid).unserialize(str);
+        }
+
+        default:
+            break;
+    }
+
+    throw core::InternalError("vm::Module::M_makeConstant: invalid constant kind");
+    // throw std::runtime_error("vm::Module::M_makeConstant: invalid constant kind");
+}